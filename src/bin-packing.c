@@ -30,22 +30,184 @@
  *    - [arg 6] : Segundo item da lista de números.
  *    - [arg 7] : Terceiro item da lista de números.
  *    - [arg N] : Enésimo item da lista de números.
+ *
+ * Itens que precisam ficar no mesmo BIN podem ser informados juntos, unidos por '+'
+ * (<tt>10+20+5</tt>). Cada grupo é empacotado como um único número, com a soma dos
+ * seus itens, e é expandido novamente na impressão dos BINs.
+ *
+ * Itens que só podem ir para certas classes de BIN (zonas, por exemplo) informam as
+ * classes permitidas depois de '@' (<tt>30@0,2</tt>). Cada BIN pertence a uma classe,
+ * a do primeiro item colocado nele (a primeira classe permitida do item, ou 0 para itens
+ * sem restrição), e cada item vai para o primeiro BIN de uma classe permitida onde cabe.
+ *
+ * Itens com '+' ou '@' são empacotados apenas pelo FFD e não podem ser combinados com
+ * as opções -S, -f, -c, -o, -M, -X, -p, -m, -a, -l, -H ou -q.
  * 
+ * Opções do programa (informadas antes dos parâmetros acima):
+ *
+ *    - <tt>-S lista</tt> : Modo de varredura. Em vez de empacotar com um único BIN_SIZE,
+ *                avalia todas as capacidades da lista e imprime a curva BINs x capacidade.
+ *                A lista pode ser separada por vírgulas (<tt>80,90,100</tt>) ou um
+ *                intervalo <tt>inicio:fim:passo</tt> (<tt>50:150:5</tt>).
+ *    - <tt>-r</tt>     : Imprime cada BIN assim que ele não pode mais receber nenhum número,
+ *                liberando seus itens da memória antes do fim do empacotamento. Não
+ *                tem efeito junto com -H ou -q, que precisam de todos os BINs.
+ *    - <tt>-b</tt>     : Modo em lote. Lê da entrada padrão uma instância por linha, no formato
+ *                <tt>BIN_SIZE item item ...</tt>, dispensando os parâmetros acima. As
+ *                instâncias são processadas em sequência e a memória usada por uma é
+ *                reaproveitada pelas seguintes.
+ *    - <tt>-a eps</tt> : Esquema de aproximação assintótica. Os números maiores que eps * BIN_SIZE
+ *                são agrupados linearmente em poucas classes de tamanho, a instância
+ *                arredondada é resolvida por enumeração de padrões e os números pequenos
+ *                são encaixados no final. Imprime a distância para o limite inferior.
+ *    - <tt>-f</tt>     : Itens fracionáveis. Os BINs são preenchidos exatamente até BIN_SIZE,
+ *                dividindo um item entre dois BINs quando necessário, com o menor número de
+ *                divisões possível. Informando <tt>-</tt> no lugar dos itens, os tamanhos são
+ *                lidos da entrada padrão sem serem guardados, apenas contados.
+ *    - <tt>-M N</tt>   : Executa N partidas do "First Fit" em paralelo, cada uma sobre uma
+ *                perturbação aleatória da ordem decrescente (trocas entre números quase
+ *                iguais), e imprime a melhor. A partida zero é o FFD sem perturbação.
+ *    - <tt>-s seed</tt>: Semente dos modos aleatórios. A mesma semente produz sempre o mesmo
+ *                resultado, independente da quantidade de threads.
+ *    - <tt>-q</tt>     : Depois de empacotar, lê consultas da entrada padrão, uma por linha, e
+ *                responde cada uma em tempo logarítmico usando o fit_index:
+ *                   - <tt>f</tt>: maior item que ainda cabe em algum BIN;
+ *                   - <tt>c s</tt>: quantidade de BINs com espaço restante maior ou igual a s;
+ *                   - <tt>r a b</tt>: espaço livre total dos BINs com espaço restante entre a e b;
+ *                   - <tt>w s</tt>: BIN em que um item de tamanho s seria colocado (-1 se nenhum);
+ *                   - <tt>i s</tt>: insere um item de tamanho s, abrindo um BIN se necessário.
+ *    - <tt>-l N</tt>   : Depois do empacotamento, move ou troca itens entre o BIN mais cheio e o
+ *                mais vazio para igualar o espaço restante, sem aumentar a quantidade de
+ *                BINs, até N movimentos ou até não haver melhora.
+ *    - <tt>-c</tt>     : Empacotamento online concorrente. Os números, na ordem em que foram
+ *                informados, são divididos entre as threads, que os inserem ao mesmo tempo
+ *                no mesmo conjunto de BINs, reservando espaço com compare-and-swap.
+ *    - <tt>-T arq</tt> : Converte eventos em texto, lidos da entrada padrão, para o trace binário
+ *                arq. A primeira linha é <tt>c BIN_SIZE</tt> e as demais são chegadas
+ *                <tt>a id tamanho [us]</tt> ou saídas <tt>d id [us]</tt>, onde us é o tempo, em
+ *                microssegundos, desde o evento anterior.
+ *    - <tt>-R arq</tt> : Reproduz o trace arq no empacotamento online dinâmico ("First Fit" sobre
+ *                o fit_index, com saídas liberando espaço) e imprime a latência de cada tipo
+ *                de operação em percentis e a quantidade de BINs. Com <tt>-t</tt>, respeita os
+ *                tempos gravados em vez de reproduzir o mais rápido possível.
+ *    - <tt>-o k[,ms]</tt>: Modo semi-online. Os números chegam na ordem informada e são
+ *                guardados até k itens (ou até o mais antigo esperar ms milissegundos); então
+ *                são ordenados de forma decrescente e colocados pelo "First Fit" nos BINs já
+ *                abertos. Com k = 1 é o "First Fit" online; quanto maior k, mais perto do FFD,
+ *                ao custo de mais espera. Informando <tt>-</tt> no lugar dos itens, os tamanhos
+ *                são lidos da entrada padrão à medida que chegam.
+ *    - <tt>-D ms</tt>  : Prazo, contado desde o início do programa, para os modos que
+ *                melhoram uma solução (<tt>-M</tt>, <tt>-l</tt>, <tt>-a</tt> e <tt>-S</tt>).
+ *                Vencido o prazo, cada um para e entrega a melhor solução que tinha; cada
+ *                melhora encontrada é impressa com o tempo em que ocorreu.
+ *    - <tt>-E nome</tt>: Motor usado pelo FFD. Todos geram exatamente os mesmos BINs, mudando
+ *                apenas o tempo:
+ *                   - <tt>linear</tt>: percorre a cadeia de BINs ativos (fill_bins_generic);
+ *                   - <tt>block</tt>: percorre um array de espaços restantes em blocos sem
+ *                     desvios, vetorizados pelo compilador;
+ *                   - <tt>tree</tt>: busca o primeiro BIN com espaço no fit_index, em tempo
+ *                     logarítmico;
+ *                   - <tt>histogram</tt>: coloca todos os números de um mesmo tamanho de uma vez;
+ *                   - <tt>bucket</tt>: agrupa os BINs em baldes com o maior espaço restante de
+ *                     cada um e percorre só os baldes e os BINs do primeiro que comporta o número;
+ *                   - <tt>auto</tt>: (padrão) escolhe pelo menor custo estimado a partir da
+ *                     quantidade de números, de tamanhos distintos e de BINs esperados.
+ *    - <tt>-C</tt>     : Mede os motores em instâncias sintéticas e grava o custo de cada um no
+ *                arquivo de calibração (<tt>bin-packing.conf</tt>, ou o informado na variável
+ *                de ambiente BIN_PACKING_CONFIG), usado depois pela escolha automática.
+ *    - <tt>-X</tt>     : Solução exata por "improved bin completion" (Korf; Schreiber e Korf).
+ *                Parte do FFD como limite superior e do maior entre ceil(soma / BIN_SIZE) e
+ *                o limite L2 de Martello e Toth como inferior, e testa cada quantidade de
+ *                BINs entre eles preenchendo um BIN por vez. Com <tt>-D</tt>, ao vencer o
+ *                prazo imprime a melhor solução conhecida, indicando que não foi provada ótima.
+ *                Com <tt>-j N</tt> maior que 1, a busca é dividida entre N threads por roubo de
+ *                trabalho, com a melhor solução e a tabela de nogoods compartilhadas.
+ *    - <tt>-g p</tt>   : Empacotamento estocástico. Cada item é informado como <tt>media:variancia</tt>
+ *                (<tt>30:16</tt>; sem ':' a variância é zero), ou lido assim da entrada padrão
+ *                com '-'; sem itens, as médias são aleatórias e a variância igual à média. Os
+ *                tamanhos são tratados como normais independentes, e um item cabe no BIN
+ *                enquanto soma das médias + z·sqrt(soma das variâncias) <= BIN_SIZE, com z
+ *                tal que a probabilidade de transbordar o BIN seja no máximo p (0 < p <= 0.5).
+ *    - <tt>-K N</tt>   : Mochila múltipla: há apenas N BINs e nem todo item precisa ser colocado.
+ *                Cada item é informado como <tt>tamanho:valor</tt> (sem ':' o valor é o
+ *                tamanho), ou lido assim da entrada padrão com '-'; sem itens, tamanhos e
+ *                valores são aleatórios entre mínimo e máximo. Maximiza a soma dos valores
+ *                colocados: guloso por densidade (valor / tamanho), reparo por trocas com
+ *                itens de fora e, com um orçamento limitado, programação dinâmica por BIN.
+ *    - <tt>-H cap[,slots[,c]]</tt>: Empacotamento em dois níveis. Os BINs gerados viram itens
+ *                de um segundo empacotamento em racks de capacidade \em cap, cada BIN pesando
+ *                o quanto foi ocupado, com no máximo \em slots BINs por rack. Com \em c, os dois
+ *                níveis são otimizados juntos: enquanto houver mais racks que o limite
+ *                inferior, tenta-se esvaziar o último rack movendo itens para BINs de outros
+ *                racks e, depois, BINs inteiros. A saída lista os BINs dentro de cada rack.
+ *    - <tt>-w arq</tt> : Com -H, grava os racks em arq no formato binário descrito em write_racks.
+ *    - <tt>-x N</tt>   : Tamanhos fracionários em ponto fixo. BIN_SIZE, mínimo, máximo e itens
+ *                são lidos como decimais (por exemplo, <tt>1 0.37 0.25</tt>) e multiplicados
+ *                por N de forma exata, sem ponto flutuante. Os itens são arredondados para
+ *                cima e o BIN_SIZE para baixo, então todo empacotamento continua válido para os
+ *                tamanhos reais; o erro de arredondamento é impresso antes do empacotamento.
+ *    - <tt>-m</tt>     : Armazenamento compacto. Os itens de todos os BINs ficam em um único
+ *                pool, empacotados em bits com a menor largura que comporta o BIN_SIZE (7 bits
+ *                para BIN_SIZE até 127, 8 até 255 etc.), e cada BIN guarda apenas onde os seus
+ *                itens começam. Ao final, imprime a memória usada pelo pool. A compactação
+ *                vale para o resultado: durante o empacotamento, o motor do FFD usa os mesmos
+ *                arrays de 16 bits dos outros modos.
+ *    - <tt>-p</tt>     : Imprime os itens de cada BIN com a sua posição na entrada
+ *                (<tt>tamanho\#posição</tt>) e, ao final, o BIN de cada item na ordem da entrada.
+ *    - <tt>-j N</tt>   : Quantidade de threads utilizadas pelos modos paralelos. Por padrão
+ *                usa-se a quantidade de processadores disponíveis.
+ *
  * Exemplos de uso:
  *    - <tt>./bin-packing.o 2000 100 20 100</tt>
  *    - <tt>./bin-packing.o 2000 100 20 100 1 2 3 4 5 6 7 8 9 10 12 13 14 15 17</tt>
+ *    - <tt>./bin-packing.o 0 100 0 0 30+20 50 10+10+10 70</tt>
+ *    - <tt>./bin-packing.o -f 0 100 0 0 - < itens.txt</tt>
+ *    - <tt>./bin-packing.o -S 100:200:10 -j 4 2000 100 20 100</tt>
+ *
+ * Compilação: <tt>gcc -O2 bin-packing.c -o bin-packing.o -lm -lpthread</tt>
+ *
+ * Compilado com <tt>-DBIN_PACKING_NO_MAIN</tt>, o arquivo não tem a função main nem as
+ * variáveis globais e funções dos modos, e pode ser ligado a outros programas, que usam a
+ * interface de bin-packing.h (C) ou de bin-packing.hpp (C++); apenas as funções dessa
+ * interface são exportadas.
+ *
+ * Para firmwares em que o tamanho do BIN é sempre o mesmo, compilar com
+ * <tt>-DBIN_SIZE_FIXED=N</tt> gera uma versão de fill_bins especializada para essa
+ * capacidade, escolhida automaticamente quando o BIN_SIZE informado for N.
  *
  *  \author Rocha, Joel (joelxr@gmail.com)
  *  \author Santos, Luciente dos (lucienesantosmc@gmail.com)
  *  \date 2013-11-13
  *  \copyright GPLv2
  */
+/** getopt, getline, clock_gettime e clock_nanosleep são POSIX, fora do C padrão. */
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <poll.h>
+#include <sched.h>
 #include <sys/timeb.h>
 
+#include "bin-packing.h"
+
+/** Sub-faixas por potência de dois do histograma de latência */
+#define LATENCY_SUB_BUCKETS 16
+/** Quantidade de faixas do histograma de latência, suficiente para 64 bits */
+#define LATENCY_BUCKETS (64 * LATENCY_SUB_BUCKETS)
+/** Busca exata paralela: posições de cada deque, potência de dois */
+#define EXACT_DEQUE_SIZE 64
+/** Faixas de variância dos itens no índice do modo estocástico */
+#define STOCHASTIC_BUCKETS 16
+/** Pi, já que M_PI não faz parte do C padrão */
+#define BP_PI 3.14159265358979323846
+
 /** 
  * Estrutra que representa um BIN
  */
@@ -65,6 +227,410 @@ typedef struct bin_list
    unsigned short int count; /** Representa a quantidade de BINs existentes na lista */
 } bin_list;
 
+/**
+ * Histograma dos números já ordenados: cada tamanho distinto aparece uma única vez,
+ * acompanhado da quantidade de números com esse tamanho. Os tamanhos ficam em ordem
+ * decrescente, assim como em \em values.
+ */
+typedef struct size_histogram
+{
+   unsigned short int *sizes; /** Tamanhos distintos, em ordem decrescente */
+   unsigned int *counts; /** Quantidade de números de cada tamanho */
+   unsigned short int distinct; /** Quantidade de tamanhos distintos */
+   unsigned long int total; /** Soma de todos os números */
+} size_histogram;
+
+/**
+ * Área de trabalho reaproveitada entre instâncias no modo em lote. Todos os arrays têm
+ * espaço para \em capacity números (e, portanto, para \em capacity BINs), os itens de
+ * todos os BINs ficam em um único \em pool e nada é liberado entre uma instância e
+ * outra: basta sobrescrever. Os arrays só crescem quando chega uma instância maior e
+ * são reduzidos a cada WORKSPACE_TRIM_WINDOW instâncias caso o pico da janela tenha
+ * ficado bem abaixo da capacidade.
+ */
+typedef struct workspace
+{
+   unsigned short int *values; /** Números da instância atual */
+   unsigned short int *bin_of; /** BIN escolhido para cada número */
+   unsigned short int *left; /** Espaço restante de cada BIN */
+   int *next; /** Cadeia de BINs ativos usada por first_fit_assign */
+   unsigned short int *pool; /** Itens de todos os BINs, agrupados por BIN */
+   bin *bins; /** BINs da instância atual, apontando para dentro do \em pool */
+   uint32_t *records; /** Registros do radix sort, 2 * (\em capacity + 1) posições */
+   unsigned int capacity; /** Quantidade de números que os arrays comportam */
+   unsigned int peak; /** Maior instância vista na janela atual */
+   unsigned short int instances; /** Instâncias processadas na janela atual */
+} workspace;
+
+/**
+ * Erro acumulado ao converter os itens fracionários para inteiros (opção -x). Os erros
+ * ficam em unidades da escala, isto é, 1 equivale a 1/N do tamanho original.
+ */
+typedef struct rounding_error
+{
+   double total; /** Soma dos erros de todos os itens */
+   double largest; /** Maior erro de um item */
+   double exact; /** Soma dos tamanhos exatos, antes do arredondamento */
+   unsigned int rounded; /** Itens que não eram múltiplos exatos de 1/N */
+   unsigned int items; /** Itens convertidos */
+} rounding_error;
+
+/**
+ * BINs em armazenamento compacto (opção -m). Os itens de todos os BINs ficam em \em bytes,
+ * BIN após BIN, cada um com \em width bits, do bit menos significativo para o mais
+ * significativo de cada byte. Cada BIN guarda só a posição do seu primeiro item; a
+ * quantidade vem da posição do BIN seguinte e o espaço restante é calculado na leitura.
+ */
+typedef struct packed_pool
+{
+   unsigned char *bytes; /** Itens empacotados, com dois bytes a mais para leituras de três bytes */
+   unsigned short int *start; /** Primeiro item de cada BIN; start[count] é a quantidade de itens */
+   unsigned short int count; /** Quantidade de BINs */
+   unsigned char width; /** Bits por item */
+} packed_pool;
+
+/**
+ * Grupos de afinidade: itens que devem ser colocados no mesmo BIN. Os tamanhos de todos
+ * os itens ficam em um único array, grupo após grupo, e \em start indica onde cada grupo
+ * começa, de forma que o grupo \em g ocupa members[start[g]] até members[start[g+1]-1].
+ */
+typedef struct affinity_groups
+{
+   unsigned short int *members; /** Tamanhos dos itens, agrupados por grupo */
+   unsigned int *start; /** Início de cada grupo em \em members, com uma posição extra no fim */
+   unsigned short int count; /** Quantidade de grupos, zero quando não há grupos */
+} affinity_groups;
+
+/**
+ * Classes de BIN permitidas para cada item. Assim como em affinity_groups, as classes de
+ * todos os itens ficam em um único array e o item \em g usa classes[start[g]] até
+ * classes[start[g+1]-1]; um item sem classes pode ir para qualquer BIN.
+ */
+typedef struct eligibility
+{
+   unsigned short int *classes; /** Classes permitidas, item após item */
+   unsigned int *start; /** Início das classes de cada item, com uma posição extra no fim */
+   unsigned short int count; /** Quantidade de itens, zero quando nenhum item usa '@' */
+   unsigned int class_count; /** Quantidade de classes: a maior classe informada mais um */
+} eligibility;
+
+/**
+ * Conjunto de tamanhos em dois níveis de bits, usado no modo de itens fracionáveis para
+ * achar em tempo constante o maior tamanho presente que não passa de um valor, ou o
+ * menor tamanho presente a partir de um valor. Cada bit de \em summary indica se a
+ * palavra correspondente de \em words tem algum bit ligado.
+ */
+typedef struct size_bitmap
+{
+   unsigned long long int words[1024]; /** Um bit por tamanho, de 0 a 65535 */
+   unsigned long long int summary[16]; /** Um bit por palavra de \em words */
+} size_bitmap;
+
+/**
+ * Índice de espaço restante dos BINs, usado para responder consultas de capacidade e
+ * escolher BINs em tempo logarítmico. É formado por:
+ *    - Uma árvore de máximos sobre o espaço restante de cada BIN, na ordem da lista,
+ *      que encontra o primeiro BIN onde um item cabe;
+ *    - Duas árvores de Fenwick indexadas pelo espaço restante, uma com a quantidade de
+ *      BINs e outra com a soma do espaço, que respondem contagens e somas por faixa.
+ */
+typedef struct fit_index
+{
+   int *tree; /** Árvore de máximos, a folha leaves + j é o BIN j, -1 quando não existe */
+   unsigned int leaves; /** Quantidade de folhas, potência de dois */
+   unsigned int count; /** Quantidade de BINs no índice */
+   unsigned int *bins_by_left; /** Fenwick: quantidade de BINs com cada espaço restante */
+   unsigned long int *free_by_left; /** Fenwick: soma do espaço dos BINs com cada espaço restante */
+   unsigned short int capacity; /** Capacidade dos BINs, maior espaço restante possível */
+} fit_index;
+
+/**
+ * Árvore de máximos sobre o espaço restante dos BINs de uma única classe, na ordem em
+ * que foram abertos. Diferente do fit_index, não tem as árvores de Fenwick indexadas
+ * pelo espaço restante: a memória fica proporcional aos BINs da classe, e uma classe
+ * sem BINs não aloca nada.
+ */
+typedef struct class_index
+{
+   int *tree; /** Árvore de máximos, a folha leaves + j é o j-ésimo BIN da classe, -1 quando não existe */
+   unsigned int leaves; /** Quantidade de folhas, potência de dois, zero antes do primeiro BIN */
+   unsigned int count; /** Quantidade de BINs da classe */
+   unsigned short int *bins; /** Posição na lista de cada BIN da classe */
+} class_index;
+
+/**
+ * Índice dos BINs do modo estocástico. Um item de média m e variância v cabe no BIN de
+ * médias M e variâncias V quando BIN_SIZE - M - z·sqrt(V + v) >= m, teste que não é
+ * aditivo em v. As variâncias dos itens são divididas em STOCHASTIC_BUCKETS faixas, cada
+ * uma começando em \em bound[k], e a árvore de máximos sobre os BINs, na ordem da lista,
+ * guarda por nó e por faixa a maior folga BIN_SIZE - M - z·sqrt(V + bound[k]). Como a
+ * folga diminui com a variância, a faixa do item dá uma condição necessária que descarta
+ * subárvores inteiras; nas folhas o teste é exato.
+ */
+typedef struct stochastic_index
+{
+   double *slack; /** Maior folga por faixa, o nó i usa slack[i * STOCHASTIC_BUCKETS + k] */
+   double *variance; /** Variância somada de cada BIN */
+   double bound[STOCHASTIC_BUCKETS]; /** Menor variância de cada faixa, bound[0] igual a zero */
+   unsigned int leaves; /** Quantidade de folhas, potência de dois */
+   unsigned int count; /** Quantidade de BINs no índice */
+   double z; /** Quantil da probabilidade de transbordar */
+} stochastic_index;
+
+/**
+ * Item a ser ordenado por uma chave real, como o tamanho efetivo no modo estocástico ou
+ * a densidade no modo mochila, junto com a sua posição na entrada.
+ */
+typedef struct ranked_item
+{
+   double key; /** Chave de ordenação */
+   unsigned int index; /** Posição do item na entrada */
+} ranked_item;
+
+/**
+ * Heap binário de BINs ordenado pelo espaço restante, usado pelo nivelamento. Com
+ * \em sign igual a 1 o topo é o BIN com menos espaço (o mais cheio); com -1, o BIN com
+ * mais espaço. \em pos guarda a posição de cada BIN no heap, ou -1 se ele não está no heap.
+ */
+typedef struct level_heap
+{
+   int *heap; /** BINs, com o topo na posição zero */
+   int *pos; /** Posição de cada BIN em \em heap */
+   int size; /** Quantidade de BINs no heap */
+   int sign; /** 1 para o mais cheio no topo, -1 para o mais vazio */
+   const bin *bins; /** BINs de onde vem o espaço restante */
+} level_heap;
+
+/**
+ * Evento de um trace de empacotamento online. No arquivo cada evento ocupa
+ * TRACE_RECORD_SIZE bytes, em little-endian: atraso (4), operação (1), reservado (1),
+ * tamanho (2) e identificador (4). O arquivo começa com TRACE_MAGIC, a versão (2), o
+ * BIN_SIZE (2) e a quantidade de eventos (4).
+ */
+typedef struct trace_record
+{
+   unsigned int delay; /** Microssegundos desde o evento anterior */
+   unsigned char op; /** 'a' para chegada, 'd' para saída */
+   unsigned short int size; /** Tamanho do item, apenas nas chegadas */
+   unsigned int id; /** Identificador do item */
+} trace_record;
+
+/**
+ * Histograma de latências no estilo HDR: cada potência de dois é dividida em
+ * LATENCY_SUB_BUCKETS faixas iguais, o que mantém o erro relativo abaixo de 1/16 em
+ * qualquer escala usando um array de tamanho fixo.
+ */
+typedef struct latency_histogram
+{
+   unsigned long int counts[LATENCY_BUCKETS]; /** Quantidade de medidas em cada faixa */
+   unsigned long int total; /** Quantidade de medidas */
+   unsigned long int max; /** Maior medida */
+} latency_histogram;
+
+/**
+ * Prazo e cancelamento cooperativo dos motores de busca. Os motores consultam
+ * deadline_expired (ou DEADLINE_POLL nos laços internos) e, quando ele vence ou é
+ * cancelado, param entregando a melhor solução que já têm. A cada melhora, os motores
+ * chamam deadline_report, que repassa a quantidade de BINs para \em on_best.
+ */
+typedef struct deadline
+{
+   struct timespec start; /** Instante em que o prazo começou a contar */
+   unsigned long int limit_us; /** Prazo em microssegundos, 0 sem prazo */
+   atomic_int cancelled; /** Diferente de zero depois de cancelado ou vencido */
+   int (*on_best) (const char *engine, unsigned int bins, void *context); /** Chamada a cada melhora, ou NULL; retornando diferente de zero, cancela */
+   void *context; /** Repassado para \em on_best */
+} deadline;
+
+/**
+ * Completamentos de um BIN gerados em um nó da busca exata. Cada completamento ocupa
+ * \em data[offset], com a quantidade de itens, o espaço que sobra no BIN e as posições
+ * (no histograma) dos tamanhos dos itens.
+ */
+typedef struct completion_list
+{
+   unsigned short int *data; /** Completamentos, em sequência */
+   unsigned int size; /** Posições usadas de \em data */
+   unsigned int capacity; /** Posições alocadas de \em data */
+   unsigned int *offset; /** Início de cada completamento em \em data */
+   unsigned short int *residual; /** Espaço que sobra no BIN com cada completamento */
+   unsigned int count; /** Quantidade de completamentos */
+   unsigned int room; /** Completamentos alocados em \em offset e \em residual */
+} completion_list;
+
+/**
+ * Estado da busca exata por "bin completion". Os números são tratados pelo histograma:
+ * itens de mesmo tamanho são indistinguíveis, então cada conjunto de tamanhos é gerado
+ * uma única vez (quebra de simetria). Estados que já falharam ficam na tabela de
+ * nogoods, indexada por um hash do multiconjunto de itens restantes.
+ */
+typedef struct exact_search
+{
+   const unsigned short int *sizes; /** Tamanhos distintos, em ordem decrescente */
+   unsigned int *counts; /** Quantidade restante de cada tamanho */
+   unsigned long int *suffix; /** Soma restante dos tamanhos a partir de cada posição */
+   unsigned short int distinct; /** Quantidade de tamanhos distintos */
+   unsigned short int capacity; /** Capacidade dos BINs */
+   unsigned long int waste; /** Espaço que pode sobrar nos BINs com a quantidade testada */
+   unsigned short int *bin_items; /** Itens (posição do tamanho) de cada BIN da solução, em sequência */
+   unsigned int *bin_start; /** Início de cada BIN em \em bin_items */
+   unsigned short int *current; /** Itens do BIN em construção durante a geração */
+   unsigned int current_count; /** Quantidade de itens em \em current */
+   unsigned long long int *zobrist; /** Valor aleatório de cada tamanho, somado ao hash por item */
+   unsigned long long int hash; /** Hash do multiconjunto de itens restantes */
+   unsigned long long int *nogood_key; /** Hash de cada estado que falhou, 0 para posição livre */
+   unsigned int *nogood_bins; /** BINs já fechados quando o estado falhou */
+   unsigned long int nodes; /** Nós visitados */
+   unsigned long int hits; /** Nós cortados pela tabela de nogoods */
+   unsigned int ticks; /** Contador da verificação do prazo */
+   char aborted; /** Prazo vencido ou completamentos demais: a busca não é conclusiva */
+} exact_search;
+
+/**
+ * Subárvore da busca exata paralela: os BINs já fechados, cada um como a quantidade de
+ * itens seguida das posições dos tamanhos, com o último BIN sendo o filho oferecido.
+ */
+typedef struct exact_task
+{
+   unsigned int bins; /** BINs fechados, incluindo o último */
+   unsigned long int waste; /** Espaço que sobrou nesses BINs */
+   unsigned int length; /** Posições usadas de \em items */
+   unsigned short int items[]; /** BINs, em sequência */
+} exact_task;
+
+/**
+ * Deque de Chase e Lev com capacidade fixa. Apenas a thread dona insere e retira pelo
+ * fundo (\em bottom); as demais roubam pelo topo (\em top) com compare-and-swap.
+ */
+typedef struct ws_deque
+{
+   atomic_long top; /** Próxima posição a ser roubada */
+   atomic_long bottom; /** Próxima posição livre */
+   _Atomic(exact_task *) tasks[EXACT_DEQUE_SIZE]; /** Tarefas, em posições módulo EXACT_DEQUE_SIZE */
+} ws_deque;
+
+/**
+ * Estado compartilhado da busca exata paralela. A melhor quantidade de BINs é atômica
+ * e todas as threads cortam a busca por ela; a tabela de nogoods é compartilhada e cada
+ * posição guarda, em uma única palavra atômica, o restante do hash e os BINs fechados.
+ */
+typedef struct exact_job
+{
+   const size_histogram *hist; /** Histograma dos números */
+   unsigned short int distinct; /** Tamanhos distintos usados na busca, sem o zero */
+   unsigned short int items; /** Quantidade de números */
+   unsigned int lower; /** Limite inferior: atingido, a busca termina */
+   atomic_int best; /** Menor quantidade de BINs conhecida */
+   pthread_mutex_t lock; /** Protege a solução guardada */
+   unsigned short int *solution_items; /** Itens de cada BIN da melhor solução, como em exact_search */
+   unsigned int *solution_start; /** Início de cada BIN da melhor solução */
+   unsigned long long int *zobrist; /** Valor aleatório de cada tamanho */
+   atomic_ullong *nogood; /** Tabela de nogoods, 0 para posição livre */
+   ws_deque *deques; /** Um deque por thread */
+   unsigned short int threads; /** Quantidade de threads */
+   atomic_long pending; /** Tarefas criadas e ainda não concluídas */
+   atomic_int aborted; /** Prazo vencido ou completamentos demais */
+   atomic_ulong steals; /** Tarefas roubadas */
+   unsigned long int nodes; /** Nós visitados, somados no final */
+   unsigned long int hits; /** Cortes pela tabela de nogoods, somados no final */
+} exact_job;
+
+/**
+ * Thread da busca exata paralela, com o próprio estado de busca.
+ */
+typedef struct exact_worker
+{
+   exact_search search; /** Estado da busca, só da thread */
+   exact_job *job; /** Estado compartilhado */
+   unsigned short int id; /** Posição do deque da thread */
+   unsigned long long int state; /** Estado do gerador usado na escolha das vítimas */
+} exact_worker;
+
+/**
+ * Estado do esquema de aproximação assintótica. Os números grandes, exceto o primeiro
+ * grupo, são arredondados para o maior tamanho do seu grupo, formando \em classes
+ * classes. Um padrão é a quantidade de números de cada classe que cabe em um BIN.
+ */
+typedef struct aptas_context
+{
+   unsigned short int classes; /** Quantidade de classes de tamanho */
+   unsigned short int *class_size; /** Tamanho arredondado de cada classe */
+   unsigned short int *class_count; /** Quantidade de números de cada classe */
+   unsigned short int *current; /** Padrão em construção durante a enumeração */
+   unsigned short int *patterns; /** Padrões enumerados, \em classes posições por padrão */
+   unsigned int count; /** Quantidade de padrões enumerados */
+   unsigned int allocated; /** Quantidade de padrões que cabem em \em patterns */
+   unsigned int ticks; /** Contador da verificação do prazo durante a enumeração */
+} aptas_context;
+
+/**
+ * Conjunto de BINs compartilhado pelo empacotamento concorrente. O espaço restante de
+ * cada BIN é atômico e só diminui por compare-and-swap, de forma que duas threads nunca
+ * reservam o mesmo espaço. BINs ainda não abertos têm espaço zero.
+ */
+typedef struct concurrent_bins
+{
+   atomic_int *left; /** Espaço restante de cada BIN */
+   atomic_uint opened; /** Quantidade de BINs abertos */
+   unsigned short int capacity; /** Capacidade dos BINs */
+} concurrent_bins;
+
+/**
+ * Parâmetros de uma thread produtora do empacotamento concorrente.
+ */
+typedef struct concurrent_producer
+{
+   concurrent_bins *shared; /** BINs compartilhados */
+   const unsigned short int *values; /** Todos os números, na ordem de chegada */
+   unsigned short int *bin_of; /** BIN escolhido para cada número */
+   unsigned short int first; /** Primeiro número desta thread */
+   unsigned short int step; /** A thread insere os números first, first + step, ... */
+} concurrent_producer;
+
+/**
+ * Estado compartilhado entre as threads do modo de múltiplas partidas. O melhor
+ * resultado conhecido fica em \em best e é lido por todas as threads, que abandonam a
+ * partida assim que ela passa dessa quantidade de BINs.
+ */
+typedef struct multistart_job
+{
+   const unsigned short int *values; /** Números em ordem decrescente (somente leitura) */
+   atomic_uint next; /** Próxima partida a ser executada */
+   atomic_int best; /** Menor quantidade de BINs encontrada até agora */
+   unsigned int winner; /** Partida que encontrou \em best, a de menor índice em caso de empate */
+   pthread_mutex_t lock; /** Protege o campo \em winner */
+} multistart_job;
+
+/**
+ * Estado compartilhado entre as threads do modo de varredura. O histograma é apenas
+ * lido pelas threads, cada uma pega a próxima capacidade ainda não avaliada.
+ */
+typedef struct sweep_job
+{
+   const size_histogram *hist; /** Histograma compartilhado (somente leitura) */
+   const unsigned short int *capacities; /** Capacidades candidatas */
+   int *results; /** Quantidade de BINs para cada capacidade, -1 se inviável */
+   unsigned int count; /** Quantidade de capacidades candidatas */
+   unsigned int next; /** Próxima capacidade a ser avaliada */
+   pthread_mutex_t lock; /** Protege o campo \em next */
+} sweep_job;
+
+/**
+ * Funções compartilhadas pelo programa e pela interface de biblioteca. São static: com
+ * -DBIN_PACKING_NO_MAIN, apenas as funções de bin-packing.h são exportadas.
+ */
+static void* bp_default_allocate (size_t size, size_t alignment, void *context);
+static void bp_default_deallocate (void *pointer, size_t size, size_t alignment, void *context);
+static int bp_read_item (const void *items, size_t i, size_t width, int is_signed, unsigned long long int *size);
+static int max_tree_build (int *tree, size_t leaves);
+static size_t max_tree_first (const int *tree, size_t leaves, int s);
+static int max_tree_set (int *tree, size_t leaves, size_t j, int value);
+
+/**
+ * Tudo até a interface de biblioteca, no final do arquivo, pertence ao programa: com
+ * -DBIN_PACKING_NO_MAIN, as variáveis globais, as funções dos modos e a main ficam de fora.
+ */
+#ifndef BIN_PACKING_NO_MAIN
 /** A Quantidade de números que devem ser colocados nos BINs */
 unsigned short int NUMBERS_QUANTITY;
 /** O tamanho do BIN, ou seja, o valor total da soma dos numeros que nele */
@@ -73,20 +639,399 @@ unsigned short int BIN_SIZE;
 unsigned short int NUMBERS_MINIMUM;
 /** O valor máximo que deve ser gerado os numeros */
 unsigned short int NUMBERS_MAXIMUM; 
+/** Capacidades avaliadas no modo de varredura (opção -S), NULL quando desativado */
+unsigned short int *SWEEP_CAPACITIES = NULL;
+/** Quantidade de capacidades avaliadas no modo de varredura */
+unsigned int SWEEP_COUNT = 0;
+/** Limite de padrões enumerados pelo esquema de aproximação */
+#define APTAS_MAX_PATTERNS 65536
+/** BIN de um número que o esquema de aproximação ainda não colocou */
+#define APTAS_UNASSIGNED 65535
+
+/** Diferença máxima, em partes de BIN_SIZE, entre números trocados nas partidas aleatórias */
+#define MULTISTART_NEAR_EQUAL 20
+
+/** Quantidade de BINs recém abertos que o empacotamento concorrente tenta antes de abrir outro */
+#define CONCURRENT_WINDOW 8
+
+/** Identificação dos arquivos de racks (opção -w), seguida da versão do formato */
+#define RACKS_MAGIC "BPRK"
+#define RACKS_VERSION 1
+
+/** Identificação dos arquivos de trace, seguida da versão do formato */
+#define TRACE_MAGIC "BPTR"
+#define TRACE_VERSION 1
+/** Tamanho em bytes de cada evento do trace */
+#define TRACE_RECORD_SIZE 12
+
+/** Iterações entre duas leituras do relógio em DEADLINE_POLL, potência de dois */
+#define DEADLINE_CHECK_INTERVAL 1024
+/**
+ * Verificação do prazo para laços internos: lê o relógio apenas uma vez a cada
+ * DEADLINE_CHECK_INTERVAL chamadas. \em ticks é um contador do próprio laço, então
+ * threads diferentes não disputam a mesma variável.
+ */
+#define DEADLINE_POLL(d, ticks) ((++(ticks) & (DEADLINE_CHECK_INTERVAL - 1)) == 0 && deadline_expired(d))
+
+/** Motores do FFD, na ordem de ENGINE_NAMES */
+#define ENGINE_AUTO -1
+#define ENGINE_LINEAR 0
+#define ENGINE_BLOCK 1
+#define ENGINE_TREE 2
+#define ENGINE_HISTOGRAM 3
+#define ENGINE_BUCKET 4
+#define ENGINE_COUNT 5
+/** Motor bucket: quantidade de BINs por balde do índice */
+#define ENGINE_BUCKET_SIZE 64
+/** Arquivo de calibração usado quando a variável de ambiente BIN_PACKING_CONFIG não existe */
+#define ENGINE_CONFIG "bin-packing.conf"
 
+/** Busca exata: maior quantidade de BINs testada, a recursão usa um nível por BIN */
+#define EXACT_MAX_BINS 4096
+/** Busca exata: completamentos gerados por nó; passando disso o resultado não é provado */
+#define EXACT_MAX_COMPLETIONS 65535
+/** Busca exata: itens além do maior para os quais a dominância é testada em todos os subconjuntos */
+#define EXACT_DOMINANCE_ITEMS 10
+/** Busca exata: bits da tabela de nogoods, que tem 2^EXACT_NOGOOD_BITS posições */
+#define EXACT_NOGOOD_BITS 20
+/** Busca exata paralela: um nó só oferece filhos para roubo enquanto o deque tem menos tarefas que isso */
+#define EXACT_SPLIT_TASKS 4
+/** Mochila múltipla: itens colocados, dos de menor valor, testados para troca por cada item de fora */
+#define KNAPSACK_REPAIR_CANDIDATES 32
+/** Mochila múltipla: itens de fora, dos mais densos, oferecidos à programação dinâmica de cada BIN */
+#define KNAPSACK_DP_ITEMS 64
+/** Mochila múltipla: total de células (itens x capacidade) da programação dinâmica */
+#define KNAPSACK_DP_BUDGET 50000000UL
+
+/** Maior buffer do modo semi-online ordenado por inserção em vez de por contagem */
+#define LOOKAHEAD_INSERTION_SORT 32
+
+/** A cada quantas instâncias do modo em lote a área de trabalho pode ser reduzida */
+#define WORKSPACE_TRIM_WINDOW 64
+
+/** Imprime e libera os BINs assim que são aposentados por fill_bins (opção -r) */
+char RETIRE_FLUSH = 0;
+/** Lê as instâncias da entrada padrão, uma por linha, reaproveitando a memória (opção -b) */
+char BATCH_MODE = 0;
+/** Erro do esquema de aproximação assintótica (opção -a), zero quando desativado */
+double APTAS_EPSILON = 0;
+/** Permite dividir itens entre BINs, minimizando as divisões (opção -f) */
+char SPLIT_MODE = 0;
+/** Quantidade de partidas aleatórias do First Fit (opção -M), zero quando desativado */
+unsigned int MULTISTART_QUANTITY = 0;
+/** Semente dos modos aleatórios (opção -s) */
+unsigned long long int RANDOM_SEED = 1;
+/** Responde consultas sobre os BINs gerados, lidas da entrada padrão (opção -q) */
+char QUERY_MODE = 0;
+/** Quantidade máxima de movimentos do nivelamento (opção -l), zero quando desativado */
+unsigned int LEVELING_ITERATIONS = 0;
+/** Empacotamento online com várias threads inserindo ao mesmo tempo (opção -c) */
+char CONCURRENT_MODE = 0;
+/** Arquivo onde gravar o trace dos eventos lidos da entrada padrão (opção -T) */
+char *TRACE_CAPTURE = NULL;
+/** Arquivo de trace a ser reproduzido (opção -R) */
+char *TRACE_REPLAY = NULL;
+/** Reproduz o trace respeitando os tempos gravados, em vez de o mais rápido possível (opção -t) */
+char TRACE_REALTIME = 0;
+/** Quantidade de itens guardados antes de empacotar no modo semi-online, 0 desativa (opção -o) */
+unsigned short int LOOKAHEAD_ITEMS = 0;
+/** Espera máxima, em milissegundos, de um item no modo semi-online, 0 sem limite (opção -o) */
+unsigned int LOOKAHEAD_MS = 0;
+/** Probabilidade máxima de transbordar um BIN no modo estocástico, 0 desativa (opção -g) */
+double STOCHASTIC_PROBABILITY = 0;
+/** Capacidade dos racks do empacotamento em dois níveis, 0 desativa (opção -H) */
+unsigned short int RACK_CAPACITY = 0;
+/** Máximo de BINs por rack, 0 sem limite (opção -H) */
+unsigned int RACK_SLOTS = 0;
+/** Otimiza os dois níveis juntos (opção -H com c) */
+char RACK_COOPTIMIZE = 0;
+/** Arquivo em que os racks são gravados, NULL desativa (opção -w) */
+char *RACK_OUTPUT = NULL;
+/** Escala de ponto fixo dos tamanhos fracionários, 0 desativa (opção -x) */
+unsigned int FIXED_SCALE = 0;
+/** Erro de arredondamento dos itens lidos com a opção -x */
+rounding_error FIXED_ERROR = { 0, 0, 0, 0, 0 };
+/** Guarda os itens dos BINs empacotados em bits (opção -m) */
+char COMPACT_MODE = 0;
+/** Imprime os BINs com as posições originais dos itens (opção -p) */
+char POSITIONS_MODE = 0;
+/** Quantidade fixa de BINs do modo mochila múltipla, 0 desativa (opção -K) */
+unsigned int KNAPSACK_BINS = 0;
+/** Prazo, em milissegundos, dos modos de busca, 0 sem prazo (opção -D) */
+unsigned int DEADLINE_MS = 0;
+/** Prazo e cancelamento compartilhados por todos os motores */
+deadline DEADLINE;
+/** Motor usado por fill_bins, ENGINE_AUTO para escolher pelas características da instância (opção -E) */
+int ENGINE = ENGINE_AUTO;
+/** Imprime o motor escolhido, ligado quando o motor é informado com -E */
+char ENGINE_VERBOSE = 0;
+/** Nome de cada motor, na ordem das constantes ENGINE_* */
+const char *ENGINE_NAMES[ENGINE_COUNT] = { "linear", "block", "tree", "histogram", "bucket" };
+/**
+ * Segundos por unidade de custo de cada motor, usados na escolha automática. Os valores
+ * padrão são substituídos pelos do arquivo de calibração, quando ele existe.
+ * \see engine_cost
+ */
+double ENGINE_COST[ENGINE_COUNT] = { 1.0e-9, 1.0e-9, 8.0e-9, 8.0e-10, 1.0e-9 };
+/** Calibra os custos dos motores e grava o arquivo de calibração (opção -C) */
+char CALIBRATE_MODE = 0;
+/** Busca a solução exata (opção -X) */
+char EXACT_MODE = 0;
+/** Quantidade de threads utilizadas pelos modos paralelos (opção -j) */
+unsigned short int THREADS_QUANTITY = 0;
+
+int aptas_enumerate (aptas_context *ctx, unsigned short int t, unsigned int slack);
+int bitmap_clear (size_bitmap *set, unsigned short int size);
+int bitmap_predecessor (const size_bitmap *set, unsigned int size);
+int bitmap_set (size_bitmap *set, unsigned short int size);
+int bitmap_successor (const size_bitmap *set, unsigned int size);
+int build_histogram (unsigned short int *values, size_histogram *hist);
+int calibrate_engines ();
+int class_index_first (const class_index *idx, unsigned int s);
+int class_index_set (class_index *idx, unsigned int j, unsigned short int left, unsigned short int position);
+int compare_ranked_items (const void *a, const void *b);
 int comparison_numbers (const void * a, const void * b);
-int create_numbers_array (unsigned short int *values);
+int completion_dominated (const exact_search *search, unsigned short int residual);
+int concurrent_claim (concurrent_bins *shared, int j, unsigned short int num);
+int concurrent_place (concurrent_bins *shared, int *cached, unsigned short int num);
+void* concurrent_worker (void *arg);
 bin* create_empty_bin ();
 bin_list* create_empty_bin_list ();
+int create_numbers_array (unsigned short int *values);
+int deadline_cancel (deadline *d);
+int deadline_expired (deadline *d);
+int deadline_report (deadline *d, const char *engine, unsigned int bins);
+int deadline_start (deadline *d, unsigned long int limit_us);
+unsigned long int elapsed_us (const struct timespec *since);
+double engine_cost (int engine, unsigned short int n, unsigned short int distinct, double bins);
+int exact_apply (exact_search *search, const unsigned short int *items, unsigned short int count, int sign);
+int exact_complete (exact_search *search, unsigned int bins, unsigned long int waste);
+int exact_generate (exact_search *search, unsigned short int d, unsigned short int residual, unsigned long int allowed,
+                    completion_list *list);
+int exact_parallel (exact_job *job);
+int exact_parallel_node (exact_worker *worker, unsigned int bins, unsigned long int waste);
+int exact_push_child (exact_worker *worker, unsigned int bins, unsigned long int waste, const unsigned short int *items);
+int exact_record (exact_worker *worker, unsigned int bins);
+int exact_run_task (exact_worker *worker, exact_task *task);
+int exact_solution_bins (const unsigned short int *values, unsigned short int n, const size_histogram *hist,
+                         const unsigned short int *bin_items, const unsigned int *bin_start, unsigned int nbins,
+                         unsigned short int *left, unsigned short int *bin_of);
+void* exact_worker_run (void *arg);
+int ffd_block_scan (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                    unsigned short int *left, unsigned short int *bin_of);
+int ffd_bucket (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                unsigned short int *left, unsigned short int *bin_of);
+int ffd_histogram (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                   unsigned short int *left, unsigned short int *bin_of);
+int ffd_linear (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                unsigned short int *left, unsigned short int *bin_of);
+int ffd_tree (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+              unsigned short int *left, unsigned short int *bin_of);
 int fill_bins (unsigned short int *values, bin_list *bins);
+int fill_bins_engine (unsigned short int *values, bin_list *bins, int engine);
+int fill_bins_generic (unsigned short int *values, bin_list *bins);
+int first_fit_assign (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                      unsigned short int *left, int *next, unsigned short int *bin_of);
+int first_fit_limited (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                       atomic_int *limit, unsigned short int *left, unsigned short int *bin_of);
+int fit_index_add (fit_index *idx, unsigned short int left, int bins);
+int fit_index_build (fit_index *idx, const bin *bins, unsigned int count, unsigned short int capacity);
+unsigned int fit_index_count (const fit_index *idx, unsigned int s);
+int fit_index_first (const fit_index *idx, unsigned int s);
+unsigned long int fit_index_free (const fit_index *idx, unsigned int a, unsigned int b);
+int fit_index_free_arrays (fit_index *idx);
+int fit_index_largest (const fit_index *idx);
+int fit_index_set (fit_index *idx, unsigned int j, unsigned short int left);
 int free_bins (bin_list *bins);
+int free_histogram (size_histogram *hist);
+int free_workspace (workspace *ws);
 int generate_random_number (unsigned short int min, unsigned short int max);
-int insert_number_bin (bin *b, unsigned short int num);
+unsigned short int histogram_first_at_most (const unsigned short int *sizes, unsigned short int distinct, unsigned int t);
 int insert_bin_list (bin_list *list, bin *b);
+int insert_number_bin (bin *b, unsigned short int num);
+unsigned long int knapsack_improve_bin (const unsigned short int *size, const unsigned int *value, int *bin_of,
+                                        unsigned short int *left, unsigned int b, const unsigned int *members,
+                                        unsigned int size_members, const unsigned int *extra, unsigned int count);
+unsigned int latency_bucket (unsigned long int value);
+unsigned long int latency_percentile (const latency_histogram *h, double percentile);
+int latency_record (latency_histogram *h, unsigned long int value);
+int level_bins (bin_list *bins);
+int level_heap_fix (level_heap *h, int j);
+int level_heap_push (level_heap *h, int j);
+int level_heap_remove (level_heap *h, int j);
+int load_engine_config ();
+int lookahead_flush (const unsigned short int *buffer, const unsigned int *position, unsigned short int n,
+                     unsigned short int *order, fit_index *idx, unsigned short int *bin_of);
+unsigned int lower_bound_l2 (const size_histogram *hist, unsigned short int capacity);
+int materialize_bins (const unsigned short int *values, unsigned short int n, const unsigned short int *bin_of,
+                      const unsigned short int *left, unsigned short int nbins, unsigned short int *pool, bin *out);
+void* multistart_worker (void *arg);
+double normal_quantile (double p);
+int pack_histogram (const size_histogram *hist, unsigned short int capacity, unsigned short int *left);
+int packed_put (unsigned char *bytes, unsigned long int bit, unsigned char width, unsigned short int value);
+unsigned short int packed_unpack (const packed_pool *pool, unsigned short int b, unsigned short int *out);
+unsigned char packed_width (unsigned short int capacity);
+int parse_affinity_groups (char **tokens, unsigned short int ntokens, affinity_groups *groups, unsigned short int *values);
+int parse_capacities (char *arg);
+int parse_eligibility (char **tokens, unsigned short int ntokens, eligibility *classes);
+int parse_engine (const char *arg);
+unsigned short int parse_fixed (const char *token, char **end, int up, double *error);
+int parse_knapsack_item (const char *token, unsigned short int *size, unsigned int *value);
+int parse_lookahead (char *arg);
+int parse_racks (char *arg);
+unsigned short int parse_size (const char *token, char **end);
+int parse_stochastic_item (const char *token, unsigned short int *mean, double *variance);
+int perturb_order (const unsigned short int *values, unsigned short int n, unsigned int start, unsigned short int *order);
 int print_bin(bin *b);
+int print_latency (const char *name, const latency_histogram *h);
 int print_list_bins (bin_list *bins);
 int print_numbers (unsigned short int *values);
+int print_rounding_error (const char *bin_token);
+int rack_empty_last (bin_list *bins, int *rack_of, unsigned int *rack_left, unsigned int *rack_bins, unsigned int racks,
+                     unsigned long int *moved);
+unsigned long long int random_next (unsigned long long int *state);
+int report_best (const char *engine, unsigned int bins, void *context);
+int reserve_workspace (workspace *ws, unsigned int n);
+double residual_variance (const bin_list *bins);
+int retire_bin (bin_list *bins, int index);
+int run_affinity (unsigned short int *values, const affinity_groups *groups);
+int run_aptas (unsigned short int *values);
+int run_batch ();
+int run_compact (unsigned short int *values);
+int run_concurrent (unsigned short int *values);
+int run_eligible (unsigned short int *values, const affinity_groups *groups, const eligibility *classes);
+int run_engine (int engine, const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                unsigned short int *left, unsigned short int *bin_of);
+int run_exact (unsigned short int *values);
+int run_knapsack (char **args, int nargs);
+int run_multistart (unsigned short int *values);
+int run_positions (unsigned short int *values);
+int run_queries (bin_list *bins);
+int run_racks (bin_list *bins);
+int run_semi_online (unsigned short int *values);
+int run_splittable (unsigned short int *values);
+int run_stochastic (char **args, int nargs);
+int run_sweep (unsigned short int *values);
+int run_trace_capture ();
+int run_trace_replay ();
+int select_engine (const unsigned short int *values, unsigned short int n, unsigned short int capacity);
+int sort_indices_desc (const unsigned short int *keys, unsigned short int n, unsigned short int *order);
 int sort_numbers_array (unsigned short int *values);
+int sort_records_32 (const unsigned short int *values, unsigned long int n, unsigned short int *sorted,
+                     unsigned long int *positions, void *scratch);
+int sort_records_64 (const unsigned short int *values, unsigned long int n, unsigned short int *sorted,
+                     unsigned long int *positions, void *scratch);
+int sort_records_desc (const unsigned short int *values, unsigned long int n, unsigned short int *sorted,
+                       unsigned long int *positions, void *scratch);
+long int stochastic_first (const stochastic_index *idx, unsigned int node, unsigned int k, unsigned short int mean,
+                           double variance);
+int stochastic_index_set (stochastic_index *idx, unsigned int j, unsigned long int mean, double variance);
+void* sweep_worker (void *arg);
+int trace_read_record (FILE *file, trace_record *record);
+int trace_write_record (FILE *file, const trace_record *record);
+int trim_workspace (workspace *ws);
+int write_le (FILE *file, unsigned long int value, int bytes);
+int write_racks (const char *path, const bin_list *bins, const unsigned int *rack_left, const unsigned int *rack_bins,
+                 const unsigned short int *order, unsigned int racks);
+int ws_deque_push (ws_deque *deque, exact_task *task);
+exact_task* ws_deque_steal (ws_deque *deque);
+exact_task* ws_deque_take (ws_deque *deque);
+
+/**
+ * Gera uma versão de fill_bins especializada para uma capacidade constante
+ * \em CAPACITY, guardando o espaço restante dos BINs em um array contíguo do tipo
+ * \em item_t, o menor tipo em que a capacidade cabe.
+ *
+ * A busca pelo primeiro BIN com espaço percorre esse array em blocos de
+ * FIXED_SCAN_BLOCK posições sem desvios, o que permite ao compilador desenrolar o laço
+ * e usar instruções vetoriais com a largura de \em item_t. BINs aposentados (ver
+ * fill_bins_generic) ficam com espaço zero, nunca são escolhidos, e os que estão no
+ * início do array deixam de ser percorridos.
+ *
+ * \param suffix Sufixo do nome da função gerada, fill_bins_<suffix>.
+ * \param CAPACITY Capacidade dos BINs, deve ser igual a BIN_SIZE na chamada.
+ * \param item_t Tipo inteiro sem sinal capaz de representar \em CAPACITY.
+ * \see fill_bins
+ */
+#define FIXED_SCAN_BLOCK 16
+#define DEFINE_FILL_BINS_FIXED(suffix, CAPACITY, item_t)                                  \
+int fill_bins_##suffix (unsigned short int *values, bin_list *bins)                       \
+{                                                                                         \
+   unsigned short int i;                                                                  \
+   unsigned short int j;                                                                  \
+   unsigned short int k;                                                                  \
+   unsigned short int first = 0; /* Primeiro BIN que ainda não foi aposentado */          \
+   unsigned short int used = 0;                                                           \
+   item_t smallest;                                                                       \
+   item_t *left;                                                                          \
+                                                                                          \
+   if (NUMBERS_QUANTITY == 0)                                                             \
+      return 0;                                                                           \
+                                                                                          \
+   left = malloc(sizeof(item_t)*NUMBERS_QUANTITY);                                        \
+                                                                                          \
+   if (left == NULL)                                                                      \
+      exit(1);                                                                            \
+                                                                                          \
+   smallest = values[NUMBERS_QUANTITY - 1];                                               \
+                                                                                          \
+   for (i = 0; i < NUMBERS_QUANTITY; i++)                                                 \
+   {                                                                                      \
+      item_t num = values[i];                                                             \
+                                                                                          \
+      /* Blocos inteiros sem desvio, depois o restante posição a posição. */              \
+      for (j = first; j + FIXED_SCAN_BLOCK <= used; j += FIXED_SCAN_BLOCK)                \
+      {                                                                                   \
+         char hit = 0;                                                                    \
+                                                                                          \
+         for (k = 0; k < FIXED_SCAN_BLOCK; k++)                                           \
+            hit |= left[j + k] >= num;                                                    \
+                                                                                          \
+         if (hit)                                                                         \
+            break;                                                                        \
+      }                                                                                   \
+                                                                                          \
+      while (j < used && left[j] < num)                                                   \
+         j++;                                                                             \
+                                                                                          \
+      if (j == used)                                                                      \
+      {                                                                                   \
+         if (insert_bin_list(bins, create_empty_bin()) == 1)                              \
+         {                                                                                \
+            free(left);                                                                   \
+            return 1;                                                                     \
+         }                                                                                \
+                                                                                          \
+         left[used++] = CAPACITY;                                                         \
+      }                                                                                   \
+                                                                                          \
+      insert_number_bin(bins->itens + j, num);                                            \
+      left[j] -= num;                                                                     \
+                                                                                          \
+      if (left[j] < smallest)                                                             \
+      {                                                                                   \
+         left[j] = 0;                                                                     \
+         retire_bin(bins, j);                                                             \
+                                                                                          \
+         while (first < used && left[first] < smallest)                                   \
+            first++;                                                                      \
+      }                                                                                   \
+   }                                                                                      \
+                                                                                          \
+   free(left);                                                                            \
+   return 0;                                                                              \
+}
+
+#ifdef BIN_SIZE_FIXED
+#if BIN_SIZE_FIXED <= 255
+/** Tipo do espaço restante na versão especializada, o menor que comporta BIN_SIZE_FIXED */
+typedef unsigned char fixed_item_t;
+#else
+typedef unsigned short int fixed_item_t;
+#endif
+int fill_bins_fixed (unsigned short int *values, bin_list *bins);
+DEFINE_FILL_BINS_FIXED(fixed, BIN_SIZE_FIXED, fixed_item_t)
+#endif
 
 /**
  * Função principal do programa, responsável por executar funções 
@@ -109,21 +1054,186 @@ int sort_numbers_array (unsigned short int *values);
 int main(int argc, char **argv)
 {
    unsigned short int i;
+   int opt;
+   int nargs; /** Quantidade de argumentos posicionais, isto é, após as opções. */
+   char **args; /** Primeiro argumento posicional. */
    unsigned short int *values; /** Usa-se ponteiro para armazenar a lista de números. */
+   affinity_groups groups = { NULL, NULL, 0 }; /** Grupos de afinidade, vazio se nenhum item usar '+'. */
+   eligibility classes = { NULL, NULL, 0, 0 }; /** Classes permitidas, vazio se nenhum item usar '@'. */
    bin_list *bins; /** Usa-se ponteiro contem a lsita de BINs gerados dinamicamente. */
 
+   /** Lê as opções que alteram o modo de execução do programa. */
+   while ((opt = getopt(argc, argv, "S:j:rba:fM:s:ql:cT:R:to:D:E:CXg:K:pmx:H:w:")) != -1)
+   {
+      switch (opt)
+      {
+         case 'S':
+            if (parse_capacities(optarg) != 0)
+               exit(1);
+            break;
+         case 'j':
+            THREADS_QUANTITY = atoi(optarg);
+            break;
+         case 'r':
+            RETIRE_FLUSH = 1;
+            break;
+         case 'b':
+            BATCH_MODE = 1;
+            break;
+         case 'f':
+            SPLIT_MODE = 1;
+            break;
+         case 'q':
+            QUERY_MODE = 1;
+            break;
+         case 'l':
+            LEVELING_ITERATIONS = atoi(optarg);
+            break;
+         case 'c':
+            CONCURRENT_MODE = 1;
+            break;
+         case 'T':
+            TRACE_CAPTURE = optarg;
+            break;
+         case 'R':
+            TRACE_REPLAY = optarg;
+            break;
+         case 't':
+            TRACE_REALTIME = 1;
+            break;
+         case 'o':
+            if (parse_lookahead(optarg) != 0)
+               exit(1);
+            break;
+         case 'D':
+            DEADLINE_MS = atoi(optarg);
+            break;
+         case 'E':
+            if (parse_engine(optarg) != 0)
+               exit(1);
+            break;
+         case 'C':
+            CALIBRATE_MODE = 1;
+            break;
+         case 'X':
+            EXACT_MODE = 1;
+            break;
+         case 'M':
+            MULTISTART_QUANTITY = atoi(optarg);
+            break;
+         case 's':
+            RANDOM_SEED = strtoull(optarg, NULL, 10);
+            break;
+         case 'a':
+            APTAS_EPSILON = atof(optarg);
+            if (APTAS_EPSILON <= 0 || APTAS_EPSILON >= 1)
+            {
+               printf("O parâmetro da opção -a deve estar entre 0 e 1.\n");
+               exit(1);
+            }
+            break;
+         case 'g':
+            STOCHASTIC_PROBABILITY = atof(optarg);
+            if (STOCHASTIC_PROBABILITY <= 0 || STOCHASTIC_PROBABILITY > 0.5)
+            {
+               printf("O parâmetro da opção -g deve ser maior que 0 e no máximo 0.5.\n");
+               exit(1);
+            }
+            break;
+         case 'p':
+            POSITIONS_MODE = 1;
+            break;
+         case 'm':
+            COMPACT_MODE = 1;
+            break;
+         case 'x':
+            FIXED_SCALE = atoi(optarg);
+            break;
+         case 'H':
+            if (parse_racks(optarg) != 0)
+               exit(1);
+            break;
+         case 'w':
+            RACK_OUTPUT = optarg;
+            break;
+         case 'K':
+            KNAPSACK_BINS = atoi(optarg);
+            if (KNAPSACK_BINS == 0 || KNAPSACK_BINS > 65535)
+            {
+               printf("A quantidade de BINs da opção -K deve estar entre 1 e 65535.\n");
+               exit(1);
+            }
+            break;
+         default:
+            exit(1);
+      }
+   }
+
+   args = argv + optind;
+   nargs = argc - optind;
+
+   /** O prazo conta desde o início do programa; com -D as melhoras também são impressas. */
+   deadline_start(&DEADLINE, DEADLINE_MS * 1000UL);
+
+   if (DEADLINE_MS > 0)
+      DEADLINE.on_best = report_best;
+
+   /** A calibração usa instâncias sintéticas próprias e dispensa os argumentos. */
+   if (CALIBRATE_MODE)
+      return calibrate_engines();
+
+   /** No modo em lote as instâncias vêm da entrada padrão, não dos argumentos. */
+   if (BATCH_MODE)
+      return run_batch();
+
+   /** Os traces têm a própria capacidade e os próprios itens, dispensando os argumentos. */
+   if (TRACE_CAPTURE != NULL)
+      return run_trace_capture();
+
+   if (TRACE_REPLAY != NULL)
+      return run_trace_replay();
+
    /**
     * Verifica-se os argumentos passados, ou seja, se foi passado a quantidade necessária. 
     * Se não, informa o que é preciso para execução e encerra o programa.
     */
-   if (argc < 5)
+   if (nargs < 4)
    {
       printf("Passar os argumentos do programa.\n");
       printf("1 - Quantidade de números para empacotar \n");
       printf("2 - Tamanhos dos BINs \n");
       printf("3 - Valor mínimo dos números \n");
       printf("4 - Valor máximo dos números \n");
-      printf("5 - Valores a serem empacotados (Opcional) \n");
+      printf("5 - Valores a serem empacotados (Opcional), itens unidos por '+' formam um grupo \n");
+      printf("    e classes de BIN permitidas vêm depois de '@' (30@0,2) \n");
+      printf("Opções: \n");
+      printf("  -S lista  Capacidades avaliadas no modo de varredura \n");
+      printf("  -j N      Quantidade de threads dos modos paralelos \n");
+      printf("  -r        Imprime cada BIN assim que ele fica cheio \n");
+      printf("  -b        Modo em lote, lê uma instância por linha da entrada padrão \n");
+      printf("  -a eps    Esquema de aproximação assintótica com erro eps \n");
+      printf("  -f        Itens fracionáveis, com '-' no lugar dos itens lê da entrada padrão \n");
+      printf("  -M N      Executa N partidas do First Fit com perturbações aleatórias \n");
+      printf("  -s seed   Semente dos modos aleatórios \n");
+      printf("  -q        Responde consultas de capacidade lidas da entrada padrão \n");
+      printf("  -l N      Nivela o espaço restante dos BINs com até N movimentos \n");
+      printf("  -c        Empacotamento online concorrente, um produtor por thread \n");
+      printf("  -T arq    Grava em arq o trace binário dos eventos lidos da entrada padrão \n");
+      printf("  -R arq    Reproduz o trace binário arq no empacotamento online \n");
+      printf("  -t        Reproduz o trace respeitando os tempos gravados \n");
+      printf("  -o k[,ms] Semi-online, ordena e empacota a cada k itens ou ms milissegundos \n");
+      printf("  -D ms     Prazo dos modos de busca, que param com a melhor solução até então \n");
+      printf("  -E nome   Motor do FFD: linear, block, tree, histogram, bucket ou auto (padrão) \n");
+      printf("  -C        Calibra a escolha automática do motor e grava em bin-packing.conf \n");
+      printf("  -X        Solução exata por \"bin completion\", limitada pelo prazo de -D; paralela com -j N > 1 \n");
+      printf("  -g p      Itens media:variancia, transbordando cada BIN com probabilidade até p \n");
+      printf("  -K N      Mochila múltipla: itens tamanho:valor em N BINs, maximizando o valor \n");
+      printf("  -p        Imprime os BINs com a posição original de cada item \n");
+      printf("  -H c[,s[,c]] Empacota os BINs em racks de capacidade c, com até s BINs, co-otimizando com c \n");
+      printf("  -w arq    Com -H, grava os racks em arq em formato binário \n");
+      printf("  -x N      Tamanhos fracionários, convertidos para inteiros na escala N \n");
+      printf("  -m        Guarda os itens dos BINs empacotados em bits, na menor largura possível; \n");
+      printf("            o motor do FFD ainda usa arrays de 16 bits durante o empacotamento \n");
       exit(1);
    }
 
@@ -131,29 +1241,45 @@ int main(int argc, char **argv)
     * Atribui os argumentos as variavéis globais do programa, para
     * que seja utilizado no restante do rpograma.
     */
-   NUMBERS_QUANTITY = atoi(argv[1]);
-   BIN_SIZE = atoi(argv[2]);
-   NUMBERS_MINIMUM = atoi(argv[3]);
-   NUMBERS_MAXIMUM = atoi(argv[4]);
+   NUMBERS_QUANTITY = atoi(args[0]);
+   BIN_SIZE = atoi(args[1]);
+   NUMBERS_MINIMUM = atoi(args[2]);
+   NUMBERS_MAXIMUM = atoi(args[3]);
+
+   /** Com -x, os tamanhos são decimais; o BIN é arredondado para baixo e os itens para cima. */
+   if (FIXED_SCALE > 0)
+   {
+      double error;
+
+      BIN_SIZE = parse_fixed(args[1], NULL, 0, &error);
+      NUMBERS_MINIMUM = parse_fixed(args[2], NULL, 1, &error);
+      NUMBERS_MAXIMUM = parse_fixed(args[3], NULL, 0, &error);
+   }
 
    /**
-    * Caso tenha sido passado mais de cinco argumentos para o programa,
+    * Caso tenha sido passado mais de quatro argumentos posicionais,
     * significa que a lista de números foi informada pelo usuário e,
     * portanto, não será gerada aleatoriamente.
     */
-   if (argc > 5)
-   {
-      values = malloc(sizeof(int)*argc-5);
-      NUMBERS_QUANTITY = argc -5;
+   if (nargs > 4)
+      NUMBERS_QUANTITY = nargs - 4;
 
-      for (i = 0; i < argc-5; i++)
-         values[i] = atoi( argv[i+5]);
-   }
-   else
-   {
-      values = malloc(sizeof(int)*NUMBERS_QUANTITY);
-      create_numbers_array (values);
-   }
+   /** Itens fracionáveis lidos da entrada padrão não passam pelo array de números. */
+   if (SPLIT_MODE && nargs == 5 && strcmp(args[4], "-") == 0)
+      return run_splittable(NULL);
+
+   if (LOOKAHEAD_ITEMS > 0 && nargs == 5 && strcmp(args[4], "-") == 0)
+      return run_semi_online(NULL);
+
+   /** Os itens estocásticos têm média e variância e não passam pelo array de números. */
+   if (STOCHASTIC_PROBABILITY > 0)
+      return run_stochastic(args, nargs);
+
+   /** Os itens da mochila múltipla têm tamanho e valor e também não passam pelo array de números. */
+   if (KNAPSACK_BINS > 0)
+      return run_knapsack(args, nargs);
+
+   values = malloc(sizeof(unsigned short int)*NUMBERS_QUANTITY);
 
    /**
     * \attention
@@ -163,79 +1289,312 @@ int main(int argc, char **argv)
    if (values == NULL)
       exit(1);
 
-   /** Inicialisa a lista de BINs.*/
-   bins = create_empty_bin_list();
-   /** Ordena de forma descrescente os números para empacotar. */
-   sort_numbers_array (values);
-   /** Imprime os números gerados e devidamente ordenados. */
-   print_numbers(values);
-   /** Preenche os BINS, ou seja, ler a lista de números e gera os BINs necessários. */ 
-   fill_bins (values, bins);
-   /** Imprime os BINs que foram gerados. */
-   print_list_bins (bins);
-   /** Por fim, libera todos os recursos que foram utilizados. */
-   free_bins (bins);
+   if (nargs > 4)
+   {
+      for (i = 0; i < NUMBERS_QUANTITY; i++)
+         values[i] = parse_size(args[i+4], NULL);
 
-   free (values);
-   return 0;
-}
+      /**
+       * Itens unidos por '+' devem ficar no mesmo BIN, cada grupo vira um único número.
+       * Itens com '@' só podem ir para BINs das classes informadas.
+       */
+      if (parse_affinity_groups(args + 4, NUMBERS_QUANTITY, &groups, values) != 0 ||
+          parse_eligibility(args + 4, NUMBERS_QUANTITY, &classes) != 0)
+      {
+         free (groups.members);
+         free (groups.start);
+         free (values);
+         return 1;
+      }
 
-/**
- * Função necessária para limpeza de dados utilizados durante a execução do programa.
- * Todos os mallocs, reallocs são liberados aqui evitando qualquer tipo de
- * memory leak.
- *
- * \param bins Ponteiro para a lista de BINs gerados pelo programa.
- * \return Zero aopós finalizado.
- * \see free
- */ 
-int free_bins (bin_list *bins)
-{
-   unsigned short int i;
+      /** Os grupos e as classes só são tratados pelo FFD, os outros modos os ignorariam. */
+      if ((groups.count > 0 || classes.count > 0) &&
+          (SWEEP_CAPACITIES != NULL || SPLIT_MODE || CONCURRENT_MODE || LOOKAHEAD_ITEMS > 0 ||
+           MULTISTART_QUANTITY > 0 || EXACT_MODE || POSITIONS_MODE || COMPACT_MODE || APTAS_EPSILON > 0 ||
+           LEVELING_ITERATIONS > 0 || RACK_CAPACITY > 0 || QUERY_MODE))
+      {
+         printf("Itens com '+' ou '@' não podem ser usados com -S, -f, -c, -o, -M, -X, -p, -m, -a, -l, -H ou -q.\n");
+         free (classes.classes);
+         free (classes.start);
+         free (groups.members);
+         free (groups.start);
+         free (values);
+         free (SWEEP_CAPACITIES);
+         return 1;
+      }
 
-   /** 
-    * Percorre a lista de BINs passada como parametro, para cada BIN existente
-    * é liberado o array de números que existe para armazenar os itens.
+      if (FIXED_SCALE > 0)
+         print_rounding_error (args[1]);
+   }
+   else
+   {
+      create_numbers_array (values);
+   }
+
+   /**
+    * No modo de varredura os números são ordenados uma única vez e todas as
+    * capacidades candidatas são avaliadas sobre o mesmo histograma.
     */
-   for (i = 0; i < bins->count; i++)
+   if (SWEEP_CAPACITIES != NULL)
    {
-      bin *b = (bins->itens + i);
-      free(b->itens);
+      sort_numbers_array (values);
+      run_sweep (values);
+      free (SWEEP_CAPACITIES);
+      free (values);
+      return 0;
    }
 
-   /** Por fim, libera a lista de BINs utilizada pelo programa. */
-   free(bins->itens);
-   free(bins);
+   if (SPLIT_MODE)
+   {
+      int status = run_splittable (values);
+      free (values);
+      return status;
+   }
 
-   return 0;
-}
+   /** O empacotamento concorrente é online, os números não são ordenados. */
+   if (CONCURRENT_MODE)
+   {
+      int status;
 
-/**
+      print_numbers (values);
+      status = run_concurrent (values);
+      free (values);
+      return status;
+   }
+
+   /** O semi-online também recebe os números na ordem de chegada. */
+   if (LOOKAHEAD_ITEMS > 0)
+   {
+      int status;
+
+      print_numbers (values);
+      status = run_semi_online (values);
+      free (values);
+      return status;
+   }
+
+   if (MULTISTART_QUANTITY > 0)
+   {
+      int status;
+
+      sort_numbers_array (values);
+      print_numbers (values);
+      status = run_multistart (values);
+      free (values);
+      return status;
+   }
+
+   /** Com classes de BIN, cada item (ou grupo) vai para o primeiro BIN permitido onde cabe. */
+   if (classes.count > 0)
+   {
+      int status = run_eligible (values, &groups, &classes);
+      free (classes.classes);
+      free (classes.start);
+      free (groups.members);
+      free (groups.start);
+      free (values);
+      return status;
+   }
+
+   /** Com grupos de afinidade empacotam-se os grupos, que depois são expandidos nos BINs. */
+   if (groups.count > 0)
+   {
+      int status = run_affinity (values, &groups);
+      free (groups.members);
+      free (groups.start);
+      free (values);
+      return status;
+   }
+
+   if (EXACT_MODE)
+   {
+      int status;
+
+      sort_numbers_array (values);
+      print_numbers (values);
+      status = run_exact (values);
+      free (values);
+      return status;
+   }
+
+   /** Com -p, os números são ordenados junto com as suas posições na entrada. */
+   if (POSITIONS_MODE)
+   {
+      int status = run_positions (values);
+      free (values);
+      return status;
+   }
+
+   /** Com -m, os BINs são guardados em um pool empacotado em bits. */
+   if (COMPACT_MODE)
+   {
+      int status = run_compact (values);
+      free (values);
+      return status;
+   }
+
+   /** No esquema de aproximação os BINs são montados por run_aptas. */
+   if (APTAS_EPSILON > 0)
+   {
+      int status;
+
+      sort_numbers_array (values);
+      print_numbers (values);
+      status = run_aptas (values);
+      free (values);
+      return status;
+   }
+
+   /** Inicialisa a lista de BINs.*/
+   bins = create_empty_bin_list();
+   /** Ordena de forma descrescente os números para empacotar. */
+   sort_numbers_array (values);
+   /** Imprime os números gerados e devidamente ordenados. */
+   print_numbers(values);
+   /**
+    * Os racks e as consultas precisam de todos os BINs, então com -H ou -q nenhum BIN é
+    * aposentado por -r: uma inserção da consulta 'i' iria para um BIN já liberado.
+    */
+   if (RACK_CAPACITY > 0 || QUERY_MODE)
+      RETIRE_FLUSH = 0;
+   /** Preenche os BINS, ou seja, ler a lista de números e gera os BINs necessários. */ 
+   fill_bins (values, bins);
+   /** Com a opção -l, nivela o espaço restante dos BINs. */
+   if (LEVELING_ITERATIONS > 0)
+      level_bins (bins);
+   /** Com a opção -H, os BINs são empacotados em racks e impressos dentro de cada rack. */
+   if (RACK_CAPACITY > 0)
+   {
+      int status = run_racks (bins);
+      free_bins (bins);
+      free (values);
+      return status;
+   }
+   /** Imprime os BINs que foram gerados. */
+   print_list_bins (bins);
+   /** Com a opção -q, responde às consultas sobre os BINs que acabaram de ser gerados. */
+   if (QUERY_MODE)
+      run_queries (bins);
+   /** Por fim, libera todos os recursos que foram utilizados. */
+   free_bins (bins);
+
+   free (values);
+   return 0;
+}
+
+/**
+ * Função necessária para limpeza de dados utilizados durante a execução do programa.
+ * Todos os mallocs, reallocs são liberados aqui evitando qualquer tipo de
+ * memory leak.
+ *
+ * \param bins Ponteiro para a lista de BINs gerados pelo programa.
+ * \return Zero aopós finalizado.
+ * \see free
+ */ 
+int free_bins (bin_list *bins)
+{
+   unsigned short int i;
+
+   /** 
+    * Percorre a lista de BINs passada como parametro, para cada BIN existente
+    * é liberado o array de números que existe para armazenar os itens.
+    */
+   for (i = 0; i < bins->count; i++)
+   {
+      bin *b = (bins->itens + i);
+      free(b->itens);
+   }
+
+   /** Por fim, libera a lista de BINs utilizada pelo programa. */
+   free(bins->itens);
+   free(bins);
+
+   return 0;
+}
+
+/**
  * Método que preenche os BINs com os numeros existentes no array "values" que é
  * passado como parametro.
+ * Quando o programa é compilado com <tt>-DBIN_SIZE_FIXED=N</tt> e o BIN_SIZE informado é
+ * igual a N, usa-se a versão especializada fill_bins_fixed, gerada para essa capacidade
+ * constante. Caso contrário, usa-se o motor escolhido com <tt>-E</tt>, ou o de menor custo
+ * estimado por select_engine. Todas as versões geram exatamente os mesmos BINs.
+ *
+ * \param values Ponteiro para o array que armazena os números que devem ser empacotados nos BINs.
+ * \param bins Ponteiro para a lista contendo os BINs do programa.
+ * \return  0 - Quando a lista de BINs foi gerada com sucesso, 
+ *          1 - Quando em algum momento não foi possivel colcoar um novo BIN na lista de BINs.
+ * \see fill_bins_generic
+ * \see fill_bins_engine
+ * \see DEFINE_FILL_BINS_FIXED
+ */
+int fill_bins (unsigned short int *values, bin_list *bins)
+{
+   int engine = ENGINE;
+
+#ifdef BIN_SIZE_FIXED
+   /** A versão especializada guarda o espaço restante em fixed_item_t, então todo número precisa caber na capacidade. */
+   if (BIN_SIZE == BIN_SIZE_FIXED && (NUMBERS_QUANTITY == 0 || values[0] <= BIN_SIZE_FIXED))
+      return fill_bins_fixed(values, bins);
+#endif
+
+   if (engine == ENGINE_AUTO)
+      engine = select_engine(values, NUMBERS_QUANTITY, BIN_SIZE);
+
+   /** Apenas a versão genérica imprime os BINs aposentados (-r) e trata números maiores que o BIN. */
+   if (engine == ENGINE_LINEAR || RETIRE_FLUSH || NUMBERS_QUANTITY == 0 || values[0] > BIN_SIZE)
+      return fill_bins_generic(values, bins);
+
+   return fill_bins_engine(values, bins, engine);
+}
+
+/**
+ * Versão genérica de fill_bins, usada com qualquer BIN_SIZE.
  * Esse método é responsável por criar, se necessário, novos bins e colocar na lista de BINS.
  *
+ * Como \em values está em ordem decrescente, o menor número que ainda falta empacotar é
+ * sempre o último do array. Um BIN cujo espaço restante fica abaixo dele nunca mais
+ * recebe números, então é aposentado: sai da cadeia de BINs ativos, que é a única
+ * percorrida na busca, e, com a opção <tt>-r</tt>, já é impresso e tem seus itens liberados.
+ *
  * \param values Ponteiro para o array que armazena os números que devem ser empacotados nos BINs.
  * \param bins Ponteiro para a lista contendo os BINs do programa.
  * \return  0 - Quando a lista de BINs foi gerada com sucesso, 
  *          1 - Quando em algum momento não foi possivel colcoar um novo BIN na lista de BINs.
  * \see insert_number_bin
  * \see insert_bin_list
+ * \see retire_bin
  * \see NUMBERS_QUANTITY
  */
-int fill_bins (unsigned short int *values, bin_list *bins)
+int fill_bins_generic (unsigned short int *values, bin_list *bins)
 {
    unsigned short int i;
-   unsigned short int j;
-   char hasInserted = 1; /* 0 - conseguiu inserir, 1 - não inseriu ainda */ 
+   int j;
+   int prev;
+   int head = -1; /** Primeiro BIN ativo, -1 quando não há nenhum */
+   int tail = -1; /** Último BIN ativo, onde os BINs novos são encadeados */
+   int *next; /** Próximo BIN ativo de cada BIN, na mesma ordem da lista */
+   unsigned short int smallest;
+   char hasInserted = 0; /* 0 - conseguiu inserir, 1 - não inseriu ainda */ 
+
+   if (NUMBERS_QUANTITY == 0)
+      return 0;
+
+   next = malloc(sizeof(int)*NUMBERS_QUANTITY);
+
+   if (next == NULL)
+      exit(1);
+
+   smallest = values[NUMBERS_QUANTITY - 1];
 
    /** Percorre todos os números contidos em \em values, a fim de adionar o número em um respectivo BIN. */
    for (i = 0; i < NUMBERS_QUANTITY; i++)
    {
       unsigned short int num = values[i];
+      hasInserted = 1;
 
-      /** Para cada número, percorre por todos os BINs existentes na lista de BINs, e tenta inserir o número em algum. */
-      for (j = 0; j < bins->count; j++)
+      /** Para cada número, percorre os BINs ativos, na ordem da lista de BINs, e tenta inserir o número em algum. */
+      for (prev = -1, j = head; j != -1; prev = j, j = next[j])
       {
          bin* aux = (bins->itens + j);
 
@@ -247,7 +1606,22 @@ int fill_bins (unsigned short int *values, bin_list *bins)
 
          /* Conseguiu inserir, que bom! :^) */
          if (hasInserted == 0)
+         {
+            /** Se o BIN não comporta mais nem o menor número, ele é retirado da cadeia. */
+            if (aux->left < smallest)
+            {
+               if (prev == -1)
+                  head = next[j];
+               else
+                  next[prev] = next[j];
+
+               if (tail == j)
+                  tail = prev;
+
+               retire_bin(bins, j);
+            }
             break;
+         }
       }
 
       /**
@@ -256,18 +1630,68 @@ int fill_bins (unsigned short int *values, bin_list *bins)
        *  - Coloca esse número nele e 
        *  - Adicona o BIN criado na lista de BINs, aqui pode ocorrer de não ser possível realizar a inserção.
        *  Daí é retornado o código "1" como forma de indicar a falha.
+       *  - Encadeia o BIN no final dos BINs ativos, ou o aposenta caso já esteja cheio.
        */
       if (hasInserted == 1)
       {
          bin *b = create_empty_bin();
          insert_number_bin(b, num);
          hasInserted = insert_bin_list(bins, b);
+
+         if (hasInserted == 1)
+            break;
+
+         j = bins->count - 1;
+
+         if (bins->itens[j].left < smallest)
+         {
+            retire_bin(bins, j);
+         }
+         else
+         {
+            next[j] = -1;
+
+            if (tail == -1)
+               head = j;
+            else
+               next[tail] = j;
+
+            tail = j;
+         }
       }
    }
 
+   free(next);
    return hasInserted;
 }
 
+/**
+ * Função chamada quando um BIN é aposentado por fill_bins, isto é, quando não pode
+ * mais receber nenhum número. Com a opção <tt>-r</tt> o BIN é impresso imediatamente e
+ * seus itens são liberados, de forma que print_list_bins imprime apenas os demais.
+ *
+ * \param bins Lista de BINs.
+ * \param index Posição do BIN aposentado na lista.
+ * \return Zero após finalizado.
+ * \see RETIRE_FLUSH
+ */
+int retire_bin (bin_list *bins, int index)
+{
+   bin *b = (bins->itens + index);
+
+   if (RETIRE_FLUSH)
+   {
+      printf(" {%04d} ", index);
+      print_bin(b);
+
+      free(b->itens);
+      b->itens = NULL;
+      b->count = 0;
+   }
+
+   return 0;
+}
+
 /**
  * Método usado para mostrar os BINs que foram criados na lista de BINs.
  * Percorre a lista de BINs e para cada BIN exibe os números que existem nele,
@@ -287,6 +1711,11 @@ int print_list_bins (bin_list *bins)
    for (i = 0; i < bins->count; i++)
    {
       bin *aux = (bins->itens + i);
+
+      /** BINs sem itens já foram impressos quando aposentados (opção -r). */
+      if (aux->count == 0)
+         continue;
+
       printf(" {%04d} ", i);
       print_bin(aux);
    }
@@ -343,15 +1772,116 @@ int create_numbers_array (unsigned short int *values)
  * utilizar a menor quatidade possíveis de BINs.
  *
  * \param values Ponteiro para o array onde estão os números para serem empacotados
- * \see qsort
+ * \see sort_records_desc
  * \see NUMBERS_QUANTITY
- * \see comparison_numbers
  */
 int sort_numbers_array (unsigned short int *values)
 {
-   /** Utiliza o Quick Sort para ordernar os numeros. */
-   qsort(values, NUMBERS_QUANTITY, sizeof(int), comparison_numbers);
-   return 0;
+   /** Utiliza o radix sort dos registros, sem guardar as posições. */
+   return sort_records_desc(values, NUMBERS_QUANTITY, values, NULL, NULL);
+}
+
+/**
+ * Gera uma ordenação decrescente e estável por radix LSD sobre registros compactos do
+ * tipo \em record_t. Cada registro leva a chave, 65535 menos o número, nos 16 bits a
+ * partir de \em SHIFT, e a posição original nos bits abaixo. Os registros começam na
+ * ordem da entrada e cada passada é estável, então basta ordenar os dois bytes da chave:
+ * números iguais mantêm a ordem original. Passadas em que todos os registros têm o
+ * mesmo byte são puladas. Os dois arrays de registros vêm de \em scratch, quando
+ * informado, ou são alocados e liberados a cada chamada.
+ *
+ * \param suffix Sufixo do nome da função gerada, sort_records_<suffix>.
+ * \param record_t Tipo inteiro sem sinal do registro.
+ * \param SHIFT Bits reservados à posição, que limitam a quantidade de números a 2^SHIFT.
+ * \see sort_records_desc
+ */
+#define DEFINE_SORT_RECORDS(suffix, record_t, SHIFT)                                           \
+int sort_records_##suffix (const unsigned short int *values, unsigned long int n,               \
+                           unsigned short int *sorted, unsigned long int *positions,            \
+                           void *scratch)                                                       \
+{                                                                                              \
+   record_t *records = scratch != NULL ? scratch : malloc(sizeof(record_t)*(n + 1));           \
+   record_t *buffer = scratch != NULL ? records + n + 1 : malloc(sizeof(record_t)*(n + 1));    \
+   record_t *swap;                                                                             \
+   unsigned long int count[256];                                                               \
+   unsigned long int i;                                                                        \
+   unsigned int shift;                                                                         \
+   unsigned int d;                                                                             \
+                                                                                               \
+   if (records == NULL || buffer == NULL)                                                      \
+      exit(1);                                                                                 \
+                                                                                               \
+   for (i = 0; i < n; i++)                                                                     \
+      records[i] = (record_t) (65535 - values[i]) << SHIFT | (record_t) i;                     \
+                                                                                               \
+   for (shift = SHIFT; shift < SHIFT + 16 && n > 0; shift += 8)                                \
+   {                                                                                           \
+      unsigned long int offset = 0;                                                            \
+                                                                                               \
+      memset(count, 0, sizeof(count));                                                         \
+                                                                                               \
+      for (i = 0; i < n; i++)                                                                  \
+         count[(records[i] >> shift) & 255]++;                                                 \
+                                                                                               \
+      if (count[(records[0] >> shift) & 255] == n)                                             \
+         continue;                                                                             \
+                                                                                               \
+      for (d = 0; d < 256; d++)                                                                \
+      {                                                                                        \
+         unsigned long int c = count[d];                                                       \
+         count[d] = offset;                                                                    \
+         offset += c;                                                                          \
+      }                                                                                        \
+                                                                                               \
+      for (i = 0; i < n; i++)                                                                  \
+         buffer[count[(records[i] >> shift) & 255]++] = records[i];                            \
+                                                                                               \
+      swap = records;                                                                          \
+      records = buffer;                                                                        \
+      buffer = swap;                                                                           \
+   }                                                                                           \
+                                                                                               \
+   for (i = 0; i < n; i++)                                                                     \
+   {                                                                                           \
+      sorted[i] = 65535 - (unsigned short int) (records[i] >> SHIFT);                          \
+                                                                                               \
+      if (positions != NULL)                                                                   \
+         positions[i] = records[i] & (((record_t) 1 << SHIFT) - 1);                            \
+   }                                                                                           \
+                                                                                               \
+   if (scratch == NULL)                                                                        \
+   {                                                                                           \
+      free(records);                                                                           \
+      free(buffer);                                                                            \
+   }                                                                                           \
+                                                                                               \
+   return 0;                                                                                   \
+}
+
+DEFINE_SORT_RECORDS(32, uint32_t, 16)
+DEFINE_SORT_RECORDS(64, uint64_t, 32)
+
+/**
+ * Ordena os números de forma decrescente e estável, levando junto a posição original de
+ * cada um. Até 65536 números os registros têm 32 bits (16 de chave e 16 de posição);
+ * acima disso, 64 bits.
+ *
+ * \param values Números na ordem da entrada.
+ * \param n Quantidade de números.
+ * \param sorted Recebe os números em ordem decrescente; pode ser o próprio \em values.
+ * \param positions Recebe a posição original de cada número ordenado, ou NULL.
+ * \param scratch Área para 2 * (n + 1) registros (de 32 bits até 65536 números), ou NULL
+ *    para alocar os registros a cada chamada.
+ * \return Zero após finalizado.
+ * \see DEFINE_SORT_RECORDS
+ */
+int sort_records_desc (const unsigned short int *values, unsigned long int n, unsigned short int *sorted,
+                       unsigned long int *positions, void *scratch)
+{
+   if (n <= 65536)
+      return sort_records_32(values, n, sorted, positions, scratch);
+
+   return sort_records_64(values, n, sorted, positions, scratch);
 }
 
 /**
@@ -364,7 +1894,7 @@ int sort_numbers_array (unsigned short int *values)
  * \return Diferença entre os números
  */ 
 int comparison_numbers (const void * a, const void * b) {
-   return ( *(int*)b - *(int*)a );
+   return ( *(const unsigned short int*)b - *(const unsigned short int*)a );
 }
 
 /**
@@ -386,6 +1916,7 @@ bin* create_empty_bin ()
       exit(1);
 
    /*b->itens = itens;*/
+   b->itens = NULL;
    b->left = BIN_SIZE;
    b->count = 0;
    return b;
@@ -422,7 +1953,7 @@ int insert_number_bin (bin *b, unsigned short int num) {
 
       if (b->count == 0)
       {
-         unsigned short int *itens = malloc(sizeof(int));
+         unsigned short int *itens = malloc(sizeof(unsigned short int));
 
          if (itens == NULL)
             exit(1);
@@ -529,3 +2060,7144 @@ int print_numbers (unsigned short int *values) {
    return 0;
 }
 
+
+/**
+ * Função que interpreta a lista de capacidades informada na opção <tt>-S</tt>.
+ * Aceita uma lista separada por vírgulas (<tt>80,90,100</tt>) ou um intervalo no
+ * formato <tt>inicio:fim:passo</tt>, sendo o passo opcional.
+ *
+ * \param arg Texto informado na opção.
+ * \return 0 caso a lista seja válida, 1 caso contrário.
+ * \see SWEEP_CAPACITIES
+ * \see SWEEP_COUNT
+ */
+int parse_capacities (char *arg)
+{
+   unsigned int first, last, step = 1;
+   unsigned int c;
+   char *token;
+   char *end;
+   long int capacity;
+
+   free(SWEEP_CAPACITIES);
+   SWEEP_COUNT = 0;
+
+   if (strchr(arg, ':') != NULL)
+   {
+      if (sscanf(arg, "%u:%u:%u", &first, &last, &step) < 2 || step == 0 || first == 0 || first > last ||
+          last > 65535)
+      {
+         printf("Intervalo de capacidades inválido: %s\n", arg);
+         return 1;
+      }
+
+      SWEEP_CAPACITIES = malloc(sizeof(unsigned short int)*((last - first) / step + 1));
+
+      if (SWEEP_CAPACITIES == NULL)
+         exit(1);
+
+      for (c = first; c <= last; c += step)
+         SWEEP_CAPACITIES[SWEEP_COUNT++] = c;
+
+      return 0;
+   }
+
+   /** Cada vírgula separa uma capacidade, então há no máximo strlen/2 + 1 delas. */
+   SWEEP_CAPACITIES = malloc(sizeof(unsigned short int)*(strlen(arg) / 2 + 1));
+
+   if (SWEEP_CAPACITIES == NULL)
+      exit(1);
+
+   for (token = strtok(arg, ","); token != NULL; token = strtok(NULL, ","))
+   {
+      capacity = strtol(token, &end, 10);
+
+      if (end == token || *end != '\0' || capacity < 1 || capacity > 65535)
+      {
+         printf("Capacidade inválida: %s\n", token);
+         free(SWEEP_CAPACITIES);
+         SWEEP_CAPACITIES = NULL;
+         SWEEP_COUNT = 0;
+         return 1;
+      }
+
+      SWEEP_CAPACITIES[SWEEP_COUNT++] = capacity;
+   }
+
+   if (SWEEP_COUNT == 0)
+   {
+      printf("Lista de capacidades vazia.\n");
+      return 1;
+   }
+
+   return 0;
+}
+
+/**
+ * Função que agrupa os números já ordenados em um histograma, ou seja, cada tamanho
+ * distinto é guardado uma única vez junto com a quantidade de ocorrências.
+ *
+ * \param values Ponteiro para o array de números ordenado de forma decrescente.
+ * \param hist Histograma a ser preenchido, deve ser liberado com free_histogram.
+ * \return Zero após finalizado.
+ * \see free_histogram
+ * \see NUMBERS_QUANTITY
+ */
+int build_histogram (unsigned short int *values, size_histogram *hist)
+{
+   unsigned short int i;
+   unsigned short int distinct = 0;
+
+   for (i = 0; i < NUMBERS_QUANTITY; i++)
+      if (i == 0 || values[i] != values[i-1])
+         distinct++;
+
+   hist->sizes = malloc(sizeof(unsigned short int)*(distinct + 1));
+   hist->counts = malloc(sizeof(unsigned int)*(distinct + 1));
+
+   if (hist->sizes == NULL || hist->counts == NULL)
+      exit(1);
+
+   hist->distinct = 0;
+   hist->total = 0;
+
+   for (i = 0; i < NUMBERS_QUANTITY; i++)
+   {
+      if (i == 0 || values[i] != values[i-1])
+      {
+         hist->sizes[hist->distinct] = values[i];
+         hist->counts[hist->distinct] = 0;
+         hist->distinct++;
+      }
+
+      hist->counts[hist->distinct - 1]++;
+      hist->total += values[i];
+   }
+
+   return 0;
+}
+
+/**
+ * Libera os arrays alocados por build_histogram.
+ *
+ * \param hist Histograma a ser liberado.
+ * \return Zero após finalizado.
+ */
+int free_histogram (size_histogram *hist)
+{
+   free(hist->sizes);
+   free(hist->counts);
+   return 0;
+}
+
+/**
+ * Aplica o "First Fit Decreasing" sobre o histograma, sem guardar os itens de cada BIN.
+ * Todos os números de um mesmo tamanho são tratados de uma vez: cada BIN, em ordem,
+ * recebe tantas cópias quanto couberem, o que produz exatamente a mesma quantidade de
+ * BINs que inserir os números um a um como em fill_bins.
+ *
+ * \param hist Histograma dos números, com os tamanhos em ordem decrescente.
+ * \param capacity Capacidade de cada BIN.
+ * \param left Array auxiliar com espaço para um BIN por número, recebe o espaço
+ *    restante de cada BIN.
+ * \return A quantidade de BINs utilizados, ou -1 caso algum número não caiba na capacidade.
+ * \see build_histogram
+ */
+int pack_histogram (const size_histogram *hist, unsigned short int capacity, unsigned short int *left)
+{
+   unsigned short int d;
+   unsigned int fit;
+   int used = 0;
+   int j;
+
+   if (hist->distinct > 0 && hist->sizes[0] > capacity)
+      return -1;
+
+   for (d = 0; d < hist->distinct; d++)
+   {
+      unsigned short int size = hist->sizes[d];
+      unsigned int remaining = hist->counts[d];
+
+      /** Números de tamanho zero cabem sempre no primeiro BIN. */
+      if (size == 0)
+      {
+         if (used == 0)
+            left[used++] = capacity;
+         continue;
+      }
+
+      for (j = 0; j < used && remaining > 0; j++)
+      {
+         fit = left[j] / size;
+
+         if (fit > remaining)
+            fit = remaining;
+
+         left[j] -= fit * size;
+         remaining -= fit;
+      }
+
+      /** O que sobrou vai para BINs novos, cada um com o máximo de cópias possível. */
+      while (remaining > 0)
+      {
+         fit = capacity / size;
+
+         if (fit > remaining)
+            fit = remaining;
+
+         left[used++] = capacity - fit * size;
+         remaining -= fit;
+      }
+   }
+
+   return used;
+}
+
+/**
+ * Função executada por cada thread do modo de varredura. Enquanto houver capacidades
+ * ainda não avaliadas, pega a próxima e empacota o histograma compartilhado com ela.
+ *
+ * \param arg Ponteiro para o sweep_job compartilhado.
+ * \return NULL.
+ * \see pack_histogram
+ */
+void* sweep_worker (void *arg)
+{
+   sweep_job *job = arg;
+   unsigned short int *left = malloc(sizeof(unsigned short int)*(NUMBERS_QUANTITY + 1));
+   unsigned int k;
+
+   if (left == NULL)
+      exit(1);
+
+   /** Com o prazo vencido, nenhuma capacidade nova é pega. */
+   while (!deadline_expired(&DEADLINE))
+   {
+      pthread_mutex_lock(&job->lock);
+      k = job->next;
+      if (k < job->count)
+         job->next++;
+      pthread_mutex_unlock(&job->lock);
+
+      if (k >= job->count)
+         break;
+
+      job->results[k] = pack_histogram(job->hist, job->capacities[k], left);
+   }
+
+   free(left);
+   return NULL;
+}
+
+/**
+ * Executa o modo de varredura: monta o histograma dos números já ordenados e avalia
+ * todas as capacidades de SWEEP_CAPACITIES em paralelo, imprimindo ao final a curva
+ * de BINs por capacidade junto com o limite inferior trivial (soma / capacidade).
+ *
+ * \param values Ponteiro para o array de números ordenado de forma decrescente.
+ * \return Zero após finalizado.
+ * \see sweep_worker
+ * \see THREADS_QUANTITY
+ */
+int run_sweep (unsigned short int *values)
+{
+   size_histogram hist;
+   sweep_job job;
+   pthread_t *threads;
+   unsigned int threads_quantity = THREADS_QUANTITY;
+   unsigned int started;
+   unsigned int i;
+
+   build_histogram(values, &hist);
+
+   job.hist = &hist;
+   job.capacities = SWEEP_CAPACITIES;
+   job.count = SWEEP_COUNT;
+   job.next = 0;
+   job.results = malloc(sizeof(int)*SWEEP_COUNT);
+   pthread_mutex_init(&job.lock, NULL);
+
+   /** Capacidades não avaliadas antes do prazo ficam como -1. */
+   for (i = 0; job.results != NULL && i < SWEEP_COUNT; i++)
+      job.results[i] = -1;
+
+   if (threads_quantity == 0)
+      threads_quantity = sysconf(_SC_NPROCESSORS_ONLN);
+   if (threads_quantity > SWEEP_COUNT)
+      threads_quantity = SWEEP_COUNT;
+   if (threads_quantity == 0)
+      threads_quantity = 1;
+
+   threads = malloc(sizeof(pthread_t)*threads_quantity);
+
+   if (job.results == NULL || threads == NULL)
+      exit(1);
+
+   /** As threads pegam as capacidades de uma fila, então basta que ao menos uma execute. */
+   for (started = 0; started < threads_quantity; started++)
+      if (pthread_create(&threads[started], NULL, sweep_worker, &job) != 0)
+         break;
+
+   if (started == 0)
+      sweep_worker(&job);
+
+   for (i = 0; i < started; i++)
+      pthread_join(threads[i], NULL);
+
+   printf("\nCapacity   Bins   LowerBound\n");
+
+   for (i = 0; i < SWEEP_COUNT; i++)
+   {
+      unsigned short int capacity = SWEEP_CAPACITIES[i];
+
+      if (job.results[i] < 0 || capacity == 0)
+         printf(" %7d   %4s   %10s\n", capacity, "-", "-");
+      else
+         printf(" %7d   %4d   %10lu\n", capacity, job.results[i], (hist.total + capacity - 1) / capacity);
+   }
+
+   if (job.next < SWEEP_COUNT)
+      printf("Deadline reached: %u of %u capacities evaluated\n", job.next, SWEEP_COUNT);
+
+   printf("\n");
+
+   pthread_mutex_destroy(&job.lock);
+   free(threads);
+   free(job.results);
+   free_histogram(&hist);
+
+   return 0;
+}
+
+/**
+ * Núcleo do "First Fit Decreasing" que não aloca memória: trabalha apenas sobre os
+ * arrays passados pelo chamador e devolve, para cada número, o BIN escolhido. Assim como
+ * fill_bins_generic, percorre apenas a cadeia de BINs ativos, aposentando os que ficam
+ * com espaço menor que o último número de \em values.
+ *
+ * \param values Números ordenados de forma decrescente.
+ * \param n Quantidade de números.
+ * \param capacity Capacidade de cada BIN.
+ * \param left Array com espaço para \em n BINs, recebe o espaço restante de cada BIN.
+ * \param next Array auxiliar com espaço para \em n BINs.
+ * \param bin_of Array com espaço para \em n números, recebe o BIN de cada número.
+ * \return A quantidade de BINs utilizados.
+ * \see materialize_bins
+ */
+int first_fit_assign (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                      unsigned short int *left, int *next, unsigned short int *bin_of)
+{
+   unsigned short int i;
+   unsigned short int used = 0;
+   unsigned short int smallest;
+   int head = -1;
+   int tail = -1;
+   int prev;
+   int j;
+
+   if (n == 0)
+      return 0;
+
+   smallest = values[n - 1];
+
+   for (i = 0; i < n; i++)
+   {
+      unsigned short int num = values[i];
+
+      for (prev = -1, j = head; j != -1; prev = j, j = next[j])
+         if (left[j] >= num)
+            break;
+
+      if (j == -1)
+      {
+         j = used++;
+         left[j] = capacity;
+         next[j] = -1;
+
+         if (tail == -1)
+            head = j;
+         else
+            next[tail] = j;
+
+         prev = tail;
+         tail = j;
+      }
+
+      left[j] -= num;
+      bin_of[i] = j;
+
+      /** BIN que não comporta mais nem o menor número sai da cadeia. */
+      if (left[j] < smallest)
+      {
+         if (prev == -1)
+            head = next[j];
+         else
+            next[prev] = next[j];
+
+         if (tail == j)
+            tail = prev;
+      }
+   }
+
+   return used;
+}
+
+/**
+ * Monta os BINs a partir da escolha feita por first_fit_assign, sem alocar memória: os
+ * itens de todos os BINs são gravados de forma contígua em \em pool, e cada BIN aponta
+ * para o seu trecho. Dentro de cada BIN os itens mantém a ordem de \em values.
+ *
+ * \param values Números empacotados.
+ * \param n Quantidade de números.
+ * \param bin_of BIN de cada número.
+ * \param left Espaço restante de cada BIN.
+ * \param nbins Quantidade de BINs.
+ * \param pool Array com espaço para \em n itens.
+ * \param out Array com espaço para \em nbins BINs, recebe os BINs montados.
+ * \return Zero após finalizado.
+ * \see first_fit_assign
+ */
+int materialize_bins (const unsigned short int *values, unsigned short int n, const unsigned short int *bin_of,
+                      const unsigned short int *left, unsigned short int nbins, unsigned short int *pool, bin *out)
+{
+   unsigned short int i;
+   unsigned short int j;
+   unsigned int offset = 0;
+
+   for (j = 0; j < nbins; j++)
+   {
+      out[j].count = 0;
+      out[j].left = left[j];
+   }
+
+   for (i = 0; i < n; i++)
+      out[bin_of[i]].count++;
+
+   /** Cada BIN recebe seu trecho do pool, depois os itens são distribuídos. */
+   for (j = 0; j < nbins; j++)
+   {
+      out[j].itens = pool + offset;
+      offset += out[j].count;
+      out[j].count = 0;
+   }
+
+   for (i = 0; i < n; i++)
+   {
+      bin *b = out + bin_of[i];
+      b->itens[b->count++] = values[i];
+   }
+
+   return 0;
+}
+
+/**
+ * Garante que a área de trabalho comporte uma instância com \em n números. Os arrays só
+ * são realocados quando \em n ultrapassa a capacidade atual, com folga para evitar
+ * realocações seguidas enquanto as instâncias crescem aos poucos.
+ *
+ * \param ws Área de trabalho.
+ * \param n Quantidade de números da próxima instância.
+ * \return Zero após finalizado.
+ */
+int reserve_workspace (workspace *ws, unsigned int n)
+{
+   unsigned int capacity;
+
+   if (n > ws->peak)
+      ws->peak = n;
+
+   if (n <= ws->capacity)
+      return 0;
+
+   capacity = ws->capacity * 2 > n ? ws->capacity * 2 : n;
+
+   if (capacity > 65535)
+      capacity = 65535;
+
+   ws->values = realloc(ws->values, sizeof(unsigned short int)*capacity);
+   ws->bin_of = realloc(ws->bin_of, sizeof(unsigned short int)*capacity);
+   ws->left = realloc(ws->left, sizeof(unsigned short int)*capacity);
+   ws->next = realloc(ws->next, sizeof(int)*capacity);
+   ws->pool = realloc(ws->pool, sizeof(unsigned short int)*capacity);
+   ws->bins = realloc(ws->bins, sizeof(bin)*capacity);
+   ws->records = realloc(ws->records, sizeof(uint32_t)*2*(capacity + 1));
+
+   if (ws->values == NULL || ws->bin_of == NULL || ws->left == NULL ||
+       ws->next == NULL || ws->pool == NULL || ws->bins == NULL || ws->records == NULL)
+      exit(1);
+
+   ws->capacity = capacity;
+   return 0;
+}
+
+/**
+ * Chamada ao fim de cada instância. A cada WORKSPACE_TRIM_WINDOW instâncias, se o
+ * maior pico da janela ocupou menos de um quarto da capacidade, os arrays são reduzidos
+ * ao dobro desse pico, devolvendo a memória de uma instância grande e isolada.
+ *
+ * \param ws Área de trabalho.
+ * \return Zero após finalizado.
+ * \see WORKSPACE_TRIM_WINDOW
+ */
+int trim_workspace (workspace *ws)
+{
+   unsigned int peak = ws->peak;
+
+   if (++ws->instances < WORKSPACE_TRIM_WINDOW)
+      return 0;
+
+   ws->instances = 0;
+   ws->peak = 0;
+
+   if (peak == 0 || peak * 4 >= ws->capacity)
+      return 0;
+
+   free_workspace(ws);
+   reserve_workspace(ws, peak * 2);
+   ws->peak = 0;
+
+   return 0;
+}
+
+/**
+ * Libera os arrays da área de trabalho.
+ *
+ * \param ws Área de trabalho.
+ * \return Zero após finalizado.
+ */
+int free_workspace (workspace *ws)
+{
+   free(ws->values);
+   free(ws->bin_of);
+   free(ws->left);
+   free(ws->next);
+   free(ws->pool);
+   free(ws->bins);
+   free(ws->records);
+
+   ws->values = ws->bin_of = ws->left = ws->pool = NULL;
+   ws->next = NULL;
+   ws->bins = NULL;
+   ws->records = NULL;
+   ws->capacity = 0;
+
+   return 0;
+}
+
+/**
+ * Executa o modo em lote: cada linha da entrada padrão é uma instância no formato
+ * <tt>BIN_SIZE item item ...</tt>. O modo é sequencial e todas as instâncias usam a mesma
+ * área de trabalho, de forma que, depois das primeiras, nenhuma memória é alocada ou
+ * liberada. Uma linha com um valor fora de 0..65535 ou que não é um número é informada,
+ * com o número da linha, e ignorada.
+ *
+ * \return Zero após finalizado.
+ * \see first_fit_assign
+ * \see materialize_bins
+ * \see reserve_workspace
+ */
+int run_batch ()
+{
+   workspace ws = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, 0 };
+   char *line = NULL;
+   size_t line_size = 0;
+   unsigned int instance = 0;
+   unsigned int line_number = 0;
+
+   while (getline(&line, &line_size, stdin) != -1)
+   {
+      char *cursor = line;
+      char *end;
+      unsigned int n = 0;
+      unsigned short int nbins;
+      long value;
+      bin_list view;
+
+      line_number++;
+      value = strtol(cursor, &end, 10);
+
+      /** Linhas vazias ou sem o BIN_SIZE são ignoradas. */
+      if (end == cursor)
+         continue;
+
+      /**
+       * Conta e valida os números antes de lê-los, para reservar a área de trabalho uma
+       * única vez. O BIN_SIZE passa pela mesma validação dos itens.
+       */
+      for (;;)
+      {
+         if (value < 0 || value > 65535)
+            break;
+
+         cursor = end;
+         value = strtol(cursor, &end, 10);
+
+         if (end == cursor)
+            break;
+
+         n++;
+      }
+
+      while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n')
+         cursor++;
+
+      if (*cursor != '\0')
+      {
+         for (end = cursor; *end != '\0' && *end != ' ' && *end != '\t' && *end != '\r' && *end != '\n'; end++)
+            ;
+
+         printf("Instance %04u: valor inválido na linha %u: %.*s\n", ++instance, line_number, (int) (end - cursor),
+                cursor);
+         continue;
+      }
+
+      BIN_SIZE = strtol(line, &cursor, 10);
+
+      if (n > 65535)
+      {
+         printf("Instance %04u: mais de 65535 itens\n", ++instance);
+         continue;
+      }
+
+      reserve_workspace(&ws, n);
+
+      for (NUMBERS_QUANTITY = 0; NUMBERS_QUANTITY < n; NUMBERS_QUANTITY++)
+         ws.values[NUMBERS_QUANTITY] = strtol(cursor, &cursor, 10);
+
+      sort_records_desc(ws.values, n, ws.values, NULL, ws.records);
+
+      if (n > 0 && ws.values[0] > BIN_SIZE)
+      {
+         printf("Instance %04u: item %d maior que o BIN_SIZE %d\n", ++instance, ws.values[0], BIN_SIZE);
+         trim_workspace(&ws);
+         continue;
+      }
+
+      nbins = first_fit_assign(ws.values, n, BIN_SIZE, ws.left, ws.next, ws.bin_of);
+      materialize_bins(ws.values, n, ws.bin_of, ws.left, nbins, ws.pool, ws.bins);
+
+      printf("Instance %04u: %u itens, BIN_SIZE %d, %d BINs\n", ++instance, n, BIN_SIZE, nbins);
+      view.itens = ws.bins;
+      view.count = nbins;
+      print_list_bins(&view);
+
+      trim_workspace(&ws);
+   }
+
+   free(line);
+   free_workspace(&ws);
+
+   return 0;
+}
+
+/**
+ * Enumera, por busca em profundidade, os padrões maximais da instância arredondada, ou
+ * seja, as combinações de classes que cabem em um BIN e nas quais não cabe nem mais um
+ * número de nenhuma classe que ainda tenha números sobrando. Uma classe que caberia no
+ * espaço livre, mas que já entrou com todos os seus números, não impede o padrão de ser
+ * maximal. A enumeração para ao atingir APTAS_MAX_PATTERNS padrões. A tabela de padrões
+ * começa vazia e dobra de tamanho quando enche, acompanhando a quantidade real.
+ *
+ * \param ctx Estado do esquema de aproximação.
+ * \param t Classe sendo decidida.
+ * \param slack Espaço ainda livre no BIN do padrão em construção.
+ * \return Zero após finalizado.
+ * \see run_aptas
+ */
+int aptas_enumerate (aptas_context *ctx, unsigned short int t, unsigned int slack)
+{
+   unsigned short int k;
+   unsigned short int most;
+
+   if (ctx->count >= APTAS_MAX_PATTERNS || DEADLINE_POLL(&DEADLINE, ctx->ticks))
+      return 0;
+
+   if (t == ctx->classes)
+   {
+      /** Padrões vazios ou que ainda comportam mais um número de alguma classe não são guardados. */
+      if (slack == BIN_SIZE)
+         return 0;
+
+      for (k = 0; k < ctx->classes; k++)
+         if (ctx->class_size[k] <= slack && ctx->current[k] < ctx->class_count[k])
+            return 0;
+
+      if (ctx->count == ctx->allocated)
+      {
+         ctx->allocated = ctx->allocated == 0 ? 64 : 2 * ctx->allocated;
+         ctx->patterns = realloc(ctx->patterns, sizeof(unsigned short int)*ctx->classes*ctx->allocated);
+
+         if (ctx->patterns == NULL)
+            exit(1);
+      }
+
+      memcpy(ctx->patterns + (size_t) ctx->count * ctx->classes, ctx->current,
+             sizeof(unsigned short int)*ctx->classes);
+      ctx->count++;
+      return 0;
+   }
+
+   most = slack / ctx->class_size[t];
+
+   if (most > ctx->class_count[t])
+      most = ctx->class_count[t];
+
+   for (k = most + 1; k-- > 0; )
+   {
+      ctx->current[t] = k;
+      aptas_enumerate(ctx, t + 1, slack - k * ctx->class_size[t]);
+   }
+
+   ctx->current[t] = 0;
+   return 0;
+}
+
+/**
+ * Executa o esquema de aproximação assintótica (opção <tt>-a</tt>), no estilo de
+ * Fernandez de la Vega e Lueker:
+ *
+ *    1. Os números maiores que eps * BIN_SIZE são grandes. Eles são divididos, em ordem
+ *       decrescente, em grupos de ceil(eps^2 * L) números, sendo L a quantidade de grandes;
+ *    2. Cada grupo, exceto o primeiro, vira uma classe com o tamanho do seu maior número;
+ *    3. A instância arredondada é resolvida escolhendo repetidamente o padrão que mais
+ *       ocupa o BIN com a demanda restante, e aplicando-o o máximo de vezes possível;
+ *    4. Os números arredondados são trocados pelos reais, que são menores ou iguais;
+ *    5. O primeiro grupo e os números pequenos entram por "First Fit" nos BINs existentes.
+ *
+ * Ao final imprime os BINs e a distância para o limite inferior ceil(soma / BIN_SIZE).
+ *
+ * \param values Ponteiro para o array de números ordenado de forma decrescente.
+ * \return Zero após finalizado, 1 se algum número não cabe no BIN.
+ * \see aptas_enumerate
+ * \see materialize_bins
+ * \see APTAS_EPSILON
+ */
+int run_aptas (unsigned short int *values)
+{
+   aptas_context ctx;
+   unsigned short int n = NUMBERS_QUANTITY;
+   unsigned short int large = 0;
+   unsigned short int group;
+   unsigned short int *cursor; /** Próximo número real de cada classe a ser usado */
+   unsigned short int *remaining; /** Demanda ainda não atendida de cada classe */
+   unsigned short int *bin_of;
+   unsigned short int *left;
+   unsigned short int *pool;
+   unsigned short int nbins = 0;
+   unsigned short int i;
+   unsigned short int t;
+   unsigned int p;
+   unsigned long int total = 0;
+   unsigned long int lower;
+   bin_list view;
+   fit_index idx;
+
+   if (n == 0)
+      return 0;
+
+   if (values[0] > BIN_SIZE)
+   {
+      printf("O número %d não cabe em um BIN de tamanho %d.\n", values[0], BIN_SIZE);
+      return 1;
+   }
+
+   while (large < n && values[large] > APTAS_EPSILON * BIN_SIZE)
+      large++;
+
+   group = ceil(APTAS_EPSILON * APTAS_EPSILON * large);
+
+   if (group == 0)
+      group = 1;
+
+   ctx.classes = large > group ? (large - group + group - 1) / group : 0;
+   ctx.class_size = malloc(sizeof(unsigned short int)*(ctx.classes + 1));
+   ctx.class_count = malloc(sizeof(unsigned short int)*(ctx.classes + 1));
+   ctx.current = calloc(ctx.classes + 1, sizeof(unsigned short int));
+   cursor = malloc(sizeof(unsigned short int)*(ctx.classes + 1));
+   remaining = malloc(sizeof(unsigned short int)*(ctx.classes + 1));
+   bin_of = malloc(sizeof(unsigned short int)*n);
+   left = malloc(sizeof(unsigned short int)*n);
+   pool = malloc(sizeof(unsigned short int)*n);
+   view.itens = malloc(sizeof(bin)*n);
+
+   if (ctx.class_size == NULL || ctx.class_count == NULL || ctx.current == NULL || cursor == NULL ||
+       remaining == NULL || bin_of == NULL || left == NULL || pool == NULL || view.itens == NULL)
+      exit(1);
+
+   /** O primeiro grupo fica de fora, os demais viram classes arredondadas para cima. */
+   for (t = 0; t < ctx.classes; t++)
+   {
+      unsigned short int start = group + t * group;
+      unsigned short int end = start + group < large ? start + group : large;
+
+      ctx.class_size[t] = values[start];
+      ctx.class_count[t] = end - start;
+      cursor[t] = start;
+      remaining[t] = ctx.class_count[t];
+   }
+
+   ctx.count = 0;
+   ctx.allocated = 0;
+   ctx.ticks = 0;
+   ctx.patterns = NULL;
+
+   if (ctx.classes > 0)
+      aptas_enumerate(&ctx, 0, BIN_SIZE);
+
+   for (i = 0; i < n; i++)
+      bin_of[i] = APTAS_UNASSIGNED;
+
+   /** Escolhe, a cada passo, o padrão que mais ocupa o BIN considerando a demanda restante. */
+   for (;;)
+   {
+      unsigned int best = ctx.count;
+      unsigned long int best_fill = 0;
+      unsigned short int times = 0;
+
+      for (p = 0; p < ctx.count; p++)
+      {
+         unsigned short int *pattern = ctx.patterns + (size_t) p * ctx.classes;
+         unsigned long int fill = 0;
+
+         for (t = 0; t < ctx.classes; t++)
+            fill += (unsigned long int) (pattern[t] < remaining[t] ? pattern[t] : remaining[t]) * ctx.class_size[t];
+
+         if (fill > best_fill)
+         {
+            best_fill = fill;
+            best = p;
+         }
+      }
+
+      /** Com o prazo vencido, a demanda restante das classes segue para o "First Fit". */
+      if (best == ctx.count || deadline_expired(&DEADLINE))
+         break;
+
+      /** Quantas vezes o padrão, limitado à demanda, pode ser repetido. */
+      for (t = 0; t < ctx.classes; t++)
+      {
+         unsigned short int *pattern = ctx.patterns + (size_t) best * ctx.classes;
+         unsigned short int use = pattern[t] < remaining[t] ? pattern[t] : remaining[t];
+
+         if (use > 0 && (times == 0 || remaining[t] / use < times))
+            times = remaining[t] / use;
+      }
+
+      /** Abre um BIN por repetição, com os números reais no lugar dos arredondados. */
+      while (times-- > 0)
+      {
+         unsigned short int *pattern = ctx.patterns + (size_t) best * ctx.classes;
+
+         left[nbins] = BIN_SIZE;
+
+         for (t = 0; t < ctx.classes; t++)
+         {
+            unsigned short int use = pattern[t] < remaining[t] ? pattern[t] : remaining[t];
+
+            remaining[t] -= use;
+
+            while (use-- > 0)
+            {
+               left[nbins] -= values[cursor[t]];
+               bin_of[cursor[t]++] = nbins;
+            }
+         }
+
+         nbins++;
+      }
+   }
+
+   /**
+    * O primeiro grupo, os números pequenos e os números de classe que não foram
+    * colocados por padrões, seja pelo limite de padrões ou pelo prazo, entram por
+    * "First Fit" nos BINs já abertos, escolhidos pelo fit_index.
+    */
+   fit_index_build(&idx, NULL, 0, BIN_SIZE);
+
+   for (i = 0; i < nbins; i++)
+      fit_index_set(&idx, i, left[i]);
+
+   for (i = 0; i < n; i++)
+   {
+      int j;
+
+      if (bin_of[i] != APTAS_UNASSIGNED)
+         continue;
+
+      j = fit_index_first(&idx, values[i]);
+
+      if (j < 0)
+      {
+         j = nbins++;
+         left[j] = BIN_SIZE;
+      }
+
+      left[j] -= values[i];
+      bin_of[i] = j;
+      fit_index_set(&idx, j, left[j]);
+   }
+
+   fit_index_free_arrays(&idx);
+
+   for (i = 0; i < n; i++)
+      total += values[i];
+
+   lower = BIN_SIZE > 0 ? (total + BIN_SIZE - 1) / BIN_SIZE : 0;
+
+   materialize_bins(values, n, bin_of, left, nbins, pool, view.itens);
+   view.count = nbins;
+   print_list_bins(&view);
+
+   deadline_report(&DEADLINE, "APTAS", nbins);
+
+   printf("APTAS (eps = %.3f): %d large itens in %d classes, %u patterns%s%s\n", APTAS_EPSILON, large,
+          ctx.classes, ctx.count, ctx.count >= APTAS_MAX_PATTERNS ? " (limit reached)" : "",
+          deadline_expired(&DEADLINE) ? " (deadline reached)" : "");
+   printf("Bins: %d | LowerBound: %lu | Gap: %.2f%%\n\n", nbins, lower,
+          lower > 0 ? 100.0 * (nbins - lower) / lower : 0.0);
+
+   free(ctx.class_size);
+   free(ctx.class_count);
+   free(ctx.current);
+   free(ctx.patterns);
+   free(cursor);
+   free(remaining);
+   free(bin_of);
+   free(left);
+   free(pool);
+   free(view.itens);
+
+   return 0;
+}
+
+/**
+ * Interpreta os itens informados como argumento procurando grupos de afinidade, isto é,
+ * itens unidos por '+'. Se nenhum argumento tiver '+', nada é feito e \em groups continua
+ * vazio. Caso contrário, cada argumento vira um grupo (itens sozinhos são grupos de um
+ * item) e \em values recebe a soma de cada grupo.
+ *
+ * \param tokens Argumentos com os itens.
+ * \param ntokens Quantidade de argumentos.
+ * \param groups Grupos a serem preenchidos.
+ * \param values Array com espaço para \em ntokens números, recebe a soma de cada grupo.
+ * \return Zero após finalizado, 1 se a soma de algum grupo passa de 65535 e, portanto, não
+ *         cabe em nenhum BIN.
+ * \see run_affinity
+ */
+int parse_affinity_groups (char **tokens, unsigned short int ntokens, affinity_groups *groups, unsigned short int *values)
+{
+   unsigned short int g;
+   unsigned int total = 0;
+   char *cursor;
+
+   for (g = 0; g < ntokens; g++)
+      for (cursor = tokens[g]; *cursor != '\0'; cursor++)
+         if (*cursor == '+')
+            total++;
+
+   if (total == 0)
+      return 0;
+
+   /** Com -x, os itens são lidos de novo, um a um, então o erro de arredondamento recomeça. */
+   memset(&FIXED_ERROR, 0, sizeof(FIXED_ERROR));
+
+   total += ntokens;
+   groups->members = malloc(sizeof(unsigned short int)*total);
+   groups->start = malloc(sizeof(unsigned int)*(ntokens + 1));
+
+   if (groups->members == NULL || groups->start == NULL)
+      exit(1);
+
+   total = 0;
+
+   for (g = 0; g < ntokens; g++)
+   {
+      unsigned long int sum = 0;
+
+      groups->start[g] = total;
+      cursor = tokens[g];
+
+      do
+      {
+         groups->members[total] = parse_size(cursor, &cursor);
+         sum += groups->members[total++];
+      } while (*cursor++ == '+');
+
+      if (sum > 65535)
+      {
+         printf("O grupo %d, com soma %lu, não cabe em um BIN de tamanho %d.\n", g, sum, BIN_SIZE);
+         return 1;
+      }
+
+      values[g] = sum;
+   }
+
+   groups->start[ntokens] = total;
+   groups->count = ntokens;
+
+   return 0;
+}
+
+/**
+ * Ordena de forma decrescente os índices de \em keys, sem alterar \em keys, usando
+ * ordenação por contagem. A ordenação é estável: chaves iguais mantém a ordem original.
+ *
+ * \param keys Chaves a serem ordenadas.
+ * \param n Quantidade de chaves.
+ * \param order Array com espaço para \em n índices, recebe os índices em ordem decrescente de chave.
+ * \return Zero após finalizado.
+ */
+int sort_indices_desc (const unsigned short int *keys, unsigned short int n, unsigned short int *order)
+{
+   unsigned int *start;
+   unsigned short int largest = 0;
+   unsigned short int i;
+   unsigned int k;
+   unsigned int offset = 0;
+
+   for (i = 0; i < n; i++)
+      if (keys[i] > largest)
+         largest = keys[i];
+
+   start = calloc((size_t) largest + 1, sizeof(unsigned int));
+
+   if (start == NULL)
+      exit(1);
+
+   for (i = 0; i < n; i++)
+      start[keys[i]]++;
+
+   /** As maiores chaves vêm primeiro, então os deslocamentos são acumulados de cima para baixo. */
+   for (k = largest + 1; k-- > 0; )
+   {
+      unsigned int count = start[k];
+      start[k] = offset;
+      offset += count;
+   }
+
+   for (i = 0; i < n; i++)
+      order[start[keys[i]]++] = i;
+
+   free(start);
+   return 0;
+}
+
+/**
+ * Empacota os grupos de afinidade. Cada grupo é tratado como um único número com a soma
+ * dos seus itens, de forma que o custo do empacotamento depende apenas da quantidade de
+ * grupos. Depois do "First Fit Decreasing" os grupos são expandidos e cada BIN recebe os
+ * itens de todos os grupos colocados nele.
+ *
+ * \param values Soma de cada grupo, na ordem em que os grupos foram informados.
+ * \param groups Grupos de afinidade.
+ * \return Zero após finalizado, 1 se algum grupo não cabe no BIN.
+ * \see parse_affinity_groups
+ * \see first_fit_assign
+ * \see materialize_bins
+ */
+int run_affinity (unsigned short int *values, const affinity_groups *groups)
+{
+   unsigned short int n = groups->count;
+   unsigned int total = groups->start[n];
+   unsigned short int *order;
+   unsigned short int *sorted;
+   unsigned short int *bin_of;
+   unsigned short int *left;
+   int *next;
+   unsigned short int *items;
+   unsigned short int *item_bin;
+   unsigned short int *pool;
+   unsigned short int nbins;
+   unsigned short int k;
+   unsigned int m;
+   unsigned int expanded = 0;
+   int status = 0;
+   bin_list view;
+
+   if (n == 0)
+      return 0;
+
+   order = malloc(sizeof(unsigned short int)*n);
+   sorted = malloc(sizeof(unsigned short int)*n);
+   bin_of = malloc(sizeof(unsigned short int)*n);
+   left = malloc(sizeof(unsigned short int)*n);
+   next = malloc(sizeof(int)*n);
+   items = malloc(sizeof(unsigned short int)*total);
+   item_bin = malloc(sizeof(unsigned short int)*total);
+   pool = malloc(sizeof(unsigned short int)*total);
+   view.itens = malloc(sizeof(bin)*n);
+
+   if (order == NULL || sorted == NULL || bin_of == NULL || left == NULL || next == NULL ||
+       items == NULL || item_bin == NULL || pool == NULL || view.itens == NULL)
+      exit(1);
+
+   sort_indices_desc(values, n, order);
+
+   for (k = 0; k < n; k++)
+      sorted[k] = values[order[k]];
+
+   print_numbers(sorted);
+
+   if (sorted[0] > BIN_SIZE)
+   {
+      printf("O grupo %d, com soma %d, não cabe em um BIN de tamanho %d.\n", order[0], sorted[0], BIN_SIZE);
+      status = 1;
+      nbins = 0;
+   }
+   else
+   {
+      nbins = first_fit_assign(sorted, n, BIN_SIZE, left, next, bin_of);
+
+      /** Expande os grupos, na ordem em que foram empacotados, mantendo o BIN de cada um. */
+      for (k = 0; k < n; k++)
+      {
+         for (m = groups->start[order[k]]; m < groups->start[order[k] + 1]; m++)
+         {
+            items[expanded] = groups->members[m];
+            item_bin[expanded++] = bin_of[k];
+         }
+      }
+
+      materialize_bins(items, total, item_bin, left, nbins, pool, view.itens);
+   }
+
+   view.count = nbins;
+   print_list_bins(&view);
+
+   free(order);
+   free(sorted);
+   free(bin_of);
+   free(left);
+   free(next);
+   free(items);
+   free(item_bin);
+   free(pool);
+   free(view.itens);
+
+   return status;
+}
+
+/**
+ * Lê as classes de BIN permitidas de cada item, informadas depois de '@' e separadas
+ * por vírgulas (<tt>30@0,2</tt>). Se nenhum argumento tiver '@', nada é feito e
+ * \em classes continua vazio.
+ *
+ * \param tokens Argumentos com os itens.
+ * \param ntokens Quantidade de argumentos.
+ * \param classes Classes a serem preenchidas.
+ * \return Zero após finalizado, 1 se alguma classe é inválida.
+ * \see run_eligible
+ */
+int parse_eligibility (char **tokens, unsigned short int ntokens, eligibility *classes)
+{
+   unsigned short int g;
+   unsigned int total = 0;
+   char *cursor;
+
+   for (g = 0; g < ntokens; g++)
+   {
+      cursor = strchr(tokens[g], '@');
+
+      if (cursor == NULL)
+         continue;
+
+      for (total++; *cursor != '\0'; cursor++)
+         if (*cursor == ',')
+            total++;
+   }
+
+   if (total == 0)
+      return 0;
+
+   classes->classes = malloc(sizeof(unsigned short int)*total);
+   classes->start = malloc(sizeof(unsigned int)*(ntokens + 1));
+
+   if (classes->classes == NULL || classes->start == NULL)
+      exit(1);
+
+   total = 0;
+   classes->class_count = 0;
+
+   for (g = 0; g < ntokens; g++)
+   {
+      classes->start[g] = total;
+      cursor = strchr(tokens[g], '@');
+
+      if (cursor == NULL)
+         continue;
+
+      do
+      {
+         char *end;
+         long int c = strtol(++cursor, &end, 10);
+
+         if (end == cursor || c < 0 || c > 65534)
+         {
+            printf("Classe de BIN inválida no item %s.\n", tokens[g]);
+            free(classes->classes);
+            free(classes->start);
+            classes->classes = NULL;
+            classes->start = NULL;
+            return 1;
+         }
+
+         classes->classes[total++] = c;
+         cursor = end;
+
+         if ((unsigned int) c + 1 > classes->class_count)
+            classes->class_count = c + 1;
+      } while (*cursor == ',');
+   }
+
+   classes->start[ntokens] = total;
+   classes->count = ntokens;
+
+   return 0;
+}
+
+/**
+ * Atualiza o espaço restante do j-ésimo BIN da classe. Se \em j for igual à quantidade
+ * de BINs da classe, o BIN é acrescentado, e a árvore dobra de tamanho quando necessário.
+ *
+ * \param idx Índice da classe.
+ * \param j Posição do BIN na classe.
+ * \param left Novo espaço restante do BIN.
+ * \param position Posição do BIN na lista, usada apenas quando ele é acrescentado.
+ * \return Zero após finalizado.
+ */
+int class_index_set (class_index *idx, unsigned int j, unsigned short int left, unsigned short int position)
+{
+   if (j == idx->count)
+   {
+      if (j == idx->leaves)
+      {
+         unsigned int leaves = idx->leaves > 0 ? 2 * idx->leaves : 1;
+         int *tree = malloc(sizeof(int)*2*leaves);
+         unsigned int k;
+
+         idx->bins = realloc(idx->bins, sizeof(unsigned short int)*leaves);
+
+         if (tree == NULL || idx->bins == NULL)
+            exit(1);
+
+         for (k = 0; k < leaves; k++)
+            tree[leaves + k] = k < idx->leaves ? idx->tree[idx->leaves + k] : -1;
+
+         max_tree_build(tree, leaves);
+
+         free(idx->tree);
+         idx->tree = tree;
+         idx->leaves = leaves;
+      }
+
+      idx->bins[j] = position;
+      idx->count++;
+   }
+
+   max_tree_set(idx->tree, idx->leaves, j, left);
+
+   return 0;
+}
+
+/**
+ * Primeiro BIN da classe, na ordem de abertura, com espaço restante maior ou igual a \em s.
+ *
+ * \param idx Índice da classe.
+ * \param s Tamanho do item.
+ * \return A posição do BIN na lista, ou -1 se o item não cabe em nenhum BIN da classe.
+ */
+int class_index_first (const class_index *idx, unsigned int s)
+{
+   size_t j;
+
+   if (idx->leaves == 0)
+      return -1;
+
+   j = max_tree_first(idx->tree, idx->leaves, (int) s);
+
+   return j == idx->leaves ? -1 : idx->bins[j];
+}
+
+/**
+ * Empacota itens com classes de BIN permitidas, por "First Fit Decreasing" restrito aos
+ * BINs elegíveis. Cada classe tem o próprio class_index, e um último índice reúne todos
+ * os BINs para os itens sem restrição; como cada classe guarda os BINs na ordem de
+ * abertura, o primeiro BIN elegível é o menor entre os primeiros de cada classe
+ * permitida, em O(k log BINs) para k classes, sem percorrer BINs não elegíveis. Sem
+ * BIN elegível, abre-se um BIN da primeira classe permitida (0 sem restrição). Com
+ * grupos de afinidade, cada grupo é uma unidade e é expandido na impressão.
+ *
+ * \param values Número (ou soma do grupo) de cada item, na ordem em que foram informados.
+ * \param groups Grupos de afinidade, vazio se nenhum item usa '+'.
+ * \param classes Classes permitidas de cada item.
+ * \return Zero após finalizado, 1 se algum item não cabe no BIN.
+ * \see parse_eligibility
+ * \see class_index_first
+ */
+int run_eligible (unsigned short int *values, const affinity_groups *groups, const eligibility *classes)
+{
+   unsigned short int n = classes->count;
+   unsigned int total = groups->count > 0 ? groups->start[n] : n;
+   unsigned short int *order = malloc(sizeof(unsigned short int)*n);
+   unsigned short int *sorted = malloc(sizeof(unsigned short int)*n);
+   unsigned short int *bin_of = malloc(sizeof(unsigned short int)*n);
+   unsigned short int *left = malloc(sizeof(unsigned short int)*n);
+   unsigned short int *bin_class = malloc(sizeof(unsigned short int)*n);
+   unsigned int *bin_slot = malloc(sizeof(unsigned int)*n);
+   unsigned short int *items = malloc(sizeof(unsigned short int)*total);
+   unsigned short int *item_bin = malloc(sizeof(unsigned short int)*total);
+   unsigned short int *pool = malloc(sizeof(unsigned short int)*total);
+   class_index *index = calloc(classes->class_count + 1, sizeof(class_index));
+   class_index *all = index + classes->class_count;
+   unsigned short int nbins = 0;
+   unsigned short int k;
+   unsigned int c;
+   unsigned int m;
+   unsigned int expanded = 0;
+   int status = 0;
+   bin_list view;
+
+   view.itens = malloc(sizeof(bin)*n);
+
+   if (order == NULL || sorted == NULL || bin_of == NULL || left == NULL || bin_class == NULL || bin_slot == NULL ||
+       items == NULL || item_bin == NULL || pool == NULL || index == NULL || view.itens == NULL)
+      exit(1);
+
+   sort_indices_desc(values, n, order);
+
+   for (k = 0; k < n; k++)
+      sorted[k] = values[order[k]];
+
+   print_numbers(sorted);
+
+   if (n > 0 && sorted[0] > BIN_SIZE)
+   {
+      printf("O item %d, de tamanho %d, não cabe em um BIN de tamanho %d.\n", order[0], sorted[0], BIN_SIZE);
+      n = 0;
+      status = 1;
+   }
+
+   for (k = 0; k < n; k++)
+   {
+      unsigned short int u = order[k];
+      int b = -1;
+
+      if (classes->start[u] == classes->start[u + 1])
+         b = class_index_first(all, sorted[k]);
+
+      for (m = classes->start[u]; m < classes->start[u + 1]; m++)
+      {
+         int candidate = class_index_first(&index[classes->classes[m]], sorted[k]);
+
+         if (candidate >= 0 && (b < 0 || candidate < b))
+            b = candidate;
+      }
+
+      if (b < 0)
+      {
+         b = nbins++;
+         c = classes->start[u] < classes->start[u + 1] ? classes->classes[classes->start[u]] : 0;
+         left[b] = BIN_SIZE;
+         bin_class[b] = c;
+         bin_slot[b] = index[c].count;
+         class_index_set(&index[c], bin_slot[b], left[b], b);
+         class_index_set(all, b, left[b], b);
+      }
+
+      left[b] -= sorted[k];
+      bin_of[k] = b;
+      class_index_set(&index[bin_class[b]], bin_slot[b], left[b], b);
+      class_index_set(all, b, left[b], b);
+   }
+
+   /** Expande os grupos, na ordem em que foram empacotados, mantendo o BIN de cada um. */
+   for (k = 0; k < n; k++)
+   {
+      if (groups->count == 0)
+      {
+         items[expanded] = sorted[k];
+         item_bin[expanded++] = bin_of[k];
+         continue;
+      }
+
+      for (m = groups->start[order[k]]; m < groups->start[order[k] + 1]; m++)
+      {
+         items[expanded] = groups->members[m];
+         item_bin[expanded++] = bin_of[k];
+      }
+   }
+
+   if (nbins > 0)
+      materialize_bins(items, expanded, item_bin, left, nbins, pool, view.itens);
+
+   for (k = 0; k < nbins; k++)
+   {
+      printf(" {%04d} <classe %d> ", k, bin_class[k]);
+      print_bin(view.itens + k);
+   }
+
+   printf("\n\n");
+
+   for (c = 0; c <= classes->class_count; c++)
+   {
+      free(index[c].tree);
+      free(index[c].bins);
+   }
+
+   free(order);
+   free(sorted);
+   free(bin_of);
+   free(left);
+   free(bin_class);
+   free(bin_slot);
+   free(items);
+   free(item_bin);
+   free(pool);
+   free(index);
+   free(view.itens);
+
+   return status;
+}
+
+/**
+ * Inclui um tamanho no conjunto.
+ *
+ * \param set Conjunto de tamanhos.
+ * \param size Tamanho a ser incluído.
+ * \return Zero após finalizado.
+ */
+int bitmap_set (size_bitmap *set, unsigned short int size)
+{
+   set->words[size >> 6] |= 1ULL << (size & 63);
+   set->summary[size >> 12] |= 1ULL << ((size >> 6) & 63);
+   return 0;
+}
+
+/**
+ * Remove um tamanho do conjunto.
+ *
+ * \param set Conjunto de tamanhos.
+ * \param size Tamanho a ser removido.
+ * \return Zero após finalizado.
+ */
+int bitmap_clear (size_bitmap *set, unsigned short int size)
+{
+   set->words[size >> 6] &= ~(1ULL << (size & 63));
+
+   if (set->words[size >> 6] == 0)
+      set->summary[size >> 12] &= ~(1ULL << ((size >> 6) & 63));
+
+   return 0;
+}
+
+/**
+ * Procura o maior tamanho do conjunto que não passa de \em size.
+ *
+ * \param set Conjunto de tamanhos.
+ * \param size Limite da busca.
+ * \return O tamanho encontrado, ou -1 caso não exista.
+ */
+int bitmap_predecessor (const size_bitmap *set, unsigned int size)
+{
+   int w;
+   int s;
+   unsigned long long int bits;
+
+   if (size > 65535)
+      size = 65535;
+
+   w = size >> 6;
+   bits = set->words[w] & (~0ULL >> (63 - (size & 63)));
+
+   if (bits != 0)
+      return (w << 6) + 63 - __builtin_clzll(bits);
+
+   /** Procura a palavra anterior com algum bit, primeiro no mesmo resumo, depois nos anteriores. */
+   for (s = w >> 6; s >= 0; s--)
+   {
+      bits = set->summary[s];
+
+      if (s == w >> 6)
+         bits &= (w & 63) == 0 ? 0 : ~0ULL >> (64 - (w & 63));
+
+      if (bits != 0)
+      {
+         w = (s << 6) + 63 - __builtin_clzll(bits);
+         return (w << 6) + 63 - __builtin_clzll(set->words[w]);
+      }
+   }
+
+   return -1;
+}
+
+/**
+ * Procura o menor tamanho do conjunto que é maior ou igual a \em size.
+ *
+ * \param set Conjunto de tamanhos.
+ * \param size Limite da busca.
+ * \return O tamanho encontrado, ou -1 caso não exista.
+ */
+int bitmap_successor (const size_bitmap *set, unsigned int size)
+{
+   int w;
+   int s;
+   unsigned long long int bits;
+
+   if (size > 65535)
+      return -1;
+
+   w = size >> 6;
+   bits = set->words[w] & (~0ULL << (size & 63));
+
+   if (bits != 0)
+      return (w << 6) + __builtin_ctzll(bits);
+
+   for (s = w >> 6; s < 16; s++)
+   {
+      bits = set->summary[s];
+
+      if (s == w >> 6)
+         bits &= (w & 63) == 63 ? 0 : ~0ULL << ((w & 63) + 1);
+
+      if (bits != 0)
+      {
+         w = (s << 6) + __builtin_ctzll(bits);
+         return (w << 6) + __builtin_ctzll(set->words[w]);
+      }
+   }
+
+   return -1;
+}
+
+/**
+ * Executa o modo de itens fracionáveis (opção <tt>-f</tt>). Os números são apenas
+ * contados por tamanho, o que equivale a ordená-los, e cada BIN é preenchido
+ * exatamente até BIN_SIZE, sendo impresso assim que fecha, como uma lista de fragmentos
+ * <tt>\#item=tamanho</tt> (ou <tt>\#item=parte/tamanho</tt> quando o item foi dividido).
+ * Os itens são identificados pela posição na ordem decrescente.
+ *
+ * Enquanto há espaço no BIN, coloca-se inteiro o maior item que cabe, o que fecha o BIN
+ * sem divisão sempre que existe um item do tamanho exato do espaço. Quando nenhum item
+ * cabe, divide-se o menor item maior que o espaço, e o que sobra dele abre o próximo BIN.
+ * A quantidade de BINs é sempre ceil(soma / BIN_SIZE) e cada BIN tem no máximo uma
+ * divisão; cada passo custa tempo constante graças ao size_bitmap.
+ *
+ * \param values Ponteiro para o array de números, ou NULL para ler os tamanhos da
+ *    entrada padrão.
+ * \return Zero após finalizado, 1 se um tamanho lido da entrada passa de 65535.
+ * \see size_bitmap
+ */
+int run_splittable (unsigned short int *values)
+{
+   unsigned long int *count = calloc(65536, sizeof(unsigned long int)); /** Itens restantes de cada tamanho */
+   unsigned long int *rank = malloc(sizeof(unsigned long int)*65536); /** Próxima posição de cada tamanho */
+   size_bitmap *present = calloc(1, sizeof(size_bitmap)); /** Tamanhos com itens restantes */
+   unsigned long int items = 0;
+   unsigned long int remaining;
+   unsigned long int nbins = 0;
+   unsigned long int splits = 0;
+   unsigned long int carry_rank = 0;
+   unsigned long int carry_total = 0;
+   unsigned long int carry = 0; /** Parte ainda não colocada do item dividido */
+   unsigned long int offset = 0;
+   unsigned int gap = 0;
+   unsigned int size;
+   int s;
+   char open = 0;
+
+   if (count == NULL || rank == NULL || present == NULL)
+      exit(1);
+
+   if (BIN_SIZE == 0)
+   {
+      printf("O modo de itens fracionáveis precisa de BIN_SIZE maior que zero.\n");
+      exit(1);
+   }
+
+   if (values == NULL)
+   {
+      while (scanf("%u", &size) == 1)
+      {
+         if (size > 65535)
+         {
+            printf("Tamanho inválido na entrada: %u passa de 65535.\n", size);
+            free(count);
+            free(rank);
+            free(present);
+            return 1;
+         }
+
+         count[size]++;
+         items++;
+      }
+   }
+   else
+   {
+      for (items = 0; items < NUMBERS_QUANTITY; items++)
+         count[values[items]]++;
+   }
+
+   /** Os itens de cada tamanho recebem posições consecutivas, dos maiores para os menores. */
+   for (s = 65535; s >= 0; s--)
+   {
+      rank[s] = offset;
+      offset += count[s];
+
+      if (count[s] > 0 && s > 0)
+         bitmap_set(present, s);
+   }
+
+   remaining = items - count[0];
+
+   printf("\nSplittable: %lu itens\n\n", items);
+
+   while (remaining > 0 || carry > 0)
+   {
+      unsigned long int piece;
+
+      if (!open)
+      {
+         printf(" {%04lu} Fragments: ", nbins);
+
+         /** Itens de tamanho zero não ocupam espaço e vão todos para o primeiro BIN. */
+         for (; nbins == 0 && count[0] > 0; count[0]--)
+            printf("#%lu=0, ", rank[0]++);
+
+         gap = BIN_SIZE;
+         open = 1;
+      }
+
+      if (carry > 0)
+      {
+         piece = carry < gap ? carry : gap;
+         printf("#%lu=%lu/%lu", carry_rank, piece, carry_total);
+         carry -= piece;
+         gap -= piece;
+
+         if (carry > 0)
+            splits++;
+      }
+      else
+      {
+         s = bitmap_predecessor(present, gap);
+
+         if (s > 0)
+         {
+            printf("#%lu=%d", rank[s]++, s);
+            gap -= s;
+         }
+         else
+         {
+            /** Nenhum item cabe inteiro: divide-se o menor dos que não cabem. */
+            s = bitmap_successor(present, gap + 1);
+            carry_rank = rank[s]++;
+            carry_total = s;
+            printf("#%lu=%u/%d", carry_rank, gap, s);
+            carry = s - gap;
+            gap = 0;
+            splits++;
+         }
+
+         if (--count[s] == 0)
+            bitmap_clear(present, s);
+
+         remaining--;
+      }
+
+      if (gap == 0 || (remaining == 0 && carry == 0))
+      {
+         printf(" | Left: %u\n", gap);
+         nbins++;
+         open = 0;
+      }
+      else
+      {
+         printf(", ");
+      }
+   }
+
+   if (nbins == 0 && count[0] > 0)
+   {
+      printf(" {0000} Fragments: ");
+
+      for (; count[0] > 0; count[0]--)
+         printf("#%lu=0%s", rank[0]++, count[0] > 1 ? ", " : "");
+
+      printf(" | Left: %d\n", BIN_SIZE);
+      nbins++;
+   }
+
+   printf("\nBins: %lu | Splits: %lu\n\n", nbins, splits);
+
+   free(count);
+   free(rank);
+   free(present);
+
+   return 0;
+}
+
+/**
+ * Gerador pseudo-aleatório "splitmix64". Diferente de rand, o estado é do chamador, o
+ * que permite que cada thread tenha a sua sequência, sempre a mesma para o mesmo estado.
+ *
+ * \param state Estado do gerador, atualizado a cada chamada.
+ * \return O próximo número da sequência.
+ */
+unsigned long long int random_next (unsigned long long int *state)
+{
+   unsigned long long int z = (*state += 0x9E3779B97F4A7C15ULL);
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+   return z ^ (z >> 31);
+}
+
+/**
+ * Gera a ordem usada por uma partida do modo de múltiplas partidas: uma cópia de
+ * \em values em que números vizinhos quase iguais (diferença de até
+ * BIN_SIZE / MULTISTART_NEAR_EQUAL) trocam de lugar ao acaso. A sequência depende apenas
+ * de RANDOM_SEED e de \em start, e a partida zero mantém a ordem original.
+ *
+ * \param values Números em ordem decrescente.
+ * \param n Quantidade de números.
+ * \param start Índice da partida.
+ * \param order Array com espaço para \em n números, recebe a ordem perturbada.
+ * \return Zero após finalizado.
+ */
+int perturb_order (const unsigned short int *values, unsigned short int n, unsigned int start, unsigned short int *order)
+{
+   unsigned long long int state = RANDOM_SEED ^ ((unsigned long long int) start << 32);
+   unsigned long long int bits = 0;
+   unsigned short int near = BIN_SIZE / MULTISTART_NEAR_EQUAL;
+   unsigned short int i;
+   char available = 0;
+
+   memcpy(order, values, sizeof(unsigned short int)*n);
+
+   if (start == 0)
+      return 0;
+
+   for (i = 0; i + 1 < n; i++)
+   {
+      if (order[i] - order[i+1] > near)
+         continue;
+
+      if (available == 0)
+      {
+         bits = random_next(&state);
+         available = 64;
+      }
+
+      if (bits & 1)
+      {
+         unsigned short int aux = order[i];
+         order[i] = order[i+1];
+         order[i+1] = aux;
+      }
+
+      bits >>= 1;
+      available--;
+   }
+
+   return 0;
+}
+
+/**
+ * "First Fit" sobre uma ordem qualquer de números, que desiste assim que precisaria de
+ * mais BINs que \em limit. O limite é relido a cada BIN aberto, de forma que uma partida
+ * é abandonada assim que outra thread encontra um resultado melhor. Não aposenta BINs,
+ * pois a ordem pode não ser decrescente.
+ *
+ * \param values Números, na ordem em que devem ser inseridos.
+ * \param n Quantidade de números.
+ * \param capacity Capacidade de cada BIN.
+ * \param limit Quantidade máxima de BINs, compartilhada entre as threads, ou NULL para
+ *    não limitar.
+ * \param left Array com espaço para \em n BINs, recebe o espaço restante de cada BIN.
+ * \param bin_of Array que recebe o BIN de cada número, ou NULL caso não seja necessário.
+ * \return A quantidade de BINs utilizados, ou -1 caso tenha passado de \em limit. Com
+ *    \em limit diferente de NULL a execução também é abandonada quando o prazo vence.
+ */
+int first_fit_limited (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                       atomic_int *limit, unsigned short int *left, unsigned short int *bin_of)
+{
+   unsigned short int i;
+   unsigned int ticks = 0;
+   int used = 0;
+   int j;
+
+   for (i = 0; i < n; i++)
+   {
+      if (limit != NULL && DEADLINE_POLL(&DEADLINE, ticks))
+         return -1;
+
+      for (j = 0; j < used && left[j] < values[i]; j++)
+         ;
+
+      if (j == used)
+      {
+         if (limit != NULL && used >= atomic_load_explicit(limit, memory_order_relaxed))
+            return -1;
+
+         left[used++] = capacity;
+      }
+
+      left[j] -= values[i];
+
+      if (bin_of != NULL)
+         bin_of[i] = j;
+   }
+
+   return used;
+}
+
+/**
+ * Função executada por cada thread do modo de múltiplas partidas. Pega a próxima
+ * partida, gera sua ordem e executa o "First Fit" limitado ao melhor resultado
+ * compartilhado, atualizando-o quando encontra algo melhor.
+ *
+ * \param arg Ponteiro para o multistart_job compartilhado.
+ * \return NULL.
+ * \see perturb_order
+ * \see first_fit_limited
+ */
+void* multistart_worker (void *arg)
+{
+   multistart_job *job = arg;
+   unsigned short int *order = malloc(sizeof(unsigned short int)*(NUMBERS_QUANTITY + 1));
+   unsigned short int *left = malloc(sizeof(unsigned short int)*(NUMBERS_QUANTITY + 1));
+   unsigned int start;
+
+   if (order == NULL || left == NULL)
+      exit(1);
+
+   while (!deadline_expired(&DEADLINE) && (start = atomic_fetch_add(&job->next, 1)) < MULTISTART_QUANTITY)
+   {
+      int best;
+      int used;
+
+      perturb_order(job->values, NUMBERS_QUANTITY, start, order);
+      used = first_fit_limited(order, NUMBERS_QUANTITY, BIN_SIZE, &job->best, left, NULL);
+
+      if (used < 0)
+         continue;
+
+      /** Empates ficam com a partida de menor índice, para que o resultado não dependa das threads. */
+      pthread_mutex_lock(&job->lock);
+
+      best = atomic_load(&job->best);
+
+      if (used < best || (used == best && start < job->winner))
+      {
+         atomic_store(&job->best, used);
+         job->winner = start;
+
+         if (used < best)
+            deadline_report(&DEADLINE, "Multi-start", used);
+      }
+
+      pthread_mutex_unlock(&job->lock);
+   }
+
+   free(order);
+   free(left);
+   return NULL;
+}
+
+/**
+ * Executa o modo de múltiplas partidas (opção <tt>-M</tt>). As partidas são divididas
+ * entre as threads; como uma partida só é abandonada quando passa do melhor resultado,
+ * a melhor partida nunca é abandonada e o resultado depende apenas de RANDOM_SEED.
+ * No final a melhor partida é refeita guardando os BINs, que são impressos.
+ *
+ * \param values Ponteiro para o array de números ordenado de forma decrescente.
+ * \return Zero após finalizado, 1 se algum número não cabe no BIN.
+ * \see multistart_worker
+ * \see THREADS_QUANTITY
+ */
+int run_multistart (unsigned short int *values)
+{
+   multistart_job job;
+   pthread_t *threads;
+   unsigned short int threads_quantity = THREADS_QUANTITY;
+   unsigned short int n = NUMBERS_QUANTITY;
+   unsigned short int *order;
+   unsigned short int *left;
+   unsigned short int *bin_of;
+   unsigned short int *pool;
+   bin_list view;
+   int baseline;
+   unsigned short int started;
+   unsigned short int i;
+
+   if (n > 0 && values[0] > BIN_SIZE)
+   {
+      printf("O número %d não cabe em um BIN de tamanho %d.\n", values[0], BIN_SIZE);
+      return 1;
+   }
+
+   order = malloc(sizeof(unsigned short int)*(n + 1));
+   left = malloc(sizeof(unsigned short int)*(n + 1));
+   bin_of = malloc(sizeof(unsigned short int)*(n + 1));
+   pool = malloc(sizeof(unsigned short int)*(n + 1));
+   view.itens = malloc(sizeof(bin)*(n + 1));
+
+   if (order == NULL || left == NULL || bin_of == NULL || pool == NULL || view.itens == NULL)
+      exit(1);
+
+   /** O FFD sem perturbação é o primeiro resultado conhecido. */
+   baseline = first_fit_limited(values, n, BIN_SIZE, NULL, left, NULL);
+
+   job.values = values;
+   atomic_init(&job.next, 1);
+   atomic_init(&job.best, baseline);
+   job.winner = 0;
+   pthread_mutex_init(&job.lock, NULL);
+
+   if (threads_quantity == 0)
+      threads_quantity = sysconf(_SC_NPROCESSORS_ONLN);
+   if (threads_quantity == 0)
+      threads_quantity = 1;
+
+   threads = malloc(sizeof(pthread_t)*threads_quantity);
+
+   if (threads == NULL)
+      exit(1);
+
+   /** As threads pegam as partidas de um contador, então basta que ao menos uma execute. */
+   for (started = 0; started < threads_quantity; started++)
+      if (pthread_create(&threads[started], NULL, multistart_worker, &job) != 0)
+         break;
+
+   if (started == 0)
+      multistart_worker(&job);
+
+   for (i = 0; i < started; i++)
+      pthread_join(threads[i], NULL);
+
+   perturb_order(values, n, job.winner, order);
+   view.count = first_fit_limited(order, n, BIN_SIZE, NULL, left, bin_of);
+   materialize_bins(order, n, bin_of, left, view.count, pool, view.itens);
+   print_list_bins(&view);
+
+   printf("Multi-start: %u starts, seed %llu | Best start: %u | Bins: %d | FFD: %d\n",
+          MULTISTART_QUANTITY, RANDOM_SEED, job.winner, view.count, baseline);
+
+   if (deadline_expired(&DEADLINE))
+      printf("Deadline reached: %u of %u starts run\n",
+             atomic_load(&job.next) < MULTISTART_QUANTITY ? atomic_load(&job.next) : MULTISTART_QUANTITY,
+             MULTISTART_QUANTITY);
+
+   printf("\n");
+
+   pthread_mutex_destroy(&job.lock);
+   free(threads);
+   free(order);
+   free(left);
+   free(bin_of);
+   free(pool);
+   free(view.itens);
+
+   return 0;
+}
+
+/**
+ * Soma um valor nas duas árvores de Fenwick do índice, na posição de um espaço restante.
+ *
+ * \param idx Índice de espaço restante.
+ * \param left Espaço restante.
+ * \param bins Valor somado à quantidade de BINs (1 ou -1).
+ * \return Zero após finalizado.
+ */
+int fit_index_add (fit_index *idx, unsigned short int left, int bins)
+{
+   unsigned int k;
+
+   for (k = left + 1; k <= (unsigned int) idx->capacity + 1; k += k & -k)
+   {
+      idx->bins_by_left[k] += bins;
+      idx->free_by_left[k] += (long int) bins * left;
+   }
+
+   return 0;
+}
+
+/**
+ * Monta o índice de espaço restante a partir de uma lista de BINs.
+ *
+ * \param idx Índice a ser montado, deve ser liberado com fit_index_free_arrays.
+ * \param bins BINs, na ordem da lista.
+ * \param count Quantidade de BINs.
+ * \param capacity Capacidade dos BINs.
+ * \return Zero após finalizado.
+ * \see fit_index_set
+ */
+int fit_index_build (fit_index *idx, const bin *bins, unsigned int count, unsigned short int capacity)
+{
+   unsigned int j;
+
+   idx->leaves = 1;
+   while (idx->leaves < count)
+      idx->leaves *= 2;
+
+   idx->tree = malloc(sizeof(int)*2*idx->leaves);
+   idx->bins_by_left = calloc((size_t) capacity + 2, sizeof(unsigned int));
+   idx->free_by_left = calloc((size_t) capacity + 2, sizeof(unsigned long int));
+
+   if (idx->tree == NULL || idx->bins_by_left == NULL || idx->free_by_left == NULL)
+      exit(1);
+
+   idx->capacity = capacity;
+   idx->count = count;
+
+   for (j = 0; j < idx->leaves; j++)
+      idx->tree[idx->leaves + j] = j < count ? bins[j].left : -1;
+
+   max_tree_build(idx->tree, idx->leaves);
+
+   for (j = 0; j < count; j++)
+      fit_index_add(idx, bins[j].left, 1);
+
+   return 0;
+}
+
+/**
+ * Atualiza o espaço restante do BIN \em j. Se \em j for igual à quantidade de BINs, o
+ * BIN é acrescentado ao índice, que dobra de tamanho quando necessário.
+ *
+ * \param idx Índice de espaço restante.
+ * \param j Posição do BIN.
+ * \param left Novo espaço restante do BIN.
+ * \return Zero após finalizado.
+ */
+int fit_index_set (fit_index *idx, unsigned int j, unsigned short int left)
+{
+   if (j == idx->count)
+   {
+      if (j == idx->leaves)
+      {
+         /** Dobra a quantidade de folhas, copiando as antigas e recalculando os nós internos. */
+         unsigned int k;
+         int *tree = malloc(sizeof(int)*4*idx->leaves);
+
+         if (tree == NULL)
+            exit(1);
+
+         for (k = 0; k < 2*idx->leaves; k++)
+            tree[2*idx->leaves + k] = k < idx->leaves ? idx->tree[idx->leaves + k] : -1;
+
+         free(idx->tree);
+         idx->tree = tree;
+         idx->leaves *= 2;
+         max_tree_build(tree, idx->leaves);
+      }
+
+      idx->count++;
+   }
+   else
+   {
+      fit_index_add(idx, idx->tree[idx->leaves + j], -1);
+   }
+
+   fit_index_add(idx, left, 1);
+   max_tree_set(idx->tree, idx->leaves, j, left);
+
+   return 0;
+}
+
+/**
+ * Maior item que ainda cabe em algum BIN, ou seja, o maior espaço restante.
+ *
+ * \param idx Índice de espaço restante.
+ * \return O maior espaço restante, ou -1 se não há BINs.
+ */
+int fit_index_largest (const fit_index *idx)
+{
+   return idx->tree[1];
+}
+
+/**
+ * Primeiro BIN, na ordem da lista, com espaço restante maior ou igual a \em s, isto é,
+ * o BIN que o "First Fit" escolheria para um item de tamanho \em s.
+ *
+ * \param idx Índice de espaço restante.
+ * \param s Tamanho do item.
+ * \return A posição do BIN, ou -1 se o item não cabe em nenhum.
+ */
+int fit_index_first (const fit_index *idx, unsigned int s)
+{
+   size_t j = max_tree_first(idx->tree, idx->leaves, (int) s);
+
+   return j == idx->leaves ? -1 : (int) j;
+}
+
+/**
+ * Quantidade de BINs com espaço restante maior ou igual a \em s.
+ *
+ * \param idx Índice de espaço restante.
+ * \param s Espaço mínimo.
+ * \return A quantidade de BINs.
+ */
+unsigned int fit_index_count (const fit_index *idx, unsigned int s)
+{
+   unsigned int below = 0;
+   unsigned int k;
+
+   if (s > idx->capacity)
+      return 0;
+
+   for (k = s; k > 0; k -= k & -k)
+      below += idx->bins_by_left[k];
+
+   return idx->count - below;
+}
+
+/**
+ * Espaço livre total dos BINs cujo espaço restante está entre \em a e \em b, inclusive.
+ *
+ * \param idx Índice de espaço restante.
+ * \param a Início da faixa.
+ * \param b Fim da faixa.
+ * \return A soma do espaço restante desses BINs.
+ */
+unsigned long int fit_index_free (const fit_index *idx, unsigned int a, unsigned int b)
+{
+   unsigned long int sum = 0;
+   unsigned int k;
+
+   if (b > idx->capacity)
+      b = idx->capacity;
+
+   if (a > b)
+      return 0;
+
+   for (k = b + 1; k > 0; k -= k & -k)
+      sum += idx->free_by_left[k];
+
+   for (k = a; k > 0; k -= k & -k)
+      sum -= idx->free_by_left[k];
+
+   return sum;
+}
+
+/**
+ * Libera os arrays do índice de espaço restante.
+ *
+ * \param idx Índice de espaço restante.
+ * \return Zero após finalizado.
+ */
+int fit_index_free_arrays (fit_index *idx)
+{
+   free(idx->tree);
+   free(idx->bins_by_left);
+   free(idx->free_by_left);
+   return 0;
+}
+
+/**
+ * Executa o modo de consultas (opção <tt>-q</tt>): monta o fit_index sobre os BINs já
+ * gerados e responde, uma por linha, as consultas lidas da entrada padrão. Inserções
+ * alteram os BINs e o índice, de forma que as consultas seguintes já as consideram.
+ *
+ * \param bins Lista de BINs gerada por fill_bins.
+ * \return Zero após finalizado.
+ * \see fit_index
+ */
+int run_queries (bin_list *bins)
+{
+   fit_index idx;
+   char line[128];
+   char op;
+   unsigned int a;
+   unsigned int b;
+   int fields;
+   int j;
+
+   fit_index_build(&idx, bins->itens, bins->count, BIN_SIZE);
+
+   while (fgets(line, sizeof(line), stdin) != NULL)
+   {
+      fields = sscanf(line, " %c %u %u", &op, &a, &b);
+
+      if (fields < 1)
+         continue;
+
+      /** Consultas sem todos os parâmetros são respondidas como desconhecidas. */
+      if ((op == 'r' && fields < 3) || ((op == 'c' || op == 'w' || op == 'i') && fields < 2))
+         op = '?';
+
+      switch (op)
+      {
+         case 'f':
+            printf("%d\n", fit_index_largest(&idx));
+            break;
+         case 'c':
+            printf("%u\n", fit_index_count(&idx, a));
+            break;
+         case 'r':
+            printf("%lu\n", fit_index_free(&idx, a, b));
+            break;
+         case 'w':
+            printf("%d\n", fit_index_first(&idx, a));
+            break;
+         case 'i':
+            if (a > BIN_SIZE)
+            {
+               printf("-1\n");
+               break;
+            }
+
+            j = fit_index_first(&idx, a);
+
+            /** Sem BIN com espaço, a lista cresce com um BIN vazio, até o limite do contador. */
+            if (j == -1)
+            {
+               if (bins->count == 65535)
+               {
+                  printf("-1\n");
+                  break;
+               }
+
+               bins->itens = bins->count == 0 ? malloc(sizeof(bin)) :
+                                                realloc(bins->itens, sizeof(bin)*(bins->count + 1));
+
+               if (bins->itens == NULL)
+                  exit(1);
+
+               j = bins->count++;
+               bins->itens[j].itens = NULL;
+               bins->itens[j].left = BIN_SIZE;
+               bins->itens[j].count = 0;
+            }
+
+            insert_number_bin(bins->itens + j, a);
+            fit_index_set(&idx, j, bins->itens[j].left);
+            printf("%d\n", j);
+            break;
+         default:
+            printf("?\n");
+      }
+   }
+
+   fit_index_free_arrays(&idx);
+   return 0;
+}
+
+/**
+ * Chave de um BIN no heap do nivelamento: o espaço restante com o sinal do heap.
+ */
+#define LEVEL_KEY(h, j) ((h)->sign * (int) (h)->bins[(j)].left)
+
+/**
+ * Reposiciona o BIN \em j no heap depois que seu espaço restante mudou.
+ *
+ * \param h Heap do nivelamento.
+ * \param j BIN alterado, que deve estar no heap.
+ * \return Zero após finalizado.
+ */
+int level_heap_fix (level_heap *h, int j)
+{
+   int i = h->pos[j];
+
+   /** Sobe enquanto a chave for menor que a do pai. */
+   while (i > 0 && LEVEL_KEY(h, h->heap[(i-1)/2]) > LEVEL_KEY(h, j))
+   {
+      h->heap[i] = h->heap[(i-1)/2];
+      h->pos[h->heap[i]] = i;
+      i = (i-1)/2;
+   }
+
+   /** Desce enquanto algum filho tiver chave menor. */
+   for (;;)
+   {
+      int child = 2*i + 1;
+
+      if (child >= h->size)
+         break;
+
+      if (child + 1 < h->size && LEVEL_KEY(h, h->heap[child+1]) < LEVEL_KEY(h, h->heap[child]))
+         child++;
+
+      if (LEVEL_KEY(h, h->heap[child]) >= LEVEL_KEY(h, j))
+         break;
+
+      h->heap[i] = h->heap[child];
+      h->pos[h->heap[i]] = i;
+      i = child;
+   }
+
+   h->heap[i] = j;
+   h->pos[j] = i;
+
+   return 0;
+}
+
+/**
+ * Retira o BIN \em j do heap.
+ *
+ * \param h Heap do nivelamento.
+ * \param j BIN a ser retirado, nada é feito se ele não estiver no heap.
+ * \return Zero após finalizado.
+ */
+int level_heap_remove (level_heap *h, int j)
+{
+   int i = h->pos[j];
+   int last;
+
+   if (i == -1)
+      return 0;
+
+   last = h->heap[--h->size];
+   h->pos[j] = -1;
+
+   if (last != j)
+   {
+      h->heap[i] = last;
+      h->pos[last] = i;
+      level_heap_fix(h, last);
+   }
+
+   return 0;
+}
+
+/**
+ * Variância do espaço restante dos BINs que têm itens.
+ *
+ * \param bins Lista de BINs.
+ * \return A variância.
+ */
+double residual_variance (const bin_list *bins)
+{
+   double sum = 0;
+   double squares = 0;
+   unsigned short int used = 0;
+   unsigned short int j;
+
+   for (j = 0; j < bins->count; j++)
+   {
+      if (bins->itens[j].count == 0)
+         continue;
+
+      sum += bins->itens[j].left;
+      squares += (double) bins->itens[j].left * bins->itens[j].left;
+      used++;
+   }
+
+   return used > 0 ? squares / used - (sum / used) * (sum / used) : 0;
+}
+
+/**
+ * Insere o BIN \em j no heap, caso ele ainda não esteja.
+ *
+ * \param h Heap do nivelamento.
+ * \param j BIN a ser inserido.
+ * \return Zero após finalizado.
+ */
+int level_heap_push (level_heap *h, int j)
+{
+   if (h->pos[j] != -1)
+      return 0;
+
+   h->pos[j] = h->size;
+   h->heap[h->size++] = j;
+   return level_heap_fix(h, j);
+}
+
+/**
+ * Nivelamento do espaço restante (opção <tt>-l</tt>). O FFD deixa os primeiros BINs
+ * cheios e os últimos quase vazios; aqui, a cada passo, o BIN mais cheio A e o mais
+ * vazio B são obtidos dos heaps em tempo logarítmico e, sendo d a diferença de espaço
+ * restante entre eles:
+ *    - move-se de A para B o item x < d mais próximo de d/2, que reduz a variância; ou
+ *    - troca-se um item a de A por um item b de B com 0 < a - b < d, pelo mesmo critério.
+ *
+ * Quando nada melhora o par, A é deixado de lado e tenta-se o próximo mais cheio com o
+ * mesmo B; quando nenhum A serve, B deixa de receber itens e os As deixados de lado
+ * voltam ao heap. Nenhum BIN é aberto, então a quantidade de BINs nunca aumenta (e
+ * diminui quando um BIN fica vazio). Cada passo, com ou sem movimento, conta para o
+ * limite LEVELING_ITERATIONS; o nivelamento também para quando o prazo vence.
+ *
+ * \param bins Lista de BINs gerada por fill_bins.
+ * \return Zero após finalizado.
+ * \see level_heap
+ * \see LEVELING_ITERATIONS
+ */
+int level_bins (bin_list *bins)
+{
+   level_heap fullest; /** Topo é o BIN com menos espaço restante */
+   level_heap emptiest; /** Topo é o BIN com mais espaço restante */
+   int *parked; /** BINs deixados de lado por não melhorarem o B atual */
+   int parked_count = 0;
+   unsigned int iterations = 0;
+   unsigned int ticks = 0;
+   unsigned int moves = 0;
+   unsigned int swaps = 0;
+   double before = residual_variance(bins);
+   int j;
+
+   fullest.heap = malloc(sizeof(int)*(bins->count + 1));
+   fullest.pos = malloc(sizeof(int)*(bins->count + 1));
+   emptiest.heap = malloc(sizeof(int)*(bins->count + 1));
+   emptiest.pos = malloc(sizeof(int)*(bins->count + 1));
+   parked = malloc(sizeof(int)*(bins->count + 1));
+
+   if (fullest.heap == NULL || fullest.pos == NULL || emptiest.heap == NULL || emptiest.pos == NULL || parked == NULL)
+      exit(1);
+
+   fullest.size = emptiest.size = 0;
+   fullest.sign = 1;
+   emptiest.sign = -1;
+   fullest.bins = emptiest.bins = bins->itens;
+
+   for (j = 0; j < bins->count; j++)
+      fullest.pos[j] = emptiest.pos[j] = -1;
+
+   /** BINs sem itens (já aposentados com -r) ficam de fora. */
+   for (j = 0; j < bins->count; j++)
+   {
+      if (bins->itens[j].count == 0)
+         continue;
+
+      level_heap_push(&fullest, j);
+      level_heap_push(&emptiest, j);
+   }
+
+   while (iterations++ < LEVELING_ITERATIONS && emptiest.size > 0 && !DEADLINE_POLL(&DEADLINE, ticks))
+   {
+      bin *a;
+      bin *b = bins->itens + emptiest.heap[0];
+      int d;
+      int best = -1; /** Item de A escolhido */
+      int partner = -1; /** Item de B escolhido para a troca, -1 para um movimento */
+      int best_distance;
+      int x;
+      int y;
+
+      a = fullest.size > 0 ? bins->itens + fullest.heap[0] : NULL;
+      d = a != NULL ? b->left - a->left : 0;
+
+      /** Nenhum A consegue ajudar este B: ele deixa de receber e os As voltam. */
+      if (d <= 1)
+      {
+         level_heap_remove(&emptiest, emptiest.heap[0]);
+
+         while (parked_count > 0)
+            level_heap_push(&fullest, parked[--parked_count]);
+
+         continue;
+      }
+
+      best_distance = d;
+
+      /** Movimento: o item de A que, saindo, mais aproxima os dois BINs. */
+      for (x = 0; x < a->count; x++)
+      {
+         int distance = abs(2 * a->itens[x] - d);
+
+         if (a->itens[x] < d && a->itens[x] <= b->left && distance < best_distance)
+         {
+            best = x;
+            best_distance = distance;
+         }
+      }
+
+      /** Troca: a diferença entre os itens faz o papel do item movido. */
+      for (x = 0; x < a->count; x++)
+      {
+         for (y = 0; y < b->count; y++)
+         {
+            int delta = a->itens[x] - b->itens[y];
+            int distance = abs(2 * delta - d);
+
+            if (delta > 0 && delta < d && distance < best_distance)
+            {
+               best = x;
+               partner = y;
+               best_distance = distance;
+            }
+         }
+      }
+
+      if (best == -1)
+      {
+         parked[parked_count++] = fullest.heap[0];
+         level_heap_remove(&fullest, fullest.heap[0]);
+         continue;
+      }
+
+      if (partner == -1)
+      {
+         unsigned short int item = a->itens[best];
+
+         a->itens[best] = a->itens[--a->count];
+         a->left += item;
+         insert_number_bin(b, item);
+         moves++;
+      }
+      else
+      {
+         unsigned short int item = a->itens[best];
+
+         a->itens[best] = b->itens[partner];
+         b->itens[partner] = item;
+         a->left += item - a->itens[best];
+         b->left -= item - a->itens[best];
+         swaps++;
+      }
+
+      /** B mudou, então os As deixados de lado podem voltar a servir. */
+      while (parked_count > 0)
+         level_heap_push(&fullest, parked[--parked_count]);
+
+      j = a - bins->itens;
+
+      if (a->count == 0)
+      {
+         level_heap_remove(&fullest, j);
+         level_heap_remove(&emptiest, j);
+      }
+      else
+      {
+         level_heap_fix(&fullest, j);
+         level_heap_fix(&emptiest, j);
+      }
+
+      j = b - bins->itens;
+      level_heap_fix(&fullest, j);
+      level_heap_fix(&emptiest, j);
+   }
+
+   printf("Leveling: %u moves, %u swaps | Variance: %.2f -> %.2f%s\n\n", moves, swaps, before, residual_variance(bins),
+          deadline_expired(&DEADLINE) ? " (deadline reached)" : "");
+
+   free(fullest.heap);
+   free(fullest.pos);
+   free(emptiest.heap);
+   free(emptiest.pos);
+   free(parked);
+
+   return 0;
+}
+
+/**
+ * Tenta reservar \em num de espaço no BIN \em j com compare-and-swap. Se outra thread
+ * alterar o BIN no meio do caminho, a tentativa é refeita com o novo valor.
+ *
+ * \param shared BINs compartilhados.
+ * \param j BIN onde reservar o espaço.
+ * \param num Tamanho do item.
+ * \return 0 caso tenha reservado, 1 caso o item não caiba.
+ */
+int concurrent_claim (concurrent_bins *shared, int j, unsigned short int num)
+{
+   int left = atomic_load_explicit(&shared->left[j], memory_order_relaxed);
+
+   while (left >= num)
+   {
+      if (atomic_compare_exchange_weak_explicit(&shared->left[j], &left, left - num,
+                                                memory_order_acq_rel, memory_order_relaxed))
+         return 0;
+   }
+
+   return 1;
+}
+
+/**
+ * Insere um número no conjunto compartilhado. Assim como um alocador de memória com
+ * cache por thread, tenta primeiro o BIN atual da thread, depois os CONCURRENT_WINDOW
+ * BINs abertos mais recentemente e, por fim, abre um BIN novo com uma única operação
+ * atômica sobre a quantidade de BINs abertos.
+ *
+ * \param shared BINs compartilhados.
+ * \param cached BIN atual da thread, -1 se ela ainda não tem um; é atualizado.
+ * \param num Tamanho do item, que não pode passar da capacidade.
+ * \return O BIN onde o número foi colocado.
+ * \see concurrent_claim
+ */
+int concurrent_place (concurrent_bins *shared, int *cached, unsigned short int num)
+{
+   int opened = atomic_load_explicit(&shared->opened, memory_order_acquire);
+   int j;
+
+   if (*cached != -1 && concurrent_claim(shared, *cached, num) == 0)
+      return *cached;
+
+   for (j = opened > CONCURRENT_WINDOW ? opened - CONCURRENT_WINDOW : 0; j < opened; j++)
+   {
+      if (j != *cached && concurrent_claim(shared, j, num) == 0)
+      {
+         *cached = j;
+         return j;
+      }
+   }
+
+   /** O BIN novo pertence só a esta thread até que o espaço restante seja publicado. */
+   j = atomic_fetch_add_explicit(&shared->opened, 1, memory_order_acq_rel);
+   atomic_store_explicit(&shared->left[j], shared->capacity - num, memory_order_release);
+   *cached = j;
+
+   return j;
+}
+
+/**
+ * Função executada por cada thread produtora do empacotamento concorrente.
+ *
+ * \param arg Ponteiro para o concurrent_producer da thread.
+ * \return NULL.
+ * \see concurrent_place
+ */
+void* concurrent_worker (void *arg)
+{
+   concurrent_producer *producer = arg;
+   int cached = -1;
+   unsigned int i;
+
+   for (i = producer->first; i < NUMBERS_QUANTITY; i += producer->step)
+      producer->bin_of[i] = concurrent_place(producer->shared, &cached, producer->values[i]);
+
+   return NULL;
+}
+
+/**
+ * Executa o empacotamento online concorrente (opção <tt>-c</tt>). Cada thread insere
+ * uma parte dos números, na ordem de chegada, no mesmo conjunto de BINs. Ao final os
+ * BINs são montados e impressos, junto com a vazão e a verificação de que nenhum BIN
+ * passou da capacidade.
+ *
+ * \param values Números na ordem em que foram informados.
+ * \return Zero após finalizado, 1 se algum número não cabe no BIN.
+ * \see concurrent_worker
+ * \see THREADS_QUANTITY
+ */
+int run_concurrent (unsigned short int *values)
+{
+   concurrent_bins shared;
+   concurrent_producer *producers;
+   pthread_t *threads;
+   unsigned short int threads_quantity = THREADS_QUANTITY;
+   unsigned short int n = NUMBERS_QUANTITY;
+   unsigned short int *bin_of = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int *left = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int *pool = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int started;
+   unsigned short int i;
+   unsigned int j;
+   unsigned int overfull = 0;
+   struct timespec begin;
+   struct timespec end;
+   double seconds;
+   bin_list view;
+
+   view.itens = malloc(sizeof(bin)*(n + 1));
+   shared.left = malloc(sizeof(atomic_int)*(n + 1));
+
+   if (bin_of == NULL || left == NULL || pool == NULL || view.itens == NULL || shared.left == NULL)
+      exit(1);
+
+   for (i = 0; i < n; i++)
+   {
+      if (values[i] > BIN_SIZE)
+      {
+         printf("O número %d não cabe em um BIN de tamanho %d.\n", values[i], BIN_SIZE);
+         free(shared.left);
+         free(bin_of);
+         free(left);
+         free(pool);
+         free(view.itens);
+         return 1;
+      }
+
+      atomic_init(&shared.left[i], 0);
+   }
+
+   atomic_init(&shared.opened, 0);
+   shared.capacity = BIN_SIZE;
+
+   if (threads_quantity == 0)
+      threads_quantity = sysconf(_SC_NPROCESSORS_ONLN);
+   if (threads_quantity == 0)
+      threads_quantity = 1;
+
+   threads = malloc(sizeof(pthread_t)*threads_quantity);
+   producers = malloc(sizeof(concurrent_producer)*threads_quantity);
+
+   if (threads == NULL || producers == NULL)
+      exit(1);
+
+   clock_gettime(CLOCK_MONOTONIC, &begin);
+
+   for (i = 0; i < threads_quantity; i++)
+   {
+      producers[i].shared = &shared;
+      producers[i].values = values;
+      producers[i].bin_of = bin_of;
+      producers[i].first = i;
+      producers[i].step = threads_quantity;
+   }
+
+   for (started = 0; started < threads_quantity; started++)
+      if (pthread_create(&threads[started], NULL, concurrent_worker, &producers[started]) != 0)
+         break;
+
+   /** Cada thread tem a sua parte dos números: as partes sem thread são inseridas aqui. */
+   for (i = started; i < threads_quantity; i++)
+      concurrent_worker(&producers[i]);
+
+   for (i = 0; i < started; i++)
+      pthread_join(threads[i], NULL);
+
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+   view.count = atomic_load(&shared.opened);
+
+   for (j = 0; j < view.count; j++)
+      left[j] = atomic_load(&shared.left[j]);
+
+   materialize_bins(values, n, bin_of, left, view.count, pool, view.itens);
+
+   /** Confere, a partir dos itens, que nenhum BIN passou da capacidade. */
+   for (j = 0; j < view.count; j++)
+   {
+      unsigned long int sum = 0;
+
+      for (i = 0; i < view.itens[j].count; i++)
+         sum += view.itens[j].itens[i];
+
+      if (sum > BIN_SIZE || sum + left[j] != BIN_SIZE)
+         overfull++;
+   }
+
+   print_list_bins(&view);
+
+   printf("Concurrent: %d threads | Bins: %d | Inconsistent bins: %u | %.0f placements/s\n\n",
+          threads_quantity, view.count, overfull, seconds > 0 ? n / seconds : 0.0);
+
+   free(threads);
+   free(producers);
+   free(shared.left);
+   free(bin_of);
+   free(left);
+   free(pool);
+   free(view.itens);
+
+   return 0;
+}
+
+/**
+ * Grava um evento no trace, no formato descrito em trace_record.
+ *
+ * \param file Arquivo do trace.
+ * \param record Evento a ser gravado.
+ * \return 0 caso tenha gravado, 1 em caso de erro.
+ */
+int trace_write_record (FILE *file, const trace_record *record)
+{
+   unsigned char raw[TRACE_RECORD_SIZE];
+   int k;
+
+   for (k = 0; k < 4; k++)
+   {
+      raw[k] = record->delay >> (8 * k);
+      raw[8 + k] = record->id >> (8 * k);
+   }
+
+   raw[4] = record->op;
+   raw[5] = 0;
+   raw[6] = record->size;
+   raw[7] = record->size >> 8;
+
+   return fwrite(raw, TRACE_RECORD_SIZE, 1, file) == 1 ? 0 : 1;
+}
+
+/**
+ * Lê um evento do trace.
+ *
+ * \param file Arquivo do trace.
+ * \param record Evento lido.
+ * \return 0 caso tenha lido, 1 no fim do arquivo ou em caso de erro.
+ */
+int trace_read_record (FILE *file, trace_record *record)
+{
+   unsigned char raw[TRACE_RECORD_SIZE];
+   int k;
+
+   if (fread(raw, TRACE_RECORD_SIZE, 1, file) != 1)
+      return 1;
+
+   record->delay = 0;
+   record->id = 0;
+
+   for (k = 0; k < 4; k++)
+   {
+      record->delay |= (unsigned int) raw[k] << (8 * k);
+      record->id |= (unsigned int) raw[8 + k] << (8 * k);
+   }
+
+   record->op = raw[4];
+   record->size = raw[6] | (raw[7] << 8);
+
+   return 0;
+}
+
+/**
+ * Executa a captura de trace (opção <tt>-T</tt>): converte os eventos em texto da
+ * entrada padrão para o formato binário. A quantidade de eventos no cabeçalho é
+ * preenchida no final, então o trace pode ser gravado enquanto os eventos chegam.
+ * Capacidades e tamanhos acima de 65535, que não cabem nos 16 bits do formato, são
+ * rejeitados e o trace incompleto é apagado.
+ *
+ * \return Zero após finalizado, 1 em caso de erro.
+ * \see trace_write_record
+ */
+int run_trace_capture ()
+{
+   FILE *file = fopen(TRACE_CAPTURE, "wb");
+   trace_record record;
+   char line[128];
+   unsigned char header[12];
+   unsigned int capacity = 0;
+   unsigned int size;
+   unsigned int events = 0;
+   unsigned int line_number = 0;
+   char op;
+   int k;
+
+   if (file == NULL)
+   {
+      printf("Não foi possível criar o trace %s.\n", TRACE_CAPTURE);
+      return 1;
+   }
+
+   memcpy(header, TRACE_MAGIC, 4);
+   memset(header + 4, 0, 8);
+   fwrite(header, sizeof(header), 1, file);
+
+   while (fgets(line, sizeof(line), stdin) != NULL)
+   {
+      line_number++;
+      record.delay = 0;
+      record.size = 0;
+
+      if (sscanf(line, " %c", &op) != 1)
+         continue;
+
+      if (op == 'c' && sscanf(line, " c %u", &size) == 1)
+         capacity = size;
+      else if (op == 'a' && sscanf(line, " a %u %u %u", &record.id, &size, &record.delay) >= 2)
+         record.size = size;
+      else if (op != 'd' || sscanf(line, " d %u %u", &record.id, &record.delay) < 1)
+         continue;
+
+      /** Capacidade e tamanhos são gravados em 16 bits. */
+      if (op != 'd' && size > 65535)
+      {
+         printf("Valor inválido na linha %u do trace: %u passa de 65535.\n", line_number, size);
+         fclose(file);
+         remove(TRACE_CAPTURE);
+         return 1;
+      }
+
+      if (op == 'c')
+         continue;
+
+      record.op = op;
+      trace_write_record(file, &record);
+      events++;
+   }
+
+   /** Cabeçalho: versão, BIN_SIZE e quantidade de eventos. */
+   header[4] = TRACE_VERSION;
+   header[5] = 0;
+   header[6] = capacity;
+   header[7] = capacity >> 8;
+
+   for (k = 0; k < 4; k++)
+      header[8 + k] = events >> (8 * k);
+
+   fseek(file, 0, SEEK_SET);
+   fwrite(header, sizeof(header), 1, file);
+   fclose(file);
+
+   printf("Trace %s: BIN_SIZE %u, %u events\n", TRACE_CAPTURE, capacity, events);
+   return 0;
+}
+
+/**
+ * Faixa do histograma de latência onde cai um valor.
+ *
+ * \param value Valor medido.
+ * \return O índice da faixa.
+ */
+unsigned int latency_bucket (unsigned long int value)
+{
+   unsigned int exponent;
+
+   if (value < LATENCY_SUB_BUCKETS)
+      return value;
+
+   exponent = 63 - __builtin_clzl(value);
+
+   /** Os 4 bits logo abaixo do mais alto escolhem a sub-faixa dentro da potência de dois. */
+   return (exponent - 3) * LATENCY_SUB_BUCKETS + ((value >> (exponent - 4)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+/**
+ * Registra uma medida no histograma de latência.
+ *
+ * \param h Histograma.
+ * \param value Valor medido.
+ * \return Zero após finalizado.
+ */
+int latency_record (latency_histogram *h, unsigned long int value)
+{
+   h->counts[latency_bucket(value)]++;
+   h->total++;
+
+   if (value > h->max)
+      h->max = value;
+
+   return 0;
+}
+
+/**
+ * Valor aproximado (o início da faixa) abaixo do qual está o percentual pedido das medidas.
+ *
+ * \param h Histograma.
+ * \param percentile Percentual, entre 0 e 100.
+ * \return O valor do percentil.
+ */
+unsigned long int latency_percentile (const latency_histogram *h, double percentile)
+{
+   unsigned long int target = ceil(h->total * percentile / 100.0);
+   unsigned long int seen = 0;
+   unsigned int k;
+
+   for (k = 0; k < LATENCY_BUCKETS; k++)
+   {
+      seen += h->counts[k];
+
+      if (seen >= target && seen > 0)
+      {
+         unsigned int exponent = k / LATENCY_SUB_BUCKETS + 3;
+
+         if (k < LATENCY_SUB_BUCKETS)
+            return k;
+
+         return (1UL << exponent) + (unsigned long int) (k % LATENCY_SUB_BUCKETS) * (1UL << (exponent - 4));
+      }
+   }
+
+   return h->max;
+}
+
+/**
+ * Imprime a quantidade de medidas e os principais percentis de um histograma de latência.
+ *
+ * \param name Nome da operação medida.
+ * \param h Histograma.
+ * \return Zero após finalizado.
+ */
+int print_latency (const char *name, const latency_histogram *h)
+{
+   printf("%-10s %10lu ops | p50 %7lu ns | p90 %7lu ns | p99 %7lu ns | p99.9 %7lu ns | max %7lu ns\n",
+          name, h->total, latency_percentile(h, 50), latency_percentile(h, 90),
+          latency_percentile(h, 99), latency_percentile(h, 99.9), h->max);
+   return 0;
+}
+
+/**
+ * Executa a reprodução de trace (opção <tt>-R</tt>). Cada chegada é colocada pelo
+ * "First Fit" sobre o fit_index e cada saída devolve o espaço do item ao seu BIN, de
+ * forma que BINs esvaziados voltam a ser usados. Os itens vivos ficam em uma tabela de
+ * dispersão de endereçamento aberto indexada pelo identificador. A latência de cada
+ * operação é medida com o relógio monotônico e acumulada em histogramas por tipo.
+ *
+ * \return Zero após finalizado, 1 em caso de erro.
+ * \see fit_index
+ * \see latency_histogram
+ */
+int run_trace_replay ()
+{
+   FILE *file = fopen(TRACE_REPLAY, "rb");
+   unsigned char header[12];
+   trace_record record;
+   fit_index idx;
+   latency_histogram *arrivals = calloc(1, sizeof(latency_histogram));
+   latency_histogram *departures = calloc(1, sizeof(latency_histogram));
+   unsigned int *slot_id; /** Identificador guardado em cada posição da tabela */
+   unsigned int *slot_bin; /** BIN do item, ou -1 (todos os bits) para posição livre */
+   unsigned short int *slot_size; /** Tamanho do item */
+   unsigned int *bin_items = NULL; /** Itens vivos em cada BIN */
+   unsigned int bin_items_size = 0;
+   unsigned int events;
+   unsigned int table;
+   unsigned int live = 0;
+   unsigned int busy = 0;
+   unsigned int peak = 0;
+   unsigned int rejected = 0;
+   unsigned int bin = 0;
+   unsigned short int capacity;
+   struct timespec clock;
+   struct timespec before;
+   struct timespec after;
+
+   if (file == NULL || fread(header, sizeof(header), 1, file) != 1 || memcmp(header, TRACE_MAGIC, 4) != 0 ||
+       header[4] != TRACE_VERSION)
+   {
+      printf("Trace inválido: %s\n", TRACE_REPLAY);
+
+      if (file != NULL)
+         fclose(file);
+
+      free(arrivals);
+      free(departures);
+      return 1;
+   }
+
+   capacity = header[6] | (header[7] << 8);
+   events = header[8] | (header[9] << 8) | (header[10] << 16) | ((unsigned int) header[11] << 24);
+
+   /**
+    * A tabela é dimensionada pela quantidade de eventos do cabeçalho, que precisa bater com
+    * o tamanho do arquivo: com menos posições livres que itens vivos, a sondagem linear
+    * nunca terminaria.
+    */
+   if (events > (1U << 30) || fseek(file, 0, SEEK_END) != 0 ||
+       ftell(file) != (long int) sizeof(header) + (long int) events * TRACE_RECORD_SIZE ||
+       fseek(file, sizeof(header), SEEK_SET) != 0)
+   {
+      printf("Trace inválido: %s, o cabeçalho não corresponde ao tamanho do arquivo\n", TRACE_REPLAY);
+      fclose(file);
+      free(arrivals);
+      free(departures);
+      return 1;
+   }
+
+   /** A tabela tem pelo menos o dobro de posições que eventos, e é potência de dois. */
+   for (table = 16; table < 2 * events; table *= 2)
+      ;
+
+   slot_id = malloc(sizeof(unsigned int)*table);
+   slot_bin = malloc(sizeof(unsigned int)*table);
+   slot_size = malloc(sizeof(unsigned short int)*table);
+
+   if (arrivals == NULL || departures == NULL || slot_id == NULL || slot_bin == NULL || slot_size == NULL)
+      exit(1);
+
+   memset(slot_bin, 0xFF, sizeof(unsigned int)*table);
+   fit_index_build(&idx, NULL, 0, capacity);
+   clock_gettime(CLOCK_MONOTONIC, &clock);
+
+   while (trace_read_record(file, &record) == 0)
+   {
+      unsigned int h = (record.id * 2654435761U) & (table - 1);
+
+      /** No modo de tempo real espera até o instante gravado do evento. */
+      if (TRACE_REALTIME)
+      {
+         clock.tv_nsec += (long int) record.delay * 1000;
+         clock.tv_sec += clock.tv_nsec / 1000000000;
+         clock.tv_nsec %= 1000000000;
+         clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &clock, NULL);
+      }
+
+      while (slot_bin[h] != 0xFFFFFFFFU && slot_id[h] != record.id)
+         h = (h + 1) & (table - 1);
+
+      clock_gettime(CLOCK_MONOTONIC, &before);
+
+      if (record.op == 'a')
+      {
+         int j;
+
+         if (record.size > capacity || slot_bin[h] != 0xFFFFFFFFU)
+         {
+            rejected++;
+            continue;
+         }
+
+         j = fit_index_first(&idx, record.size);
+
+         if (j == -1)
+         {
+            j = idx.count;
+            fit_index_set(&idx, j, capacity - record.size);
+         }
+         else
+         {
+            fit_index_set(&idx, j, idx.tree[idx.leaves + j] - record.size);
+         }
+
+         slot_id[h] = record.id;
+         slot_bin[h] = j;
+         slot_size[h] = record.size;
+         bin = j;
+      }
+      else
+      {
+         unsigned int j = slot_bin[h];
+         unsigned int next;
+
+         if (j == 0xFFFFFFFFU)
+         {
+            rejected++;
+            continue;
+         }
+
+         bin = j;
+
+         fit_index_set(&idx, j, idx.tree[idx.leaves + j] + slot_size[h]);
+
+         /** Remoção com deslocamento para trás, mantendo as sondagens lineares corretas. */
+         slot_bin[h] = 0xFFFFFFFFU;
+
+         for (next = (h + 1) & (table - 1); slot_bin[next] != 0xFFFFFFFFU; next = (next + 1) & (table - 1))
+         {
+            unsigned int home = (slot_id[next] * 2654435761U) & (table - 1);
+
+            if (((next - home) & (table - 1)) >= ((next - h) & (table - 1)))
+            {
+               slot_id[h] = slot_id[next];
+               slot_bin[h] = slot_bin[next];
+               slot_size[h] = slot_size[next];
+               slot_bin[next] = 0xFFFFFFFFU;
+               h = next;
+            }
+         }
+      }
+
+      clock_gettime(CLOCK_MONOTONIC, &after);
+      latency_record(record.op == 'a' ? arrivals : departures,
+                     (after.tv_sec - before.tv_sec) * 1000000000UL + after.tv_nsec - before.tv_nsec);
+
+      /** Contagem de itens por BIN, fora da medida, para saber quantos BINs estão ocupados. */
+      if (idx.count > bin_items_size)
+      {
+         bin_items = realloc(bin_items, sizeof(unsigned int)*idx.leaves);
+
+         if (bin_items == NULL)
+            exit(1);
+
+         memset(bin_items + bin_items_size, 0, sizeof(unsigned int)*(idx.leaves - bin_items_size));
+         bin_items_size = idx.leaves;
+      }
+
+      if (record.op == 'a')
+      {
+         live++;
+         busy += bin_items[bin]++ == 0;
+      }
+      else
+      {
+         live--;
+         busy -= --bin_items[bin] == 0;
+      }
+
+      if (busy > peak)
+         peak = busy;
+   }
+
+   fclose(file);
+
+   printf("\nReplay %s: BIN_SIZE %d, %u events, %u rejected\n", TRACE_REPLAY, capacity, events, rejected);
+   print_latency("arrival", arrivals);
+   print_latency("departure", departures);
+   printf("Bins opened: %u | Bins in use: %u (peak %u) | Live itens: %u\n\n", idx.count, busy, peak, live);
+
+   fit_index_free_arrays(&idx);
+   free(arrivals);
+   free(departures);
+   free(slot_id);
+   free(slot_bin);
+   free(slot_size);
+   free(bin_items);
+
+   return 0;
+}
+
+/**
+ * Função que interpreta o parâmetro da opção <tt>-o</tt>, no formato <tt>k</tt> ou
+ * <tt>k,ms</tt>.
+ *
+ * \param arg Texto informado na opção.
+ * \return 0 caso o parâmetro seja válido, 1 caso contrário.
+ * \see LOOKAHEAD_ITEMS
+ * \see LOOKAHEAD_MS
+ */
+int parse_lookahead (char *arg)
+{
+   unsigned int items;
+   unsigned int ms = 0;
+
+   if (sscanf(arg, "%u,%u", &items, &ms) < 1 || items == 0 || items > 65535)
+   {
+      printf("Parâmetro da opção -o inválido: %s\n", arg);
+      return 1;
+   }
+
+   LOOKAHEAD_ITEMS = items;
+   LOOKAHEAD_MS = ms;
+   return 0;
+}
+
+/**
+ * Esvazia o buffer do modo semi-online: ordena os itens de forma decrescente e coloca
+ * cada um pelo "First Fit" nos BINs do índice, abrindo um BIN no final quando nenhum tem
+ * espaço. Buffers de até LOOKAHEAD_INSERTION_SORT itens são ordenados por inserção, sem
+ * alocar nada; a ordenação por contagem, que custa O(maior item) em tempo e memória, só
+ * é usada em buffers maiores, onde esse custo se dilui entre os itens.
+ *
+ * \param buffer Itens guardados, na ordem de chegada.
+ * \param position Posição de cada item na entrada, usada apenas com \em bin_of, ou NULL.
+ * \param n Quantidade de itens no buffer.
+ * \param order Array com espaço para \em n índices, usado na ordenação.
+ * \param idx Índice com o espaço restante dos BINs abertos.
+ * \param bin_of Recebe o BIN de cada item pela posição na entrada, ou NULL.
+ * \return Zero após finalizado.
+ * \see sort_indices_desc
+ * \see fit_index_first
+ */
+int lookahead_flush (const unsigned short int *buffer, const unsigned int *position, unsigned short int n,
+                     unsigned short int *order, fit_index *idx, unsigned short int *bin_of)
+{
+   unsigned short int i;
+
+   if (n > LOOKAHEAD_INSERTION_SORT)
+   {
+      sort_indices_desc(buffer, n, order);
+   }
+   else
+   {
+      /** Inserção estável: itens iguais mantêm a ordem de chegada. */
+      for (i = 0; i < n; i++)
+      {
+         unsigned short int k = i;
+
+         while (k > 0 && buffer[order[k - 1]] < buffer[i])
+         {
+            order[k] = order[k - 1];
+            k--;
+         }
+
+         order[k] = i;
+      }
+   }
+
+   for (i = 0; i < n; i++)
+   {
+      unsigned short int s = buffer[order[i]];
+      int j = fit_index_first(idx, s);
+
+      if (j == -1)
+      {
+         j = idx->count;
+         fit_index_set(idx, j, idx->capacity - s);
+      }
+      else
+      {
+         fit_index_set(idx, j, idx->tree[idx->leaves + j] - s);
+      }
+
+      if (bin_of != NULL)
+         bin_of[position[order[i]]] = j;
+   }
+
+   return 0;
+}
+
+/**
+ * Executa o modo semi-online (opção <tt>-o</tt>). Os itens são guardados, na ordem de
+ * chegada, até LOOKAHEAD_ITEMS itens ou até o mais antigo esperar LOOKAHEAD_MS
+ * milissegundos, e o buffer é esvaziado por lookahead_flush nos BINs já abertos, que
+ * nunca são fechados. Lendo da entrada padrão, a espera é controlada com poll, de forma
+ * que um fluxo parado não segura os itens além do limite; nesse caso os BINs são apenas
+ * contados, pois a quantidade de itens não é conhecida.
+ *
+ * \param values Números na ordem em que foram informados, ou NULL para ler os tamanhos
+ *    da entrada padrão.
+ * \return Zero após finalizado, 1 se algum número não cabe no BIN.
+ * \see lookahead_flush
+ */
+int run_semi_online (unsigned short int *values)
+{
+   unsigned short int *buffer = malloc(sizeof(unsigned short int)*LOOKAHEAD_ITEMS);
+   unsigned int *position = malloc(sizeof(unsigned int)*LOOKAHEAD_ITEMS);
+   unsigned short int *order = malloc(sizeof(unsigned short int)*LOOKAHEAD_ITEMS);
+   unsigned short int used = 0;
+   unsigned long int items = 0;
+   unsigned long int sum = 0;
+   unsigned long int flushes = 0;
+   unsigned long int rejected = 0;
+   unsigned long int longest = 0; /** Maior espera, em microssegundos, entre a chegada e o empacotamento */
+   unsigned short int *bin_of = NULL;
+   fit_index idx;
+   struct timespec oldest;
+
+   if (buffer == NULL || position == NULL || order == NULL)
+      exit(1);
+
+   if (BIN_SIZE == 0)
+   {
+      printf("O modo semi-online precisa de BIN_SIZE maior que zero.\n");
+      exit(1);
+   }
+
+   if (values != NULL)
+   {
+      bin_of = malloc(sizeof(unsigned short int)*(NUMBERS_QUANTITY + 1));
+
+      if (bin_of == NULL)
+         exit(1);
+
+      for (items = 0; items < NUMBERS_QUANTITY; items++)
+      {
+         if (values[items] > BIN_SIZE)
+         {
+            printf("O número %d não cabe em um BIN de tamanho %d.\n", values[items], BIN_SIZE);
+            free(buffer);
+            free(position);
+            free(order);
+            free(bin_of);
+            return 1;
+         }
+      }
+   }
+
+   fit_index_build(&idx, NULL, 0, BIN_SIZE);
+
+   if (values != NULL)
+   {
+      unsigned int i;
+
+      for (i = 0; i < NUMBERS_QUANTITY; i++)
+      {
+         buffer[used] = values[i];
+         position[used++] = i;
+         sum += values[i];
+
+         if (used == LOOKAHEAD_ITEMS || i + 1 == NUMBERS_QUANTITY)
+         {
+            lookahead_flush(buffer, position, used, order, &idx, bin_of);
+            flushes++;
+            used = 0;
+         }
+      }
+   }
+   else
+   {
+      char chunk[4096];
+      struct pollfd input = { 0, POLLIN, 0 };
+      unsigned long int number = 0;
+      char digits = 0;
+      char done = 0;
+
+      while (!done)
+      {
+         ssize_t got;
+         ssize_t c;
+
+         /** Com itens esperando e limite de tempo, espera a entrada apenas pelo tempo que resta. */
+         if (used > 0 && LOOKAHEAD_MS > 0)
+         {
+            unsigned long int waited = elapsed_us(&oldest) / 1000;
+
+            if (waited >= LOOKAHEAD_MS || poll(&input, 1, LOOKAHEAD_MS - waited) == 0)
+            {
+               waited = elapsed_us(&oldest);
+               longest = waited > longest ? waited : longest;
+               lookahead_flush(buffer, NULL, used, order, &idx, NULL);
+               flushes++;
+               used = 0;
+               continue;
+            }
+         }
+
+         got = read(0, chunk, sizeof(chunk));
+         done = got <= 0;
+
+         /** O fim da entrada funciona como um separador, fechando o último número. */
+         for (c = 0; c < got || (done && c == 0); c++)
+         {
+            if (!done && chunk[c] >= '0' && chunk[c] <= '9')
+            {
+               number = number * 10 + (chunk[c] - '0');
+               number = number > 65536 ? 65536 : number;
+               digits = 1;
+               continue;
+            }
+
+            if (!digits)
+               continue;
+
+            digits = 0;
+
+            if (number > BIN_SIZE)
+            {
+               rejected++;
+               number = 0;
+               continue;
+            }
+
+            if (used == 0)
+               clock_gettime(CLOCK_MONOTONIC, &oldest);
+
+            buffer[used++] = number;
+            sum += number;
+            items++;
+            number = 0;
+
+            if (used == LOOKAHEAD_ITEMS)
+            {
+               unsigned long int waited = elapsed_us(&oldest);
+
+               longest = waited > longest ? waited : longest;
+               lookahead_flush(buffer, NULL, used, order, &idx, NULL);
+               flushes++;
+               used = 0;
+            }
+         }
+      }
+
+      if (used > 0)
+      {
+         unsigned long int waited = elapsed_us(&oldest);
+
+         longest = waited > longest ? waited : longest;
+         lookahead_flush(buffer, NULL, used, order, &idx, NULL);
+         flushes++;
+      }
+   }
+
+   /** Com os números em memória, os BINs são montados e impressos como no FFD. */
+   if (values != NULL)
+   {
+      unsigned short int *left = calloc(idx.count + 1, sizeof(unsigned short int));
+      unsigned short int *pool = malloc(sizeof(unsigned short int)*(NUMBERS_QUANTITY + 1));
+      bin_list view;
+      unsigned int j;
+
+      view.itens = malloc(sizeof(bin)*(idx.count + 1));
+      view.count = idx.count;
+
+      if (left == NULL || pool == NULL || view.itens == NULL)
+         exit(1);
+
+      for (j = 0; j < idx.count; j++)
+         left[j] = idx.tree[idx.leaves + j];
+
+      materialize_bins(values, NUMBERS_QUANTITY, bin_of, left, idx.count, pool, view.itens);
+      print_list_bins(&view);
+
+      free(left);
+      free(pool);
+      free(view.itens);
+   }
+
+   printf("Semi-online: lookahead %d itens", LOOKAHEAD_ITEMS);
+
+   if (LOOKAHEAD_MS > 0)
+      printf(" or %u ms", LOOKAHEAD_MS);
+
+   printf(" | Itens: %lu | Flushes: %lu | Bins: %u | Lower bound: %lu", items, flushes, idx.count,
+          (sum + BIN_SIZE - 1) / BIN_SIZE);
+
+   if (values == NULL)
+      printf(" | Rejected: %lu | Longest wait: %.3f ms", rejected, longest / 1000.0);
+
+   printf("\n\n");
+
+   fit_index_free_arrays(&idx);
+   free(buffer);
+   free(position);
+   free(order);
+   free(bin_of);
+
+   return 0;
+}
+
+/**
+ * Tempo decorrido desde um instante do relógio monotônico.
+ *
+ * \param since Instante inicial, obtido com clock_gettime(CLOCK_MONOTONIC, ...).
+ * \return O tempo decorrido, em microssegundos.
+ */
+unsigned long int elapsed_us (const struct timespec *since)
+{
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (now.tv_sec - since->tv_sec) * 1000000UL + (now.tv_nsec - since->tv_nsec) / 1000;
+}
+
+/**
+ * Inicia um prazo, sem callback de melhora.
+ *
+ * \param d Prazo a ser iniciado.
+ * \param limit_us Prazo em microssegundos a partir de agora, 0 sem prazo.
+ * \return Zero após finalizado.
+ */
+int deadline_start (deadline *d, unsigned long int limit_us)
+{
+   clock_gettime(CLOCK_MONOTONIC, &d->start);
+   d->limit_us = limit_us;
+   atomic_init(&d->cancelled, 0);
+   d->on_best = NULL;
+   d->context = NULL;
+   return 0;
+}
+
+/**
+ * Cancela o prazo, fazendo todos os motores pararem na próxima verificação.
+ *
+ * \param d Prazo.
+ * \return Zero após finalizado.
+ */
+int deadline_cancel (deadline *d)
+{
+   atomic_store_explicit(&d->cancelled, 1, memory_order_relaxed);
+   return 0;
+}
+
+/**
+ * Verifica se o prazo venceu ou foi cancelado. Sem prazo e sem cancelamento o custo é
+ * uma única leitura atômica; com prazo, lê também o relógio monotônico, por isso os
+ * laços internos usam DEADLINE_POLL.
+ *
+ * \param d Prazo.
+ * \return 1 caso os motores devam parar, 0 caso contrário.
+ * \see DEADLINE_POLL
+ */
+int deadline_expired (deadline *d)
+{
+   if (atomic_load_explicit(&d->cancelled, memory_order_relaxed))
+      return 1;
+
+   if (d->limit_us > 0 && elapsed_us(&d->start) >= d->limit_us)
+   {
+      deadline_cancel(d);
+      return 1;
+   }
+
+   return 0;
+}
+
+/**
+ * Informa uma melhora encontrada por um motor, repassando-a para o callback do prazo.
+ * Caso o callback retorne diferente de zero, por exemplo por considerar a solução boa
+ * o suficiente, o prazo é cancelado.
+ *
+ * \param d Prazo.
+ * \param engine Nome do motor que encontrou a melhora.
+ * \param bins Quantidade de BINs da nova melhor solução.
+ * \return Zero após finalizado.
+ */
+int deadline_report (deadline *d, const char *engine, unsigned int bins)
+{
+   if (d->on_best != NULL && d->on_best(engine, bins, d->context) != 0)
+      deadline_cancel(d);
+
+   return 0;
+}
+
+/**
+ * Callback de melhora usado com a opção <tt>-D</tt>: imprime o tempo desde o início do
+ * prazo e a nova quantidade de BINs.
+ *
+ * \param engine Nome do motor que encontrou a melhora.
+ * \param bins Quantidade de BINs da nova melhor solução.
+ * \param context Não utilizado, existe apenas para seguir a assinatura de \em on_best.
+ * \return Zero, a busca continua até o prazo.
+ */
+int report_best (const char *engine, unsigned int bins, void *context)
+{
+   (void) context;
+
+   printf(" [%9.3f ms] %s: %u bins\n", elapsed_us(&DEADLINE.start) / 1000.0, engine, bins);
+   return 0;
+}
+
+/**
+ * Motor <tt>linear</tt> do FFD sobre arrays do chamador: o mesmo percurso da cadeia de
+ * BINs ativos de fill_bins_generic, feito por first_fit_assign.
+ *
+ * \param values Números ordenados de forma decrescente.
+ * \param n Quantidade de números.
+ * \param capacity Capacidade de cada BIN.
+ * \param left Array com espaço para \em n BINs, recebe o espaço restante de cada BIN.
+ * \param bin_of Array com espaço para \em n números, recebe o BIN de cada número.
+ * \return A quantidade de BINs utilizados.
+ * \see first_fit_assign
+ */
+int ffd_linear (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                unsigned short int *left, unsigned short int *bin_of)
+{
+   int *next = malloc(sizeof(int)*(n + 1));
+   int used;
+
+   if (next == NULL)
+      exit(1);
+
+   used = first_fit_assign(values, n, capacity, left, next, bin_of);
+
+   free(next);
+   return used;
+}
+
+/**
+ * Motor <tt>block</tt> do FFD: como em fill_bins_fixed, o primeiro BIN com espaço é
+ * procurado em blocos de FIXED_SCAN_BLOCK posições sem desvios, que o compilador
+ * vetoriza, e os BINs aposentados do início do array deixam de ser percorridos.
+ *
+ * \param values Números ordenados de forma decrescente.
+ * \param n Quantidade de números.
+ * \param capacity Capacidade de cada BIN.
+ * \param left Array com espaço para \em n BINs, recebe o espaço restante de cada BIN.
+ * \param bin_of Array com espaço para \em n números, recebe o BIN de cada número.
+ * \return A quantidade de BINs utilizados.
+ * \see DEFINE_FILL_BINS_FIXED
+ */
+int ffd_block_scan (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                    unsigned short int *left, unsigned short int *bin_of)
+{
+   unsigned int i;
+   unsigned int j;
+   unsigned int k;
+   unsigned int first = 0; /** Primeiro BIN que ainda não foi aposentado */
+   unsigned int used = 0;
+   unsigned short int smallest = n > 0 ? values[n - 1] : 0;
+
+   for (i = 0; i < n; i++)
+   {
+      unsigned short int num = values[i];
+
+      for (j = first; j + FIXED_SCAN_BLOCK <= used; j += FIXED_SCAN_BLOCK)
+      {
+         char hit = 0;
+
+         for (k = 0; k < FIXED_SCAN_BLOCK; k++)
+            hit |= left[j + k] >= num;
+
+         if (hit)
+            break;
+      }
+
+      while (j < used && left[j] < num)
+         j++;
+
+      if (j == used)
+         left[used++] = capacity;
+
+      left[j] -= num;
+      bin_of[i] = j;
+
+      while (first < used && left[first] < smallest)
+         first++;
+   }
+
+   return used;
+}
+
+/**
+ * Motor <tt>tree</tt> do FFD: o primeiro BIN com espaço é encontrado no fit_index em
+ * tempo logarítmico na quantidade de BINs.
+ *
+ * \param values Números ordenados de forma decrescente.
+ * \param n Quantidade de números.
+ * \param capacity Capacidade de cada BIN.
+ * \param left Array com espaço para \em n BINs, recebe o espaço restante de cada BIN.
+ * \param bin_of Array com espaço para \em n números, recebe o BIN de cada número.
+ * \return A quantidade de BINs utilizados.
+ * \see fit_index_first
+ */
+int ffd_tree (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+              unsigned short int *left, unsigned short int *bin_of)
+{
+   fit_index idx;
+   unsigned short int i;
+   int used;
+
+   fit_index_build(&idx, NULL, 0, capacity);
+
+   for (i = 0; i < n; i++)
+   {
+      int j = fit_index_first(&idx, values[i]);
+
+      if (j == -1)
+      {
+         j = idx.count;
+         left[j] = capacity;
+      }
+
+      left[j] -= values[i];
+      fit_index_set(&idx, j, left[j]);
+      bin_of[i] = j;
+   }
+
+   used = idx.count;
+   fit_index_free_arrays(&idx);
+
+   return used;
+}
+
+/**
+ * Motor <tt>histogram</tt> do FFD: os números de um mesmo tamanho são colocados de uma
+ * vez, como em pack_histogram, com cada BIN recebendo tantas cópias quanto couberem.
+ * Como números iguais são intercambiáveis, o resultado é o mesmo de colocá-los um a um.
+ *
+ * \param values Números ordenados de forma decrescente.
+ * \param n Quantidade de números.
+ * \param capacity Capacidade de cada BIN.
+ * \param left Array com espaço para \em n BINs, recebe o espaço restante de cada BIN.
+ * \param bin_of Array com espaço para \em n números, recebe o BIN de cada número.
+ * \return A quantidade de BINs utilizados.
+ * \see pack_histogram
+ */
+int ffd_histogram (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                   unsigned short int *left, unsigned short int *bin_of)
+{
+   unsigned int i = 0;
+   unsigned int j;
+   unsigned int first = 0; /** Primeiro BIN que ainda não foi aposentado */
+   unsigned int used = 0;
+   unsigned short int smallest = n > 0 ? values[n - 1] : 0;
+
+   while (i < n)
+   {
+      unsigned short int size = values[i];
+      unsigned int end = i;
+
+      while (end < n && values[end] == size)
+         end++;
+
+      /** Números de tamanho zero cabem sempre no primeiro BIN. */
+      if (size == 0)
+      {
+         if (used == 0)
+            left[used++] = capacity;
+
+         for (; i < end; i++)
+            bin_of[i] = first;
+
+         continue;
+      }
+
+      for (j = first; j < used && i < end; j++)
+      {
+         while (left[j] >= size && i < end)
+         {
+            left[j] -= size;
+            bin_of[i++] = j;
+         }
+      }
+
+      while (i < end)
+      {
+         left[used] = capacity;
+
+         while (left[used] >= size && i < end)
+         {
+            left[used] -= size;
+            bin_of[i++] = used;
+         }
+
+         used++;
+      }
+
+      while (first < used && left[first] < smallest)
+         first++;
+   }
+
+   return used;
+}
+
+/**
+ * Motor <tt>bucket</tt> do FFD: os BINs são agrupados em baldes de ENGINE_BUCKET_SIZE
+ * BINs consecutivos, cada um com o maior espaço restante entre os seus BINs. O primeiro
+ * BIN com espaço está no primeiro balde cujo máximo comporta o número, então cada
+ * número percorre os baldes e os BINs de um único balde, sem a árvore do motor tree.
+ *
+ * \param values Números ordenados de forma decrescente.
+ * \param n Quantidade de números.
+ * \param capacity Capacidade de cada BIN.
+ * \param left Array com espaço para \em n BINs, recebe o espaço restante de cada BIN.
+ * \param bin_of Array com espaço para \em n números, recebe o BIN de cada número.
+ * \return A quantidade de BINs utilizados.
+ */
+int ffd_bucket (const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                unsigned short int *left, unsigned short int *bin_of)
+{
+   unsigned short int *bucket_max = malloc(sizeof(unsigned short int)*(n / ENGINE_BUCKET_SIZE + 1));
+   unsigned int i;
+   unsigned int b;
+   unsigned int j;
+   unsigned int end;
+   unsigned int first = 0; /** Primeiro balde que ainda não foi aposentado */
+   unsigned int used = 0;
+   unsigned short int smallest = n > 0 ? values[n - 1] : 0;
+
+   if (bucket_max == NULL)
+      exit(1);
+
+   for (i = 0; i < n; i++)
+   {
+      unsigned short int num = values[i];
+      unsigned int buckets = (used + ENGINE_BUCKET_SIZE - 1) / ENGINE_BUCKET_SIZE;
+
+      for (b = first; b < buckets && bucket_max[b] < num; b++)
+         ;
+
+      if (b == buckets)
+      {
+         j = used;
+         left[used++] = capacity;
+      }
+      else
+      {
+         for (j = b * ENGINE_BUCKET_SIZE; left[j] < num; j++)
+            ;
+      }
+
+      left[j] -= num;
+      bin_of[i] = j;
+
+      /** Recalcula o máximo do balde do BIN alterado. */
+      b = j / ENGINE_BUCKET_SIZE;
+      end = (b + 1) * ENGINE_BUCKET_SIZE < used ? (b + 1) * ENGINE_BUCKET_SIZE : used;
+      bucket_max[b] = 0;
+
+      for (j = b * ENGINE_BUCKET_SIZE; j < end; j++)
+         if (left[j] > bucket_max[b])
+            bucket_max[b] = left[j];
+
+      while (first < b && bucket_max[first] < smallest)
+         first++;
+   }
+
+   free(bucket_max);
+   return used;
+}
+
+/**
+ * Executa um dos motores do FFD sobre arrays do chamador.
+ *
+ * \param engine Motor, uma das constantes ENGINE_*.
+ * \param values Números ordenados de forma decrescente.
+ * \param n Quantidade de números.
+ * \param capacity Capacidade de cada BIN.
+ * \param left Array com espaço para \em n BINs, recebe o espaço restante de cada BIN.
+ * \param bin_of Array com espaço para \em n números, recebe o BIN de cada número.
+ * \return A quantidade de BINs utilizados.
+ */
+int run_engine (int engine, const unsigned short int *values, unsigned short int n, unsigned short int capacity,
+                unsigned short int *left, unsigned short int *bin_of)
+{
+   switch (engine)
+   {
+      case ENGINE_BLOCK:
+         return ffd_block_scan(values, n, capacity, left, bin_of);
+      case ENGINE_TREE:
+         return ffd_tree(values, n, capacity, left, bin_of);
+      case ENGINE_HISTOGRAM:
+         return ffd_histogram(values, n, capacity, left, bin_of);
+      case ENGINE_BUCKET:
+         return ffd_bucket(values, n, capacity, left, bin_of);
+      default:
+         return ffd_linear(values, n, capacity, left, bin_of);
+   }
+}
+
+/**
+ * Preenche a lista de BINs usando um dos motores do FFD. Os itens de cada BIN são
+ * alocados de uma vez, com o tamanho exato, e ficam na mesma ordem em que
+ * fill_bins_generic os colocaria, então a lista pode ser usada e liberada como qualquer
+ * outra.
+ *
+ * \param values Ponteiro para o array de números ordenado de forma decrescente.
+ * \param bins Lista de BINs vazia, a ser preenchida.
+ * \param engine Motor, uma das constantes ENGINE_*.
+ * \return Zero após finalizado.
+ * \see run_engine
+ */
+int fill_bins_engine (unsigned short int *values, bin_list *bins, int engine)
+{
+   unsigned short int n = NUMBERS_QUANTITY;
+   unsigned short int *left = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int *bin_of = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int i;
+   int used;
+   int j;
+
+   if (left == NULL || bin_of == NULL)
+      exit(1);
+
+   used = run_engine(engine, values, n, BIN_SIZE, left, bin_of);
+
+   bins->itens = malloc(sizeof(bin)*(used + 1));
+   bins->count = used;
+
+   if (bins->itens == NULL)
+      exit(1);
+
+   for (j = 0; j < used; j++)
+   {
+      bins->itens[j].left = left[j];
+      bins->itens[j].count = 0;
+   }
+
+   for (i = 0; i < n; i++)
+      bins->itens[bin_of[i]].count++;
+
+   for (j = 0; j < used; j++)
+   {
+      bins->itens[j].itens = malloc(sizeof(unsigned short int)*bins->itens[j].count);
+
+      if (bins->itens[j].itens == NULL)
+         exit(1);
+
+      bins->itens[j].count = 0;
+   }
+
+   for (i = 0; i < n; i++)
+   {
+      bin *b = bins->itens + bin_of[i];
+      b->itens[b->count++] = values[i];
+   }
+
+   free(left);
+   free(bin_of);
+
+   return 0;
+}
+
+/**
+ * Custo estimado de um motor, em segundos, a partir das características da instância.
+ * Cada motor tem um modelo de quantidade de operações, multiplicado pela constante de
+ * ENGINE_COST:
+ *    - <tt>linear</tt> e <tt>block</tt>: n * BINs, cada número percorre os BINs ativos;
+ *    - <tt>tree</tt>: n * log2(BINs), uma descida na árvore por número;
+ *    - <tt>histogram</tt>: distintos * BINs + n, uma passada nos BINs por tamanho;
+ *    - <tt>bucket</tt>: n * (BINs / ENGINE_BUCKET_SIZE + ENGINE_BUCKET_SIZE), os baldes
+ *      e depois os BINs de um balde.
+ *
+ * \param engine Motor, uma das constantes ENGINE_*.
+ * \param n Quantidade de números.
+ * \param distinct Quantidade de tamanhos distintos.
+ * \param bins Quantidade esperada de BINs.
+ * \return O custo estimado.
+ * \see ENGINE_COST
+ */
+double engine_cost (int engine, unsigned short int n, unsigned short int distinct, double bins)
+{
+   switch (engine)
+   {
+      case ENGINE_TREE:
+         return ENGINE_COST[engine] * n * log2(bins + 2);
+      case ENGINE_HISTOGRAM:
+         return ENGINE_COST[engine] * ((double) distinct * bins + n);
+      case ENGINE_BUCKET:
+         return ENGINE_COST[engine] * n * (bins / ENGINE_BUCKET_SIZE + ENGINE_BUCKET_SIZE);
+      default:
+         return ENGINE_COST[engine] * n * bins;
+   }
+}
+
+/**
+ * Escolhe o motor do FFD de menor custo estimado. As características usadas custam uma
+ * única passada sobre os números já ordenados: a quantidade de tamanhos distintos e a
+ * quantidade esperada de BINs, ceil(soma / capacidade). Na primeira chamada carrega o
+ * arquivo de calibração, se existir.
+ *
+ * \param values Números ordenados de forma decrescente.
+ * \param n Quantidade de números.
+ * \param capacity Capacidade de cada BIN.
+ * \return O motor escolhido, uma das constantes ENGINE_*.
+ * \see engine_cost
+ * \see load_engine_config
+ */
+int select_engine (const unsigned short int *values, unsigned short int n, unsigned short int capacity)
+{
+   static char loaded = 0;
+   unsigned short int distinct = 0;
+   unsigned short int i;
+   unsigned long int sum = 0;
+   double bins;
+   int best = ENGINE_LINEAR;
+   int engine;
+
+   if (!loaded)
+   {
+      load_engine_config();
+      loaded = 1;
+   }
+
+   for (i = 0; i < n; i++)
+   {
+      sum += values[i];
+
+      if (i == 0 || values[i] != values[i-1])
+         distinct++;
+   }
+
+   bins = capacity > 0 ? ceil((double) sum / capacity) : n;
+
+   for (engine = 1; engine < ENGINE_COUNT; engine++)
+      if (engine_cost(engine, n, distinct, bins) < engine_cost(best, n, distinct, bins))
+         best = engine;
+
+   if (ENGINE_VERBOSE)
+      printf("Engine: %s (n = %d, distinct = %d, expected bins = %.0f)\n\n", ENGINE_NAMES[best], n, distinct, bins);
+
+   return best;
+}
+
+/**
+ * Função que interpreta o nome do motor informado na opção <tt>-E</tt>.
+ *
+ * \param arg Nome do motor, ou <tt>auto</tt>.
+ * \return 0 caso o nome seja válido, 1 caso contrário.
+ * \see ENGINE
+ */
+int parse_engine (const char *arg)
+{
+   int engine;
+
+   ENGINE_VERBOSE = 1;
+
+   if (strcmp(arg, "auto") == 0)
+   {
+      ENGINE = ENGINE_AUTO;
+      return 0;
+   }
+
+   for (engine = 0; engine < ENGINE_COUNT; engine++)
+   {
+      if (strcmp(arg, ENGINE_NAMES[engine]) == 0)
+      {
+         ENGINE = engine;
+         return 0;
+      }
+   }
+
+   printf("Motor desconhecido: %s\n", arg);
+   return 1;
+}
+
+/**
+ * Carrega o arquivo de calibração, com uma linha <tt>nome custo</tt> por motor. Linhas
+ * começando com '#' e motores desconhecidos são ignorados.
+ *
+ * \return 0 caso tenha carregado, 1 caso o arquivo não exista.
+ * \see ENGINE_COST
+ * \see calibrate_engines
+ */
+int load_engine_config ()
+{
+   const char *path = getenv("BIN_PACKING_CONFIG") != NULL ? getenv("BIN_PACKING_CONFIG") : ENGINE_CONFIG;
+   FILE *file = fopen(path, "r");
+   char line[128];
+   char name[32];
+   double cost;
+   int engine;
+
+   if (file == NULL)
+      return 1;
+
+   while (fgets(line, sizeof(line), file) != NULL)
+   {
+      if (line[0] == '#' || sscanf(line, "%31s %lf", name, &cost) != 2 || cost <= 0)
+         continue;
+
+      for (engine = 0; engine < ENGINE_COUNT; engine++)
+         if (strcmp(name, ENGINE_NAMES[engine]) == 0)
+            ENGINE_COST[engine] = cost;
+   }
+
+   fclose(file);
+   return 0;
+}
+
+/**
+ * Executa a calibração (opção <tt>-C</tt>): cada motor empacota instâncias sintéticas
+ * de formatos variados (poucos ou muitos tamanhos distintos, poucos ou muitos BINs) e o
+ * custo por unidade do seu modelo é a mediana, entre as instâncias, do melhor de três
+ * tempos dividido pelo custo do modelo. Os custos são gravados no arquivo de calibração.
+ *
+ * \return Zero após finalizado, 1 caso não consiga gravar o arquivo.
+ * \see engine_cost
+ * \see load_engine_config
+ */
+int calibrate_engines ()
+{
+   /** Quantidade de números, capacidade, menor e maior número de cada instância. */
+   static const unsigned short int shapes[][4] = {
+      { 2000, 100, 1, 100 }, { 20000, 1000, 1, 1000 }, { 20000, 100, 20, 100 },
+      { 20000, 60000, 1, 6000 }, { 10000, 60000, 1, 60000 }, { 20000, 1000, 1, 10 },
+      { 5000, 60000, 20000, 60000 }
+   };
+   const unsigned int count = sizeof(shapes) / sizeof(shapes[0]);
+   const char *path = getenv("BIN_PACKING_CONFIG") != NULL ? getenv("BIN_PACKING_CONFIG") : ENGINE_CONFIG;
+   unsigned short int *values = malloc(sizeof(unsigned short int)*65536);
+   unsigned short int *left = malloc(sizeof(unsigned short int)*65536);
+   unsigned short int *bin_of = malloc(sizeof(unsigned short int)*65536);
+   double ratios[ENGINE_COUNT][sizeof(shapes) / sizeof(shapes[0])];
+   unsigned long long int state = RANDOM_SEED;
+   unsigned int k;
+   int engine;
+   FILE *file;
+
+   if (values == NULL || left == NULL || bin_of == NULL)
+      exit(1);
+
+   for (k = 0; k < count; k++)
+   {
+      unsigned short int n = shapes[k][0];
+      unsigned short int capacity = shapes[k][1];
+      unsigned short int distinct = 0;
+      unsigned short int i;
+      unsigned long int sum = 0;
+      double bins;
+
+      for (i = 0; i < n; i++)
+         values[i] = shapes[k][2] + random_next(&state) % (shapes[k][3] - shapes[k][2] + 1);
+
+      qsort(values, n, sizeof(unsigned short int), comparison_numbers);
+
+      for (i = 0; i < n; i++)
+      {
+         sum += values[i];
+
+         if (i == 0 || values[i] != values[i-1])
+            distinct++;
+      }
+
+      bins = ceil((double) sum / capacity);
+
+      for (engine = 0; engine < ENGINE_COUNT; engine++)
+      {
+         double best = -1;
+         int round;
+
+         for (round = 0; round < 3; round++)
+         {
+            struct timespec begin;
+            double seconds;
+
+            clock_gettime(CLOCK_MONOTONIC, &begin);
+            run_engine(engine, values, n, capacity, left, bin_of);
+            seconds = elapsed_us(&begin) / 1e6;
+
+            if (best < 0 || seconds < best)
+               best = seconds;
+         }
+
+         /** O custo do modelo com constante 1 é o custo estimado dividido pela constante. */
+         ratios[engine][k] = best / (engine_cost(engine, n, distinct, bins) / ENGINE_COST[engine]);
+      }
+   }
+
+   file = fopen(path, "w");
+
+   if (file == NULL)
+   {
+      printf("Não foi possível gravar %s.\n", path);
+      return 1;
+   }
+
+   fprintf(file, "# Custo por unidade do modelo de cada motor, gerado por bin-packing -C\n");
+
+   for (engine = 0; engine < ENGINE_COUNT; engine++)
+   {
+      unsigned int a;
+      unsigned int b;
+
+      /** Ordenação por inserção das razões, para pegar a mediana. */
+      for (a = 1; a < count; a++)
+         for (b = a; b > 0 && ratios[engine][b - 1] > ratios[engine][b]; b--)
+         {
+            double aux = ratios[engine][b];
+            ratios[engine][b] = ratios[engine][b - 1];
+            ratios[engine][b - 1] = aux;
+         }
+
+      ENGINE_COST[engine] = ratios[engine][count / 2];
+      fprintf(file, "%s %.6e\n", ENGINE_NAMES[engine], ENGINE_COST[engine]);
+      printf("%-10s %.6e s per unit\n", ENGINE_NAMES[engine], ENGINE_COST[engine]);
+   }
+
+   fclose(file);
+   printf("Calibration written to %s\n", path);
+
+   free(values);
+   free(left);
+   free(bin_of);
+
+   return 0;
+}
+
+/**
+ * Primeira posição de um array de tamanhos em ordem decrescente cujo tamanho é menor ou
+ * igual a \em t, por busca binária.
+ *
+ * \param sizes Tamanhos em ordem decrescente.
+ * \param distinct Quantidade de tamanhos.
+ * \param t Limite.
+ * \return A posição, ou \em distinct caso todos sejam maiores que \em t.
+ */
+unsigned short int histogram_first_at_most (const unsigned short int *sizes, unsigned short int distinct, unsigned int t)
+{
+   unsigned int low = 0;
+   unsigned int high = distinct;
+
+   while (low < high)
+   {
+      unsigned int middle = (low + high) / 2;
+
+      if (sizes[middle] <= t)
+         high = middle;
+      else
+         low = middle + 1;
+   }
+
+   return low;
+}
+
+/**
+ * Limite inferior L2 de Martello e Toth. Para cada k entre 0 e capacity / 2, os números
+ * maiores que capacity - k ocupam um BIN cada; os maiores que capacity / 2 também, e os
+ * entre k e capacity / 2 só podem usar o espaço que sobra nesses últimos ou novos BINs.
+ * Basta testar k igual a zero e aos tamanhos existentes, o que com somas acumuladas e
+ * busca binária custa O(distintos * log(distintos)).
+ *
+ * \param hist Histograma dos números.
+ * \param capacity Capacidade dos BINs, maior que zero.
+ * \return O limite inferior, nunca menor que ceil(soma / capacity).
+ * \see histogram_first_at_most
+ */
+unsigned int lower_bound_l2 (const size_histogram *hist, unsigned short int capacity)
+{
+   unsigned long int *count = malloc(sizeof(unsigned long int)*(hist->distinct + 1)); /** Itens antes de cada posição */
+   unsigned long int *sum = malloc(sizeof(unsigned long int)*(hist->distinct + 1)); /** Soma antes de cada posição */
+   unsigned long int best = (hist->total + capacity - 1) / capacity;
+   unsigned short int half = histogram_first_at_most(hist->sizes, hist->distinct, capacity / 2);
+   unsigned int d;
+
+   if (count == NULL || sum == NULL)
+      exit(1);
+
+   count[0] = sum[0] = 0;
+
+   for (d = 0; d < hist->distinct; d++)
+   {
+      count[d + 1] = count[d] + hist->counts[d];
+      sum[d + 1] = sum[d] + (unsigned long int) hist->counts[d] * hist->sizes[d];
+   }
+
+   /** k = 0 e cada tamanho até capacity / 2, do maior para o menor. */
+   for (d = half; d <= hist->distinct; d++)
+   {
+      unsigned int k = d < hist->distinct ? hist->sizes[d] : 0;
+      unsigned short int big = histogram_first_at_most(hist->sizes, hist->distinct, capacity - k);
+      unsigned short int small = k > 0 ? histogram_first_at_most(hist->sizes, hist->distinct, k - 1) : hist->distinct;
+      unsigned long int n2 = count[half] - count[big];
+      unsigned long int room = n2 * capacity - (sum[half] - sum[big]);
+      unsigned long int rest = sum[small] - sum[half];
+      unsigned long int bound = count[half] + (rest > room ? (rest - room + capacity - 1) / capacity : 0);
+
+      if (bound > best)
+         best = bound;
+   }
+
+   free(count);
+   free(sum);
+
+   return best;
+}
+
+/**
+ * Retira (\em sign igual a 1) ou devolve (\em sign igual a -1) itens do multiconjunto de
+ * itens restantes da busca exata, atualizando o hash.
+ *
+ * \param search Estado da busca exata.
+ * \param items Posições dos tamanhos dos itens.
+ * \param count Quantidade de itens.
+ * \param sign 1 para retirar, -1 para devolver.
+ * \return Zero após finalizado.
+ */
+int exact_apply (exact_search *search, const unsigned short int *items, unsigned short int count, int sign)
+{
+   unsigned short int i;
+
+   for (i = 0; i < count; i++)
+   {
+      search->counts[items[i]] -= sign;
+      search->hash -= sign * search->zobrist[items[i]];
+   }
+
+   return 0;
+}
+
+/**
+ * Teste de dominância de Schreiber e Korf para o BIN em construção: ele é dominado se
+ * algum subconjunto dos seus itens (além do maior, que é fixo) pode ser trocado por um
+ * único item restante, fora do BIN, que cabe no lugar e não é menor que a soma do
+ * subconjunto (estritamente maior, para subconjuntos de um item). O teste só é feito
+ * com até EXACT_DOMINANCE_ITEMS itens; acima disso o BIN é considerado não dominado, o
+ * que apenas deixa a busca maior.
+ *
+ * \param search Estado da busca exata, com o BIN em \em current.
+ * \param residual Espaço que sobra no BIN.
+ * \return 1 caso o BIN seja dominado, 0 caso contrário.
+ */
+int completion_dominated (const exact_search *search, unsigned short int residual)
+{
+   unsigned int k = search->current_count - 1;
+   unsigned int mask;
+   unsigned int b;
+
+   if (k == 0 || k > EXACT_DOMINANCE_ITEMS)
+      return 0;
+
+   for (mask = 1; mask < (1U << k); mask++)
+   {
+      unsigned int sum = 0;
+      unsigned int low;
+      unsigned int high;
+      unsigned short int d;
+
+      for (b = 0; b < k; b++)
+         if (mask & (1U << b))
+            sum += search->sizes[search->current[b + 1]];
+
+      low = sum + ((mask & (mask - 1)) == 0);
+      high = sum + residual;
+
+      for (d = histogram_first_at_most(search->sizes, search->distinct, high);
+           d < search->distinct && search->sizes[d] >= low; d++)
+         if (search->counts[d] > 0)
+            return 1;
+   }
+
+   return 0;
+}
+
+/**
+ * Gera os completamentos não dominados do BIN em construção, acrescentando itens dos
+ * tamanhos a partir da posição \em d. Cada conjunto de tamanhos é gerado uma única vez,
+ * escolhendo de cada tamanho, em ordem decrescente, quantas cópias usar. Um conjunto é
+ * guardado quando é maximal (nenhum item restante cabe no espaço que sobra), o espaço
+ * que sobra cabe no desperdício permitido e ele não é dominado.
+ *
+ * \param search Estado da busca exata, com os itens restantes em \em counts.
+ * \param d Primeira posição de tamanho que ainda pode ser acrescentada.
+ * \param residual Espaço que sobra no BIN.
+ * \param allowed Desperdício ainda permitido.
+ * \param list Lista que recebe os completamentos.
+ * \return Zero após finalizado.
+ * \see completion_dominated
+ */
+int exact_generate (exact_search *search, unsigned short int d, unsigned short int residual, unsigned long int allowed,
+                    completion_list *list)
+{
+   unsigned short int e;
+   unsigned int last = search->distinct;
+
+   /** Nem colocando todos os itens restantes a partir de d o espaço que sobra fica no permitido. */
+   if (residual > allowed + search->suffix[d] || search->aborted)
+      return 0;
+
+   while (last > 0 && search->counts[last - 1] == 0)
+      last--;
+
+   if (residual <= allowed && (last == 0 || search->sizes[last - 1] > residual) && !completion_dominated(search, residual))
+   {
+      if (list->count >= EXACT_MAX_COMPLETIONS)
+      {
+         search->aborted = 1;
+         return 0;
+      }
+
+      if (list->size + search->current_count + 2 > list->capacity)
+      {
+         list->capacity = 2 * (list->size + search->current_count + 2);
+         list->data = realloc(list->data, sizeof(unsigned short int)*list->capacity);
+      }
+
+      if (list->count == list->room)
+      {
+         list->room = list->room > 0 ? 2 * list->room : 16;
+         list->offset = realloc(list->offset, sizeof(unsigned int)*list->room);
+         list->residual = realloc(list->residual, sizeof(unsigned short int)*list->room);
+      }
+
+      if (list->data == NULL || list->offset == NULL || list->residual == NULL)
+         exit(1);
+
+      list->offset[list->count] = list->size;
+      list->residual[list->count++] = residual;
+      list->data[list->size++] = search->current_count;
+      memcpy(list->data + list->size, search->current, sizeof(unsigned short int)*search->current_count);
+      list->size += search->current_count;
+   }
+
+   for (e = d; e < search->distinct; e++)
+   {
+      unsigned int most;
+      unsigned int m;
+
+      if (search->counts[e] == 0 || search->sizes[e] > residual)
+         continue;
+
+      most = residual / search->sizes[e];
+
+      if (most > search->counts[e])
+         most = search->counts[e];
+
+      for (m = 0; m < most; m++)
+         search->current[search->current_count + m] = e;
+
+      for (m = most; m > 0; m--)
+      {
+         search->counts[e] -= m;
+         search->current_count += m;
+         exact_generate(search, e + 1, residual - m * search->sizes[e], allowed, list);
+         search->current_count -= m;
+         search->counts[e] += m;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * Busca exata por "bin completion": o maior item restante abre o próximo BIN, que é
+ * completado com cada um dos completamentos não dominados, do que desperdiça menos para
+ * o que desperdiça mais, até todos os itens serem colocados. Estados que falham vão para
+ * a tabela de nogoods junto com a quantidade de BINs já fechados; o mesmo multiconjunto
+ * restante com pelo menos tantos BINs fechados tem desperdício maior e também falha.
+ *
+ * \param search Estado da busca exata.
+ * \param bins Quantidade de BINs já fechados.
+ * \param waste Espaço que sobrou nos BINs já fechados.
+ * \return 1 caso tenha encontrado uma solução, guardada em \em bin_items, 0 caso contrário.
+ * \see exact_generate
+ */
+int exact_complete (exact_search *search, unsigned int bins, unsigned long int waste)
+{
+   completion_list list = { NULL, 0, 0, NULL, NULL, 0, 0 };
+   unsigned int slot = search->hash & ((1U << EXACT_NOGOOD_BITS) - 1);
+   unsigned short int *order;
+   unsigned short int first;
+   unsigned int k;
+   int found = 0;
+   int e;
+
+   for (first = 0; first < search->distinct && search->counts[first] == 0; first++)
+      ;
+
+   if (first == search->distinct)
+      return 1;
+
+   if (search->aborted || DEADLINE_POLL(&DEADLINE, search->ticks))
+   {
+      search->aborted = 1;
+      return 0;
+   }
+
+   search->nodes++;
+
+   if (search->nogood_key[slot] == search->hash && search->nogood_bins[slot] <= bins)
+   {
+      search->hits++;
+      return 0;
+   }
+
+   /** O maior item restante vai sempre para o BIN aberto agora. */
+   search->counts[first]--;
+   search->current[0] = first;
+   search->current_count = 1;
+   search->suffix[search->distinct] = 0;
+
+   for (e = search->distinct - 1; e >= 0; e--)
+      search->suffix[e] = search->suffix[e + 1] + (unsigned long int) search->counts[e] * search->sizes[e];
+
+   exact_generate(search, first, search->capacity - search->sizes[first], search->waste - waste, &list);
+   search->counts[first]++;
+
+   order = malloc(sizeof(unsigned short int)*(list.count + 1));
+
+   if (order == NULL)
+      exit(1);
+
+   /** Os que desperdiçam menos primeiro: a chave é o espaço ocupado. */
+   for (k = 0; k < list.count; k++)
+      list.residual[k] = search->capacity - list.residual[k];
+
+   sort_indices_desc(list.residual, list.count, order);
+
+   for (k = 0; k < list.count && !found && !search->aborted; k++)
+   {
+      unsigned short int *items = list.data + list.offset[order[k]];
+      unsigned short int count = items[0];
+
+      exact_apply(search, items + 1, count, 1);
+      memcpy(search->bin_items + search->bin_start[bins], items + 1, sizeof(unsigned short int)*count);
+      search->bin_start[bins + 1] = search->bin_start[bins] + count;
+
+      found = exact_complete(search, bins + 1, waste + search->capacity - list.residual[order[k]]);
+
+      exact_apply(search, items + 1, count, -1);
+   }
+
+   if (!found && !search->aborted)
+   {
+      search->nogood_key[slot] = search->hash;
+      search->nogood_bins[slot] = bins;
+   }
+
+   free(order);
+   free(list.data);
+   free(list.offset);
+   free(list.residual);
+
+   return found;
+}
+
+/**
+ * Insere uma tarefa no fundo do deque. Só a thread dona do deque insere.
+ *
+ * \param deque Deque da thread.
+ * \param task Tarefa a ser inserida.
+ * \return Zero após inserida, 1 se o deque está cheio.
+ */
+int ws_deque_push (ws_deque *deque, exact_task *task)
+{
+   long int bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+   long int top = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+   if (bottom - top >= EXACT_DEQUE_SIZE)
+      return 1;
+
+   atomic_store_explicit(&deque->tasks[bottom & (EXACT_DEQUE_SIZE - 1)], task, memory_order_release);
+   atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+
+   return 0;
+}
+
+/**
+ * Retira a tarefa do fundo do deque, a mais recente. Só a thread dona do deque retira;
+ * a disputa pela última tarefa com quem rouba é decidida pelo compare-and-swap do topo.
+ *
+ * \param deque Deque da thread.
+ * \return A tarefa, ou NULL se o deque está vazio.
+ */
+exact_task* ws_deque_take (ws_deque *deque)
+{
+   long int bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+   long int top;
+   exact_task *task = NULL;
+
+   atomic_store_explicit(&deque->bottom, bottom, memory_order_seq_cst);
+   top = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+
+   if (top <= bottom)
+   {
+      task = atomic_load_explicit(&deque->tasks[bottom & (EXACT_DEQUE_SIZE - 1)], memory_order_acquire);
+
+      if (top == bottom)
+      {
+         if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst,
+                                                      memory_order_relaxed))
+            task = NULL;
+
+         atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+      }
+   }
+   else
+      atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+   return task;
+}
+
+/**
+ * Rouba a tarefa do topo do deque de outra thread, a mais antiga.
+ *
+ * \param deque Deque da vítima.
+ * \return A tarefa, ou NULL se o deque está vazio ou outra thread levou a tarefa.
+ */
+exact_task* ws_deque_steal (ws_deque *deque)
+{
+   long int top = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+   long int bottom = atomic_load_explicit(&deque->bottom, memory_order_seq_cst);
+   exact_task *task;
+
+   if (top >= bottom)
+      return NULL;
+
+   task = atomic_load_explicit(&deque->tasks[top & (EXACT_DEQUE_SIZE - 1)], memory_order_acquire);
+
+   if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+      return NULL;
+
+   return task;
+}
+
+/**
+ * Guarda a solução completa da thread caso ela use menos BINs que a melhor conhecida.
+ *
+ * \param worker Thread que chegou à solução, com os BINs em \em bin_items.
+ * \param bins Quantidade de BINs da solução.
+ * \return Zero após finalizado.
+ */
+int exact_record (exact_worker *worker, unsigned int bins)
+{
+   exact_job *job = worker->job;
+   exact_search *search = &worker->search;
+
+   pthread_mutex_lock(&job->lock);
+
+   if (bins < (unsigned int) atomic_load(&job->best))
+   {
+      memcpy(job->solution_items, search->bin_items, sizeof(unsigned short int)*search->bin_start[bins]);
+      memcpy(job->solution_start, search->bin_start, sizeof(unsigned int)*(bins + 1));
+      atomic_store(&job->best, bins);
+      deadline_report(&DEADLINE, "Exact", bins);
+   }
+
+   pthread_mutex_unlock(&job->lock);
+
+   return 0;
+}
+
+/**
+ * Oferece um filho do nó atual para roubo: a tarefa leva os BINs já fechados e o BIN
+ * do filho, e entra no deque da própria thread.
+ *
+ * \param worker Thread que oferece o filho.
+ * \param bins BINs já fechados no nó atual.
+ * \param waste Espaço que sobra nos BINs fechados, incluindo o do filho.
+ * \param items Completamento do filho: quantidade de itens seguida das posições dos tamanhos.
+ * \return Zero após inserida, 1 se o deque está cheio.
+ */
+int exact_push_child (exact_worker *worker, unsigned int bins, unsigned long int waste, const unsigned short int *items)
+{
+   exact_search *search = &worker->search;
+   exact_job *job = worker->job;
+   unsigned int length = search->bin_start[bins] + bins + items[0] + 1;
+   exact_task *task = malloc(sizeof(exact_task) + sizeof(unsigned short int)*length);
+   unsigned int position = 0;
+   unsigned int b;
+
+   if (task == NULL)
+      exit(1);
+
+   for (b = 0; b < bins; b++)
+   {
+      task->items[position++] = search->bin_start[b + 1] - search->bin_start[b];
+      memcpy(task->items + position, search->bin_items + search->bin_start[b],
+             sizeof(unsigned short int)*(search->bin_start[b + 1] - search->bin_start[b]));
+      position += search->bin_start[b + 1] - search->bin_start[b];
+   }
+
+   memcpy(task->items + position, items, sizeof(unsigned short int)*(items[0] + 1));
+   task->bins = bins + 1;
+   task->waste = waste;
+   task->length = length;
+
+   atomic_fetch_add(&job->pending, 1);
+
+   if (ws_deque_push(&job->deques[worker->id], task) != 0)
+   {
+      atomic_fetch_sub(&job->pending, 1);
+      free(task);
+      return 1;
+   }
+
+   return 0;
+}
+
+/**
+ * Nó da busca exata paralela. Diferente de exact_complete, que decide se uma quantidade
+ * fixa de BINs é possível, aqui se procura qualquer solução com menos BINs que a melhor
+ * conhecida, lida a cada nó: o desperdício permitido diminui assim que qualquer thread
+ * melhora a solução. Os piores filhos são oferecidos para roubo enquanto o deque da
+ * thread tem menos de EXACT_SPLIT_TASKS tarefas; os demais são explorados na hora. Um
+ * estado só vai para a tabela de nogoods quando a subárvore inteira foi explorada pela
+ * própria thread; como a melhor quantidade só diminui, o nogood continua válido.
+ *
+ * \param worker Thread da busca.
+ * \param bins Quantidade de BINs já fechados.
+ * \param waste Espaço que sobrou nos BINs já fechados.
+ * \return Zero após finalizado.
+ * \see exact_complete
+ */
+int exact_parallel_node (exact_worker *worker, unsigned int bins, unsigned long int waste)
+{
+   exact_search *search = &worker->search;
+   exact_job *job = worker->job;
+   completion_list list = { NULL, 0, 0, NULL, NULL, 0, 0 };
+   unsigned long long int tag = search->hash >> EXACT_NOGOOD_BITS << EXACT_NOGOOD_BITS;
+   unsigned long long int entry;
+   unsigned int slot = search->hash & ((1U << EXACT_NOGOOD_BITS) - 1);
+   unsigned int best = atomic_load_explicit(&job->best, memory_order_relaxed);
+   unsigned short int *order;
+   unsigned short int first;
+   unsigned int local;
+   unsigned int k;
+   char offered = 0;
+   int e;
+
+   for (first = 0; first < search->distinct && search->counts[first] == 0; first++)
+      ;
+
+   if (first == search->distinct)
+      return exact_record(worker, bins);
+
+   if (atomic_load_explicit(&job->aborted, memory_order_relaxed) || DEADLINE_POLL(&DEADLINE, search->ticks))
+   {
+      atomic_store(&job->aborted, 1);
+      search->aborted = 1;
+      return 0;
+   }
+
+   /** Ainda falta abrir um BIN, e o total tem de ficar abaixo da melhor quantidade. */
+   if (best <= job->lower || bins + 1 >= best)
+      return 0;
+
+   search->waste = (unsigned long int) (best - 1) * search->capacity - job->hist->total;
+
+   if (waste > search->waste)
+      return 0;
+
+   search->nodes++;
+   entry = atomic_load_explicit(&job->nogood[slot], memory_order_relaxed);
+
+   if (entry != 0 && (entry >> EXACT_NOGOOD_BITS << EXACT_NOGOOD_BITS) == tag &&
+       (entry & ((1U << EXACT_NOGOOD_BITS) - 1)) - 1 <= bins)
+   {
+      search->hits++;
+      return 0;
+   }
+
+   search->counts[first]--;
+   search->current[0] = first;
+   search->current_count = 1;
+   search->suffix[search->distinct] = 0;
+
+   for (e = search->distinct - 1; e >= 0; e--)
+      search->suffix[e] = search->suffix[e + 1] + (unsigned long int) search->counts[e] * search->sizes[e];
+
+   exact_generate(search, first, search->capacity - search->sizes[first], search->waste - waste, &list);
+   search->counts[first]++;
+
+   /** Completamentos demais só tornam a busca inconclusiva, como na busca sequencial. */
+   if (search->aborted)
+      atomic_store(&job->aborted, 1);
+
+   order = malloc(sizeof(unsigned short int)*(list.count + 1));
+
+   if (order == NULL)
+      exit(1);
+
+   for (k = 0; k < list.count; k++)
+      list.residual[k] = search->capacity - list.residual[k];
+
+   sort_indices_desc(list.residual, list.count, order);
+
+   /** Os piores filhos vão para o deque; o melhor fica sempre com a thread. */
+   for (local = list.count; local > 1 && !search->aborted; local--)
+   {
+      ws_deque *own = &job->deques[worker->id];
+      unsigned short int *items = list.data + list.offset[order[local - 1]];
+
+      if (atomic_load_explicit(&own->bottom, memory_order_relaxed) -
+          atomic_load_explicit(&own->top, memory_order_relaxed) >= EXACT_SPLIT_TASKS)
+         break;
+
+      if (exact_push_child(worker, bins, waste + search->capacity - list.residual[order[local - 1]], items) != 0)
+         break;
+
+      offered = 1;
+   }
+
+   for (k = 0; k < local && !search->aborted; k++)
+   {
+      unsigned short int *items = list.data + list.offset[order[k]];
+      unsigned short int count = items[0];
+
+      exact_apply(search, items + 1, count, 1);
+      memcpy(search->bin_items + search->bin_start[bins], items + 1, sizeof(unsigned short int)*count);
+      search->bin_start[bins + 1] = search->bin_start[bins] + count;
+
+      exact_parallel_node(worker, bins + 1, waste + search->capacity - list.residual[order[k]]);
+
+      exact_apply(search, items + 1, count, -1);
+   }
+
+   if (!offered && !search->aborted)
+      atomic_store_explicit(&job->nogood[slot], tag | (bins + 1), memory_order_relaxed);
+
+   free(order);
+   free(list.data);
+   free(list.offset);
+   free(list.residual);
+
+   return 0;
+}
+
+/**
+ * Executa uma tarefa da busca exata paralela: volta os itens restantes à raiz, refaz
+ * os BINs fechados da tarefa e continua a busca a partir deles.
+ *
+ * \param worker Thread que executa a tarefa.
+ * \param task Tarefa.
+ * \return Zero após finalizado.
+ */
+int exact_run_task (exact_worker *worker, exact_task *task)
+{
+   exact_search *search = &worker->search;
+   unsigned int position = 0;
+   unsigned int b;
+   unsigned short int d;
+
+   search->hash = 0;
+
+   for (d = 0; d < search->distinct; d++)
+   {
+      search->counts[d] = worker->job->hist->counts[d];
+      search->hash += search->counts[d] * search->zobrist[d];
+   }
+
+   search->bin_start[0] = 0;
+
+   for (b = 0; b < task->bins; b++)
+   {
+      unsigned short int count = task->items[position];
+
+      exact_apply(search, task->items + position + 1, count, 1);
+      memcpy(search->bin_items + search->bin_start[b], task->items + position + 1, sizeof(unsigned short int)*count);
+      search->bin_start[b + 1] = search->bin_start[b] + count;
+      position += count + 1;
+   }
+
+   return exact_parallel_node(worker, task->bins, task->waste);
+}
+
+/**
+ * Laço de uma thread da busca exata paralela: executa as tarefas do próprio deque e,
+ * com ele vazio, tenta roubar de uma thread escolhida ao acaso. Termina quando não há
+ * mais tarefas pendentes em nenhuma thread.
+ *
+ * \param arg Ponteiro para o exact_worker da thread.
+ * \return NULL.
+ */
+void* exact_worker_run (void *arg)
+{
+   exact_worker *worker = arg;
+   exact_job *job = worker->job;
+
+   while (atomic_load(&job->pending) > 0)
+   {
+      exact_task *task = ws_deque_take(&job->deques[worker->id]);
+
+      if (task == NULL)
+      {
+         unsigned short int victim = random_next(&worker->state) % job->threads;
+
+         if (victim != worker->id && (task = ws_deque_steal(&job->deques[victim])) != NULL)
+            atomic_fetch_add(&job->steals, 1);
+      }
+
+      if (task == NULL)
+      {
+         sched_yield();
+         continue;
+      }
+
+      exact_run_task(worker, task);
+      free(task);
+      atomic_fetch_sub(&job->pending, 1);
+   }
+
+   return NULL;
+}
+
+/**
+ * Busca exata paralela (opção <tt>-X</tt> com <tt>-j</tt> maior que 1): branch-and-bound
+ * com roubo de trabalho. Cada thread tem um deque de Chase e Lev com subárvores; a
+ * melhor quantidade de BINs é atômica e compartilhada, assim como a tabela de nogoods.
+ * A busca termina quando todas as subárvores foram exploradas, quando a melhor
+ * quantidade atinge o limite inferior ou quando o prazo vence.
+ *
+ * \param job Estado compartilhado, com o histograma, o limite inferior e a melhor
+ *            quantidade (a do FFD) preenchidos. Recebe a solução, se houver uma melhor.
+ * \return Zero após finalizado.
+ * \see exact_parallel_node
+ */
+int exact_parallel (exact_job *job)
+{
+   unsigned long long int state = RANDOM_SEED;
+   unsigned int bound = atomic_load(&job->best);
+   exact_worker *workers;
+   pthread_t *threads;
+   exact_task *root;
+   unsigned short int started;
+   unsigned short int i;
+   unsigned short int d;
+
+   job->threads = THREADS_QUANTITY;
+   job->zobrist = malloc(sizeof(unsigned long long int)*(job->distinct + 1));
+   job->nogood = calloc(1U << EXACT_NOGOOD_BITS, sizeof(atomic_ullong));
+   job->deques = calloc(job->threads, sizeof(ws_deque));
+   job->solution_items = malloc(sizeof(unsigned short int)*(job->items + 1));
+   job->solution_start = malloc(sizeof(unsigned int)*(bound + 1));
+   job->nodes = 0;
+   job->hits = 0;
+   workers = calloc(job->threads, sizeof(exact_worker));
+   threads = malloc(sizeof(pthread_t)*job->threads);
+   root = calloc(1, sizeof(exact_task));
+
+   if (job->zobrist == NULL || job->nogood == NULL || job->deques == NULL || job->solution_items == NULL ||
+       job->solution_start == NULL || workers == NULL || threads == NULL || root == NULL)
+      exit(1);
+
+   for (d = 0; d < job->distinct; d++)
+      job->zobrist[d] = random_next(&state);
+
+   atomic_init(&job->pending, 1);
+   atomic_init(&job->aborted, 0);
+   atomic_init(&job->steals, 0);
+   pthread_mutex_init(&job->lock, NULL);
+   ws_deque_push(&job->deques[0], root);
+
+   for (i = 0; i < job->threads; i++)
+   {
+      exact_search *search = &workers[i].search;
+
+      workers[i].job = job;
+      workers[i].id = i;
+      workers[i].state = RANDOM_SEED + i + 1;
+      search->sizes = job->hist->sizes;
+      search->distinct = job->distinct;
+      search->capacity = BIN_SIZE;
+      search->zobrist = job->zobrist;
+      search->counts = malloc(sizeof(unsigned int)*(job->distinct + 1));
+      search->suffix = malloc(sizeof(unsigned long int)*(job->distinct + 1));
+      search->bin_items = malloc(sizeof(unsigned short int)*(job->items + 1));
+      search->bin_start = malloc(sizeof(unsigned int)*(bound + 1));
+      search->current = malloc(sizeof(unsigned short int)*(job->items + 1));
+
+      if (search->counts == NULL || search->suffix == NULL || search->bin_items == NULL || search->bin_start == NULL ||
+          search->current == NULL)
+         exit(1);
+   }
+
+   /**
+    * Só a thread dona insere no próprio deque, então as threads que não puderam ser
+    * criadas ficam com o deque vazio e as demais fazem todo o trabalho. Sem nenhuma, a
+    * primeira executa aqui mesmo, sozinha com a raiz.
+    */
+   for (started = 0; started < job->threads; started++)
+      if (pthread_create(&threads[started], NULL, exact_worker_run, &workers[started]) != 0)
+         break;
+
+   if (started == 0)
+      exact_worker_run(&workers[0]);
+
+   for (i = 0; i < started; i++)
+      pthread_join(threads[i], NULL);
+
+   for (i = 0; i < job->threads; i++)
+   {
+      job->nodes += workers[i].search.nodes;
+      job->hits += workers[i].search.hits;
+      free(workers[i].search.counts);
+      free(workers[i].search.suffix);
+      free(workers[i].search.bin_items);
+      free(workers[i].search.bin_start);
+      free(workers[i].search.current);
+   }
+
+   pthread_mutex_destroy(&job->lock);
+   free(job->zobrist);
+   free(job->nogood);
+   free(job->deques);
+   free(workers);
+   free(threads);
+
+   return 0;
+}
+
+/**
+ * Converte uma solução da busca exata, dada por tamanhos do histograma em cada BIN, no
+ * BIN de cada número de \em values e no espaço restante de cada BIN. Números de tamanho
+ * zero, que ficam fora da busca, vão para o primeiro BIN.
+ *
+ * \param values Números ordenados de forma decrescente.
+ * \param n Quantidade de números.
+ * \param hist Histograma dos números.
+ * \param bin_items Posições dos tamanhos dos itens de cada BIN, em sequência.
+ * \param bin_start Início de cada BIN em \em bin_items, \em nbins + 1 posições.
+ * \param nbins Quantidade de BINs da solução.
+ * \param left Recebe o espaço restante de cada BIN.
+ * \param bin_of Recebe o BIN de cada número.
+ * \return Zero após finalizado.
+ */
+int exact_solution_bins (const unsigned short int *values, unsigned short int n, const size_histogram *hist,
+                         const unsigned short int *bin_items, const unsigned int *bin_start, unsigned int nbins,
+                         unsigned short int *left, unsigned short int *bin_of)
+{
+   unsigned int *cursor = calloc(hist->distinct + 1, sizeof(unsigned int));
+   unsigned int b;
+   unsigned int d;
+   unsigned int i;
+
+   if (cursor == NULL)
+      exit(1);
+
+   /** Cada tamanho começa na posição do seu primeiro número em values. */
+   for (d = 1; d < hist->distinct; d++)
+      cursor[d] = cursor[d - 1] + hist->counts[d - 1];
+
+   for (b = 0; b < nbins; b++)
+   {
+      left[b] = BIN_SIZE;
+
+      for (i = bin_start[b]; i < bin_start[b + 1]; i++)
+      {
+         d = bin_items[i];
+         left[b] -= hist->sizes[d];
+         bin_of[cursor[d]++] = b;
+      }
+   }
+
+   for (i = 0; i < n; i++)
+      if (values[i] == 0)
+         bin_of[i] = 0;
+
+   free(cursor);
+   return 0;
+}
+
+/**
+ * Executa a busca exata (opção <tt>-X</tt>). O FFD dá a solução inicial; se ela não
+ * atinge o limite inferior, testa-se cada quantidade de BINs, do limite inferior para
+ * cima, com exact_complete. A primeira quantidade possível é a ótima; se nenhuma menor
+ * que o FFD for possível, o FFD é ótimo. A tabela de nogoods é limpa a cada quantidade,
+ * pois o desperdício permitido muda. Números de tamanho zero ficam fora da busca e vão
+ * para o primeiro BIN. Com <tt>-j</tt> maior que 1, a busca é feita por exact_parallel.
+ *
+ * \param values Ponteiro para o array de números ordenado de forma decrescente.
+ * \return Zero após finalizado, 1 se algum número não cabe no BIN.
+ * \see exact_complete
+ * \see exact_parallel
+ * \see lower_bound_l2
+ */
+int run_exact (unsigned short int *values)
+{
+   unsigned short int n = NUMBERS_QUANTITY;
+   unsigned short int *left = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int *bin_of = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int *pool = malloc(sizeof(unsigned short int)*(n + 1));
+   int *next = malloc(sizeof(int)*(n + 1));
+   exact_search search;
+   size_histogram hist;
+   bin_list view;
+   unsigned int ffd;
+   unsigned int nbins;
+   unsigned int lower = 0;
+   unsigned int l2 = 0;
+   unsigned int target;
+   unsigned int d;
+   unsigned long int steals = 0;
+   char proven;
+
+   view.itens = malloc(sizeof(bin)*(n + 1));
+
+   if (left == NULL || bin_of == NULL || pool == NULL || next == NULL || view.itens == NULL)
+      exit(1);
+
+   if (n > 0 && values[0] > BIN_SIZE)
+   {
+      printf("O número %d não cabe em um BIN de tamanho %d.\n", values[0], BIN_SIZE);
+      free(left);
+      free(bin_of);
+      free(pool);
+      free(next);
+      free(view.itens);
+      return 1;
+   }
+
+   build_histogram(values, &hist);
+   ffd = nbins = first_fit_assign(values, n, BIN_SIZE, left, next, bin_of);
+
+   memset(&search, 0, sizeof(search));
+   search.sizes = hist.sizes;
+   search.capacity = BIN_SIZE;
+   search.distinct = hist.distinct;
+
+   /** Os números de tamanho zero são o último tamanho do histograma. */
+   if (search.distinct > 0 && hist.sizes[search.distinct - 1] == 0)
+      search.distinct--;
+
+   if (BIN_SIZE > 0)
+   {
+      lower = (hist.total + BIN_SIZE - 1) / BIN_SIZE;
+      l2 = lower_bound_l2(&hist, BIN_SIZE);
+      lower = l2 > lower ? l2 : lower;
+   }
+
+   /** Com algum número há pelo menos um BIN, mesmo que todos tenham tamanho zero. */
+   if (n > 0 && lower == 0)
+      lower = 1;
+
+   proven = lower >= ffd;
+
+   if (!proven && ffd <= EXACT_MAX_BINS && THREADS_QUANTITY > 1)
+   {
+      exact_job job;
+
+      job.hist = &hist;
+      job.distinct = search.distinct;
+      job.lower = lower;
+      job.items = n;
+      atomic_init(&job.best, ffd);
+
+      exact_parallel(&job);
+
+      if ((unsigned int) atomic_load(&job.best) < ffd)
+      {
+         nbins = atomic_load(&job.best);
+         exact_solution_bins(values, n, &hist, job.solution_items, job.solution_start, nbins, left, bin_of);
+      }
+
+      proven = !atomic_load(&job.aborted);
+      search.nodes = job.nodes;
+      search.hits = job.hits;
+      steals = atomic_load(&job.steals);
+
+      free(job.solution_items);
+      free(job.solution_start);
+   }
+   else if (!proven && ffd <= EXACT_MAX_BINS)
+   {
+      unsigned long long int state = RANDOM_SEED;
+
+      search.counts = malloc(sizeof(unsigned int)*(search.distinct + 1));
+      search.suffix = malloc(sizeof(unsigned long int)*(search.distinct + 1));
+      search.zobrist = malloc(sizeof(unsigned long long int)*(search.distinct + 1));
+      search.bin_items = malloc(sizeof(unsigned short int)*(n + 1));
+      search.bin_start = malloc(sizeof(unsigned int)*(ffd + 1));
+      search.current = malloc(sizeof(unsigned short int)*(n + 1));
+      search.nogood_key = malloc(sizeof(unsigned long long int)*(1U << EXACT_NOGOOD_BITS));
+      search.nogood_bins = malloc(sizeof(unsigned int)*(1U << EXACT_NOGOOD_BITS));
+
+      if (search.counts == NULL || search.suffix == NULL || search.zobrist == NULL || search.bin_items == NULL ||
+          search.bin_start == NULL || search.current == NULL || search.nogood_key == NULL || search.nogood_bins == NULL)
+         exit(1);
+
+      for (d = 0; d < search.distinct; d++)
+      {
+         search.counts[d] = hist.counts[d];
+         search.zobrist[d] = random_next(&state);
+      }
+
+      for (target = lower; target < ffd && !search.aborted; target++)
+      {
+         memset(search.nogood_key, 0, sizeof(unsigned long long int)*(1U << EXACT_NOGOOD_BITS));
+         memset(search.nogood_bins, 0xFF, sizeof(unsigned int)*(1U << EXACT_NOGOOD_BITS));
+         search.waste = (unsigned long int) target * BIN_SIZE - hist.total;
+         search.hash = 0;
+         search.bin_start[0] = 0;
+
+         for (d = 0; d < search.distinct; d++)
+            search.hash += search.counts[d] * search.zobrist[d];
+
+         if (exact_complete(&search, 0, 0))
+         {
+            exact_solution_bins(values, n, &hist, search.bin_items, search.bin_start, target, left, bin_of);
+            nbins = target;
+            proven = 1;
+            deadline_report(&DEADLINE, "Exact", nbins);
+            break;
+         }
+      }
+
+      /** Nenhuma quantidade menor que a do FFD é possível: o FFD é ótimo. */
+      if (!search.aborted)
+         proven = 1;
+
+      free(search.counts);
+      free(search.suffix);
+      free(search.zobrist);
+      free(search.bin_items);
+      free(search.bin_start);
+      free(search.current);
+      free(search.nogood_key);
+      free(search.nogood_bins);
+   }
+
+   materialize_bins(values, n, bin_of, left, nbins, pool, view.itens);
+   view.count = nbins;
+   print_list_bins(&view);
+
+   printf("Exact: Bins: %u | FFD: %u | LowerBound: %u (L2: %u) | %s | Nodes: %lu | Nogood hits: %lu", nbins, ffd,
+          lower, l2, proven ? "optimal" : "not proven optimal", search.nodes, search.hits);
+
+   if (THREADS_QUANTITY > 1)
+      printf(" | Threads: %d | Steals: %lu", THREADS_QUANTITY, steals);
+
+   printf("\n\n");
+
+   free_histogram(&hist);
+   free(left);
+   free(bin_of);
+   free(pool);
+   free(next);
+   free(view.itens);
+
+   return 0;
+}
+
+/**
+ * Quantil da distribuição normal padrão: o valor z tal que P(Z <= z) = \em p. Usa a
+ * aproximação racional de Acklam, com erro relativo abaixo de 1.2e-9, seguida de um passo
+ * de Newton com erfc.
+ *
+ * \param p Probabilidade, entre 0 e 1 exclusive.
+ * \return O quantil.
+ */
+double normal_quantile (double p)
+{
+   static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+   static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01 };
+   static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+   static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00 };
+   double q;
+   double r;
+   double x;
+   double e;
+
+   if (p < 0.02425)
+   {
+      q = sqrt(-2 * log(p));
+      x = (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) / ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+   }
+   else if (p > 1 - 0.02425)
+   {
+      q = sqrt(-2 * log(1 - p));
+      x = -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) / ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+   }
+   else
+   {
+      q = p - 0.5;
+      r = q * q;
+      x = (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q /
+          (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1);
+   }
+
+   /** Um passo de Newton (na forma de Halley) leva o erro à precisão do double. */
+   e = 0.5 * erfc(-x / sqrt(2)) - p;
+   r = e * sqrt(2 * BP_PI) * exp(x * x / 2);
+   return x - r / (1 + x * r / 2);
+}
+
+/**
+ * Atualiza a soma das médias e das variâncias do BIN \em j no índice do modo estocástico.
+ * Se \em j for igual à quantidade de BINs, o BIN é acrescentado, e a árvore dobra de
+ * tamanho quando necessário.
+ *
+ * \param idx Índice dos BINs.
+ * \param j Posição do BIN.
+ * \param mean Soma das médias dos itens do BIN.
+ * \param variance Soma das variâncias dos itens do BIN.
+ * \return Zero após finalizado.
+ */
+int stochastic_index_set (stochastic_index *idx, unsigned int j, unsigned long int mean, double variance)
+{
+   unsigned int node;
+   unsigned int k;
+
+   if (j == idx->count)
+   {
+      if (j == idx->leaves)
+      {
+         unsigned int leaves = idx->leaves > 0 ? 2 * idx->leaves : 1;
+         double *slack = malloc(sizeof(double)*2*leaves*STOCHASTIC_BUCKETS);
+         unsigned int i;
+
+         idx->variance = realloc(idx->variance, sizeof(double)*leaves);
+
+         if (slack == NULL || idx->variance == NULL)
+            exit(1);
+
+         for (i = 0; i < leaves * STOCHASTIC_BUCKETS; i++)
+            slack[leaves * STOCHASTIC_BUCKETS + i] = i < idx->leaves * STOCHASTIC_BUCKETS ?
+                                                     idx->slack[idx->leaves * STOCHASTIC_BUCKETS + i] : -HUGE_VAL;
+
+         for (i = leaves - 1; i > 0; i--)
+            for (k = 0; k < STOCHASTIC_BUCKETS; k++)
+            {
+               double left = slack[2*i*STOCHASTIC_BUCKETS + k];
+               double right = slack[(2*i+1)*STOCHASTIC_BUCKETS + k];
+
+               slack[i*STOCHASTIC_BUCKETS + k] = left > right ? left : right;
+            }
+
+         free(idx->slack);
+         idx->slack = slack;
+         idx->leaves = leaves;
+      }
+
+      idx->count++;
+   }
+
+   idx->variance[j] = variance;
+   node = idx->leaves + j;
+
+   for (k = 0; k < STOCHASTIC_BUCKETS; k++)
+      idx->slack[node*STOCHASTIC_BUCKETS + k] = BIN_SIZE - (double) mean - idx->z * sqrt(variance + idx->bound[k]);
+
+   for (node /= 2; node > 0; node /= 2)
+   {
+      double *parent = idx->slack + node*STOCHASTIC_BUCKETS;
+      const double *left = idx->slack + 2*node*STOCHASTIC_BUCKETS;
+      const double *right = left + STOCHASTIC_BUCKETS;
+
+      for (k = 0; k < STOCHASTIC_BUCKETS; k++)
+         parent[k] = left[k] > right[k] ? left[k] : right[k];
+   }
+
+   return 0;
+}
+
+/**
+ * Primeiro BIN, na ordem da lista, onde um item cabe sem passar da probabilidade de
+ * transbordar, a partir do nó \em node do índice. Um nó é descartado quando a maior
+ * folga da faixa do item não cobre a sua média; como a variância do item pode ser maior
+ * que o início da faixa, a busca pode voltar e tentar o filho da direita.
+ *
+ * \param idx Índice dos BINs.
+ * \param node Nó a partir do qual buscar, 1 para a raiz.
+ * \param k Faixa da variância do item.
+ * \param mean Média do item.
+ * \param variance Variância do item.
+ * \return A posição do BIN, ou -1 se o item não cabe em nenhum BIN da subárvore.
+ */
+long int stochastic_first (const stochastic_index *idx, unsigned int node, unsigned int k, unsigned short int mean,
+                           double variance)
+{
+   long int found;
+
+   if (idx->slack[node*STOCHASTIC_BUCKETS + k] + 1e-9 < mean)
+      return -1;
+
+   if (node >= idx->leaves)
+   {
+      double v = idx->variance[node - idx->leaves];
+      double slack = idx->slack[node*STOCHASTIC_BUCKETS] + idx->z * (sqrt(v) - sqrt(v + variance));
+
+      return slack + 1e-9 < mean ? -1 : (long int) (node - idx->leaves);
+   }
+
+   found = stochastic_first(idx, 2*node, k, mean, variance);
+
+   return found >= 0 ? found : stochastic_first(idx, 2*node + 1, k, mean, variance);
+}
+
+/**
+ * Compara dois itens pela chave, em ordem decrescente, e pela posição na entrada,
+ * mantendo a ordenação estável.
+ *
+ * \param a Primeiro ranked_item.
+ * \param b Segundo ranked_item.
+ * \return Negativo se \em a vem antes de \em b, positivo caso contrário.
+ */
+int compare_ranked_items (const void *a, const void *b)
+{
+   const ranked_item *x = a;
+   const ranked_item *y = b;
+
+   if (x->key != y->key)
+      return x->key > y->key ? -1 : 1;
+
+   return x->index < y->index ? -1 : 1;
+}
+
+/**
+ * Lê um item do modo estocástico no formato <tt>media:variancia</tt>, ou apenas a média,
+ * com variância zero.
+ *
+ * \param token Texto do item.
+ * \param mean Recebe a média.
+ * \param variance Recebe a variância.
+ * \return Zero após finalizado, 1 se o item é inválido.
+ */
+int parse_stochastic_item (const char *token, unsigned short int *mean, double *variance)
+{
+   char *end;
+   long int m = strtol(token, &end, 10);
+
+   *variance = 0;
+
+   if (end == token || m < 0 || m > 65535)
+      return 1;
+
+   if (*end == ':')
+   {
+      token = end + 1;
+      *variance = strtod(token, &end);
+
+      /** nan e inf são aceitos por strtod, mas não são variâncias. */
+      if (end == token || !isfinite(*variance) || *variance < 0)
+         return 1;
+   }
+
+   *mean = m;
+   return *end != '\0';
+}
+
+/**
+ * Executa o modo estocástico (opção <tt>-g</tt>). Os tamanhos dos itens são normais
+ * independentes, então um BIN com soma das médias M e das variâncias V transborda com
+ * probabilidade 1 - Φ((BIN_SIZE - M) / sqrt(V)), que fica no máximo em p enquanto
+ * M + z·sqrt(V) <= BIN_SIZE, com z = Φ⁻¹(1 - p). Os itens são ordenados pelo tamanho
+ * efetivo, média + z·sqrt(variância), e colocados pelo "First Fit" com esse teste, que
+ * não é aditivo: a busca usa o stochastic_index. A quantidade de itens não é limitada
+ * pelo NUMBERS_QUANTITY.
+ *
+ * \param args Argumentos posicionais.
+ * \param nargs Quantidade de argumentos posicionais.
+ * \return Zero após finalizado, 1 se algum item é inválido ou não cabe sozinho no BIN.
+ * \see stochastic_first
+ * \see normal_quantile
+ */
+int run_stochastic (char **args, int nargs)
+{
+   stochastic_index idx;
+   unsigned long int capacity = 1024;
+   unsigned long int n = 0;
+   unsigned short int *mean = malloc(sizeof(unsigned short int)*capacity);
+   double *variance = malloc(sizeof(double)*capacity);
+   ranked_item *order;
+   unsigned int *bin_of;
+   unsigned long int *bin_mean;
+   double *bin_variance;
+   unsigned int *start;
+   unsigned int *members;
+   unsigned long int nbins = 0;
+   unsigned long int i;
+   unsigned long int b;
+   double worst = 0;
+   int status = 0;
+   char token[64];
+
+   if (mean == NULL || variance == NULL)
+      exit(1);
+
+   memset(&idx, 0, sizeof(idx));
+   idx.z = normal_quantile(1 - STOCHASTIC_PROBABILITY);
+
+   /** Itens da entrada padrão, dos argumentos ou gerados, com a variância igual à média. */
+   for (i = 0; ; i++)
+   {
+      if (nargs == 5 && strcmp(args[4], "-") == 0)
+      {
+         if (scanf("%63s", token) != 1)
+            break;
+      }
+      else if (nargs > 4)
+      {
+         if (i >= (unsigned long int) nargs - 4)
+            break;
+
+         snprintf(token, sizeof(token), "%s", args[i + 4]);
+      }
+      else if (i >= strtoul(args[0], NULL, 10))
+         break;
+
+      if (n == capacity)
+      {
+         capacity *= 2;
+         mean = realloc(mean, sizeof(unsigned short int)*capacity);
+         variance = realloc(variance, sizeof(double)*capacity);
+
+         if (mean == NULL || variance == NULL)
+            exit(1);
+      }
+
+      if (nargs <= 4)
+      {
+         mean[n] = generate_random_number(NUMBERS_MINIMUM, NUMBERS_MAXIMUM);
+         variance[n] = mean[n];
+      }
+      else if (parse_stochastic_item(token, &mean[n], &variance[n]) != 0)
+      {
+         printf("Item estocástico inválido: %s (use media:variancia).\n", token);
+         free(mean);
+         free(variance);
+         return 1;
+      }
+
+      n++;
+   }
+
+   order = malloc(sizeof(ranked_item)*(n + 1));
+   bin_of = malloc(sizeof(unsigned int)*(n + 1));
+   bin_mean = malloc(sizeof(unsigned long int)*(n + 1));
+   bin_variance = malloc(sizeof(double)*(n + 1));
+   start = calloc(n + 2, sizeof(unsigned int));
+   members = malloc(sizeof(unsigned int)*(n + 1));
+
+   if (order == NULL || bin_of == NULL || bin_mean == NULL || bin_variance == NULL || start == NULL || members == NULL)
+      exit(1);
+
+   /** As faixas de variância começam nos quantis das variâncias dos itens. */
+   for (i = 0; i < n; i++)
+   {
+      order[i].key = variance[i];
+      order[i].index = i;
+   }
+
+   qsort(order, n, sizeof(ranked_item), compare_ranked_items);
+
+   for (b = 1; b < STOCHASTIC_BUCKETS; b++)
+      idx.bound[b] = n > 0 ? order[n - 1 - (n - 1) * b / STOCHASTIC_BUCKETS].key : 0;
+
+   for (i = 0; i < n; i++)
+   {
+      order[i].key = mean[i] + idx.z * sqrt(variance[i]);
+      order[i].index = i;
+   }
+
+   qsort(order, n, sizeof(ranked_item), compare_ranked_items);
+
+   printf("\nStochastic: %lu itens | P(transbordar) <= %g | z: %.4f\n\n", n, STOCHASTIC_PROBABILITY, idx.z);
+
+   if (n > 0 && order[0].key > BIN_SIZE + 1e-9)
+   {
+      printf("O item %u, %d:%g, não cabe sozinho em um BIN de tamanho %d.\n", order[0].index, mean[order[0].index],
+             variance[order[0].index], BIN_SIZE);
+      n = 0;
+      status = 1;
+   }
+
+   for (i = 0; i < n; i++)
+   {
+      unsigned int item = order[i].index;
+      unsigned int k = STOCHASTIC_BUCKETS - 1;
+      long int found;
+
+      while (idx.bound[k] > variance[item])
+         k--;
+
+      found = idx.count > 0 ? stochastic_first(&idx, 1, k, mean[item], variance[item]) : -1;
+
+      if (found < 0)
+      {
+         found = nbins++;
+         bin_mean[found] = 0;
+         bin_variance[found] = 0;
+      }
+
+      bin_mean[found] += mean[item];
+      bin_variance[found] += variance[item];
+      bin_of[item] = found;
+      stochastic_index_set(&idx, found, bin_mean[found], bin_variance[found]);
+   }
+
+   /** Agrupa os itens por BIN, na ordem em que foram colocados. */
+   for (i = 0; i < n; i++)
+      start[bin_of[order[i].index] + 1]++;
+
+   for (b = 0; b < nbins; b++)
+      start[b + 1] += start[b];
+
+   for (i = 0; i < n; i++)
+      members[start[bin_of[order[i].index]]++] = order[i].index;
+
+   for (b = nbins; b > 0; b--)
+      start[b] = start[b - 1];
+
+   start[0] = 0;
+
+   for (b = 0; b < nbins; b++)
+   {
+      double overflow = 0;
+
+      if (bin_variance[b] > 0)
+         overflow = 0.5 * erfc((BIN_SIZE - (double) bin_mean[b]) / sqrt(2 * bin_variance[b]));
+
+      if (overflow > worst)
+         worst = overflow;
+
+      printf(" {%04lu} Mean: %5lu | Var: %9.1f | P(overflow): %.6f | Count: %4u | Itens: ", b, bin_mean[b],
+             bin_variance[b], overflow, start[b + 1] - start[b]);
+
+      for (i = start[b]; i < start[b + 1]; i++)
+         printf("%s%d:%g", i > start[b] ? ", " : "", mean[members[i]], variance[members[i]]);
+
+      printf("\n");
+   }
+
+   printf("\nStochastic: Bins: %lu | Maior P(overflow): %.6f\n\n", nbins, worst);
+
+   free(idx.slack);
+   free(idx.variance);
+   free(mean);
+   free(variance);
+   free(order);
+   free(bin_of);
+   free(bin_mean);
+   free(bin_variance);
+   free(start);
+   free(members);
+
+   return status;
+}
+
+/**
+ * Lê um item do modo mochila múltipla no formato <tt>tamanho:valor</tt>, ou apenas o
+ * tamanho, que é também o valor.
+ *
+ * \param token Texto do item.
+ * \param size Recebe o tamanho.
+ * \param value Recebe o valor.
+ * \return Zero após finalizado, 1 se o item é inválido.
+ */
+int parse_knapsack_item (const char *token, unsigned short int *size, unsigned int *value)
+{
+   char *end;
+   long int s = strtol(token, &end, 10);
+   long int v = s;
+
+   if (end == token || s < 0 || s > 65535)
+      return 1;
+
+   if (*end == ':')
+   {
+      token = end + 1;
+      v = strtol(token, &end, 10);
+
+      if (end == token || v < 0 || v > 4294967295L)
+         return 1;
+   }
+
+   *size = s;
+   *value = v;
+   return *end != '\0';
+}
+
+/**
+ * Melhora um BIN da mochila múltipla por programação dinâmica: resolve a mochila de
+ * capacidade BIN_SIZE sobre os itens do BIN e os \em count itens de fora em \em extra.
+ * Os itens atuais do BIN são uma solução possível, então o valor nunca diminui; os que
+ * saem do BIN voltam para fora.
+ *
+ * \param size Tamanho de cada item.
+ * \param value Valor de cada item.
+ * \param bin_of BIN de cada item, -1 para os de fora; é atualizado.
+ * \param left Espaço restante de cada BIN; é atualizado.
+ * \param b BIN a ser melhorado.
+ * \param members Itens do BIN.
+ * \param size_members Quantidade de itens do BIN.
+ * \param extra Itens de fora oferecidos.
+ * \param count Quantidade de itens de fora.
+ * \return O ganho de valor.
+ */
+unsigned long int knapsack_improve_bin (const unsigned short int *size, const unsigned int *value, int *bin_of,
+                                        unsigned short int *left, unsigned int b, const unsigned int *members,
+                                        unsigned int size_members, const unsigned int *extra, unsigned int count)
+{
+   unsigned int m = size_members + count;
+   unsigned int words = (BIN_SIZE + 64) / 64;
+   unsigned long int *best = calloc((size_t) BIN_SIZE + 1, sizeof(unsigned long int));
+   unsigned long long int *take = calloc((size_t) m * words, sizeof(unsigned long long int));
+   unsigned long int before = 0;
+   unsigned long int gain;
+   unsigned int used = 0;
+   unsigned int i;
+   int c;
+
+   if (best == NULL || take == NULL)
+      exit(1);
+
+   for (i = 0; i < m; i++)
+   {
+      unsigned int item = i < size_members ? members[i] : extra[i - size_members];
+      unsigned short int s = size[item];
+
+      if (i < size_members)
+         before += value[item];
+
+      for (c = BIN_SIZE; c >= s; c--)
+      {
+         if (best[c - s] + value[item] > best[c])
+         {
+            best[c] = best[c - s] + value[item];
+            take[(size_t) i * words + c / 64] |= 1ULL << (c % 64);
+         }
+      }
+   }
+
+   gain = best[BIN_SIZE] - before;
+
+   /** Só troca quando há ganho, mantendo os itens do BIN em caso de empate. */
+   if (gain > 0)
+   {
+      for (i = 0; i < size_members; i++)
+         bin_of[members[i]] = -1;
+
+      for (c = BIN_SIZE, i = m; i-- > 0; )
+      {
+         unsigned int item = i < size_members ? members[i] : extra[i - size_members];
+
+         if (take[(size_t) i * words + c / 64] & (1ULL << (c % 64)))
+         {
+            bin_of[item] = b;
+            c -= size[item];
+            used += size[item];
+         }
+      }
+
+      left[b] = BIN_SIZE - used;
+   }
+
+   free(best);
+   free(take);
+
+   return gain;
+}
+
+/**
+ * Executa o modo mochila múltipla (opção <tt>-K</tt>): há KNAPSACK_BINS BINs de tamanho
+ * BIN_SIZE e cada item, de tamanho e valor informados, pode ficar de fora. Três fases:
+ *    - Guloso: os itens, em ordem decrescente de densidade (valor / tamanho), vão para o
+ *      primeiro BIN onde cabem, encontrado no fit_index em tempo logarítmico;
+ *    - Reparo: cada item de fora, do mais valioso para o menos, é trocado pelo item
+ *      colocado de menor valor, entre os KNAPSACK_REPAIR_CANDIDATES primeiros, cujo lugar
+ *      (mais o espaço restante do BIN) comporta o item de fora; o item retirado volta ao
+ *      primeiro BIN onde couber, se houver;
+ *    - Programação dinâmica: enquanto houver orçamento (KNAPSACK_DP_BUDGET células),
+ *      cada BIN é resolvido de forma exata sobre os seus itens e os KNAPSACK_DP_ITEMS
+ *      itens de fora mais densos.
+ * O limite superior impresso é o da relaxação linear, com capacidade total
+ * KNAPSACK_BINS · BIN_SIZE.
+ *
+ * \param args Argumentos posicionais.
+ * \param nargs Quantidade de argumentos posicionais.
+ * \return Zero após finalizado, 1 se algum item é inválido.
+ * \see knapsack_improve_bin
+ * \see fit_index
+ */
+int run_knapsack (char **args, int nargs)
+{
+   unsigned long int capacity = 1024;
+   unsigned long int n = 0;
+   unsigned short int *size = malloc(sizeof(unsigned short int)*capacity);
+   unsigned int *value = malloc(sizeof(unsigned int)*capacity);
+   unsigned int nbins = KNAPSACK_BINS;
+   ranked_item *order;
+   ranked_item *cheap;
+   unsigned int *outside;
+   unsigned int *members;
+   unsigned int *start;
+   unsigned short int *left;
+   unsigned short int *pool;
+   int *bin_of;
+   bin *bins;
+   fit_index idx;
+   struct timespec began;
+   unsigned long int packed = 0;
+   unsigned long int total = 0;
+   unsigned long int greedy;
+   unsigned long int repaired;
+   unsigned long int budget = KNAPSACK_DP_BUDGET;
+   unsigned long int noutside = 0;
+   unsigned long int ncheap = 0;
+   unsigned long int i;
+   unsigned long int k;
+   unsigned int b;
+   double room = (double) KNAPSACK_BINS * BIN_SIZE;
+   double bound = 0;
+   char token[64];
+
+   if (size == NULL || value == NULL)
+      exit(1);
+
+   /** Itens da entrada padrão, dos argumentos ou gerados. */
+   for (i = 0; ; i++)
+   {
+      if (nargs == 5 && strcmp(args[4], "-") == 0)
+      {
+         if (scanf("%63s", token) != 1)
+            break;
+      }
+      else if (nargs > 4)
+      {
+         if (i >= (unsigned long int) nargs - 4)
+            break;
+
+         snprintf(token, sizeof(token), "%s", args[i + 4]);
+      }
+      else if (i >= strtoul(args[0], NULL, 10))
+         break;
+
+      if (n == capacity)
+      {
+         capacity *= 2;
+         size = realloc(size, sizeof(unsigned short int)*capacity);
+         value = realloc(value, sizeof(unsigned int)*capacity);
+
+         if (size == NULL || value == NULL)
+            exit(1);
+      }
+
+      if (nargs <= 4)
+      {
+         size[n] = generate_random_number(NUMBERS_MINIMUM, NUMBERS_MAXIMUM);
+         value[n] = generate_random_number(NUMBERS_MINIMUM, NUMBERS_MAXIMUM);
+      }
+      else if (parse_knapsack_item(token, &size[n], &value[n]) != 0)
+      {
+         printf("Item inválido: %s (use tamanho:valor).\n", token);
+         free(size);
+         free(value);
+         return 1;
+      }
+
+      n++;
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &began);
+
+   order = malloc(sizeof(ranked_item)*(n + 1));
+   cheap = malloc(sizeof(ranked_item)*(n + 1));
+   outside = malloc(sizeof(unsigned int)*(n + 1));
+   members = malloc(sizeof(unsigned int)*(n + 1));
+   start = calloc((size_t) nbins + 2, sizeof(unsigned int));
+   left = malloc(sizeof(unsigned short int)*nbins);
+   pool = malloc(sizeof(unsigned short int)*(n + 1));
+   bin_of = malloc(sizeof(int)*(n + 1));
+   bins = malloc(sizeof(bin)*nbins);
+
+   if (order == NULL || cheap == NULL || outside == NULL || members == NULL || start == NULL || left == NULL ||
+       pool == NULL || bin_of == NULL || bins == NULL)
+      exit(1);
+
+   for (b = 0; b < nbins; b++)
+   {
+      bins[b].left = BIN_SIZE;
+      bins[b].count = 0;
+      left[b] = BIN_SIZE;
+   }
+
+   fit_index_build(&idx, bins, nbins, BIN_SIZE);
+
+   for (i = 0; i < n; i++)
+   {
+      order[i].key = size[i] > 0 ? (double) value[i] / size[i] : HUGE_VAL;
+      order[i].index = i;
+      bin_of[i] = -1;
+   }
+
+   qsort(order, n, sizeof(ranked_item), compare_ranked_items);
+
+   /** Fase gulosa, que também calcula o limite da relaxação linear. */
+   for (i = 0; i < n; i++)
+   {
+      unsigned int item = order[i].index;
+      int j;
+
+      if (size[item] > BIN_SIZE)
+         continue;
+
+      if (room > 0)
+      {
+         double part = size[item] <= room ? 1 : room / size[item];
+
+         bound += part * value[item];
+         room -= part * size[item];
+      }
+
+      j = fit_index_first(&idx, size[item]);
+
+      if (j < 0)
+      {
+         outside[noutside++] = item;
+         continue;
+      }
+
+      bin_of[item] = j;
+      left[j] -= size[item];
+      fit_index_set(&idx, j, left[j]);
+      total += value[item];
+   }
+
+   greedy = total;
+
+   /** Fase de reparo: os colocados, do menor valor para o maior, são os candidatos a sair. */
+   for (i = n; i-- > 0; )
+   {
+      unsigned int item = order[i].index;
+
+      if (bin_of[item] >= 0)
+      {
+         cheap[ncheap].key = value[item];
+         cheap[ncheap++].index = item;
+      }
+   }
+
+   qsort(cheap, ncheap, sizeof(ranked_item), compare_ranked_items);
+
+   for (i = 0; i < noutside; i++)
+   {
+      unsigned int item = outside[i];
+      unsigned long int tried = 0;
+
+      for (k = ncheap; k-- > 0 && tried < KNAPSACK_REPAIR_CANDIDATES; )
+      {
+         unsigned int victim = cheap[k].index;
+         int j = bin_of[victim];
+         int moved;
+
+         if (j < 0)
+            continue;
+
+         if (value[victim] >= value[item])
+            break;
+
+         tried++;
+
+         if (left[j] + size[victim] < size[item])
+            continue;
+
+         /** O item de fora entra no lugar do retirado, que volta se couber em algum BIN. */
+         bin_of[item] = j;
+         bin_of[victim] = -1;
+         left[j] = left[j] + size[victim] - size[item];
+         fit_index_set(&idx, j, left[j]);
+         total += value[item] - value[victim];
+
+         moved = fit_index_first(&idx, size[victim]);
+
+         if (moved >= 0)
+         {
+            bin_of[victim] = moved;
+            left[moved] -= size[victim];
+            fit_index_set(&idx, moved, left[moved]);
+            total += value[victim];
+         }
+         else
+         {
+            outside[i] = victim;
+         }
+
+         break;
+      }
+
+      /** Candidatos que saíram dos BINs no fim da lista não precisam ser vistos de novo. */
+      while (ncheap > 0 && bin_of[cheap[ncheap - 1].index] < 0)
+         ncheap--;
+   }
+
+   repaired = total;
+
+   /** Fase de programação dinâmica, BIN a BIN, enquanto houver orçamento. */
+   for (i = 0; i < n; i++)
+      if (bin_of[i] >= 0)
+         start[bin_of[i] + 1]++;
+
+   for (b = 0; b < nbins; b++)
+      start[b + 1] += start[b];
+
+   for (i = 0; i < n; i++)
+      if (bin_of[i] >= 0)
+         members[start[bin_of[i]]++] = i;
+
+   for (b = nbins; b > 0; b--)
+      start[b] = start[b - 1];
+
+   start[0] = 0;
+   k = 0;
+
+   for (b = 0; b < nbins && budget > 0; b++)
+   {
+      unsigned int extra[KNAPSACK_DP_ITEMS];
+      unsigned int count = 0;
+      unsigned long int cells;
+      unsigned long int scan;
+
+      for (scan = k; scan < n && count < KNAPSACK_DP_ITEMS; scan++)
+      {
+         unsigned int item = order[scan].index;
+
+         if (bin_of[item] < 0 && size[item] <= BIN_SIZE)
+            extra[count++] = item;
+         else if (scan == k)
+            k++;
+      }
+
+      cells = (unsigned long int) (start[b + 1] - start[b] + count) * (BIN_SIZE + 1);
+
+      if (count == 0 || cells > budget)
+         break;
+
+      budget -= cells;
+      total += knapsack_improve_bin(size, value, bin_of, left, b, members + start[b], start[b + 1] - start[b], extra,
+                                    count);
+   }
+
+   /** Reúne os itens de cada BIN, na ordem de densidade, para a impressão. */
+   memset(start, 0, sizeof(unsigned int)*(nbins + 2));
+
+   for (i = 0; i < n; i++)
+      if (bin_of[i] >= 0)
+      {
+         start[bin_of[i] + 1]++;
+         packed++;
+      }
+
+   for (b = 0; b < nbins; b++)
+      start[b + 1] += start[b];
+
+   for (i = 0; i < n; i++)
+   {
+      unsigned int item = order[i].index;
+
+      if (bin_of[item] >= 0)
+      {
+         members[start[bin_of[item]]] = item;
+         pool[start[bin_of[item]]++] = size[item];
+      }
+   }
+
+   for (b = nbins; b > 0; b--)
+      start[b] = start[b - 1];
+
+   start[0] = 0;
+
+   for (b = 0; b < nbins; b++)
+   {
+      unsigned long int worth = 0;
+
+      bins[b].itens = pool + start[b];
+      bins[b].count = start[b + 1] - start[b];
+      bins[b].left = left[b];
+
+      for (k = start[b]; k < start[b + 1]; k++)
+         worth += value[members[k]];
+
+      printf(" {%04d} Value: %8lu | ", b, worth);
+      print_bin(bins + b);
+   }
+
+   printf("\nKnapsack: Bins: %u | Itens: %lu de %lu | Value: %lu (guloso: %lu, reparo: %lu) | LP bound: %.0f | "
+          "Gap: %.3f%% | %.3f ms\n\n", nbins, packed, n, total, greedy, repaired, floor(bound),
+          bound > 0 ? 100.0 * (bound - total) / bound : 0.0, elapsed_us(&began) / 1000.0);
+
+   fit_index_free_arrays(&idx);
+   free(size);
+   free(value);
+   free(order);
+   free(cheap);
+   free(outside);
+   free(members);
+   free(start);
+   free(left);
+   free(pool);
+   free(bin_of);
+   free(bins);
+
+   return 0;
+}
+
+/**
+ * Executa o empacotamento guardando as posições originais (opção <tt>-p</tt>). Os
+ * números são ordenados por sort_records_desc junto com as suas posições, empacotados
+ * pelo motor do FFD e cada item é impresso como <tt>tamanho\#posição</tt>. Ao final,
+ * imprime o BIN de cada item na ordem da entrada.
+ *
+ * \param values Números na ordem da entrada.
+ * \return Zero após finalizado, 1 se algum número não cabe no BIN.
+ * \see sort_records_desc
+ * \see run_engine
+ */
+int run_positions (unsigned short int *values)
+{
+   unsigned short int n = NUMBERS_QUANTITY;
+   unsigned short int *sorted = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned long int *positions = malloc(sizeof(unsigned long int)*(n + 1));
+   unsigned short int *left = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int *bin_of = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int *assignment = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned int *start = calloc((size_t) n + 2, sizeof(unsigned int));
+   unsigned short int *members = malloc(sizeof(unsigned short int)*(n + 1));
+   int engine = ENGINE;
+   int used;
+   int status = 0;
+   int j;
+   unsigned int i;
+
+   if (sorted == NULL || positions == NULL || left == NULL || bin_of == NULL || assignment == NULL || start == NULL ||
+       members == NULL)
+      exit(1);
+
+   sort_records_desc(values, n, sorted, positions, NULL);
+   print_numbers(sorted);
+
+   if (n > 0 && sorted[0] > BIN_SIZE)
+   {
+      printf("O número %d, na posição %lu, não cabe em um BIN de tamanho %d.\n", sorted[0], positions[0], BIN_SIZE);
+      n = 0;
+      status = 1;
+   }
+
+   if (engine == ENGINE_AUTO)
+      engine = select_engine(sorted, n, BIN_SIZE);
+
+   used = n > 0 ? run_engine(engine, sorted, n, BIN_SIZE, left, bin_of) : 0;
+
+   /** Agrupa os itens por BIN, mantendo a ordem decrescente dentro de cada BIN. */
+   for (i = 0; i < n; i++)
+   {
+      start[bin_of[i] + 1]++;
+      assignment[positions[i]] = bin_of[i];
+   }
+
+   for (j = 0; j < used; j++)
+      start[j + 1] += start[j];
+
+   for (i = 0; i < n; i++)
+      members[start[bin_of[i]]++] = i;
+
+   for (j = used; j > 0; j--)
+      start[j] = start[j - 1];
+
+   start[0] = 0;
+
+   for (j = 0; j < used; j++)
+   {
+      printf(" {%04d} Left: %4d | Count: %4d | Itens: ", j, left[j], start[j + 1] - start[j]);
+
+      for (i = start[j]; i < start[j + 1]; i++)
+         printf("%s%4d#%lu", i > start[j] ? ", " : "", sorted[members[i]], positions[members[i]]);
+
+      printf("\n");
+   }
+
+   printf("\nAssignment:");
+
+   for (i = 0; i < n; i++)
+      printf(" %d", assignment[i]);
+
+   printf("\n\n");
+
+   free(sorted);
+   free(positions);
+   free(left);
+   free(bin_of);
+   free(assignment);
+   free(start);
+   free(members);
+
+   return status;
+}
+
+/**
+ * Menor quantidade de bits que comporta qualquer item de um BIN com a capacidade
+ * informada.
+ *
+ * \param capacity Capacidade do BIN.
+ * \return A largura em bits, no mínimo 1.
+ */
+unsigned char packed_width (unsigned short int capacity)
+{
+   unsigned char width = 1;
+
+   while (width < 16 && (capacity >> width) != 0)
+      width++;
+
+   return width;
+}
+
+/**
+ * Escreve um item no pool, a partir do bit informado. O pool deve ter sido zerado, já
+ * que os bits são combinados com OR.
+ *
+ * \param bytes Pool, com dois bytes a mais no final.
+ * \param bit Posição do primeiro bit do item.
+ * \param width Largura do item em bits.
+ * \param value Item, que deve caber em \em width bits.
+ * \return Zero após finalizado.
+ */
+int packed_put (unsigned char *bytes, unsigned long int bit, unsigned char width, unsigned short int value)
+{
+   unsigned long int byte = bit >> 3;
+   unsigned long int chunk = (unsigned long int) (value & ((1u << width) - 1)) << (bit & 7);
+
+   /** Com até 16 bits de item e 7 de deslocamento, o item ocupa no máximo três bytes. */
+   bytes[byte] |= chunk & 255;
+   bytes[byte + 1] |= (chunk >> 8) & 255;
+   bytes[byte + 2] |= (chunk >> 16) & 255;
+
+   return 0;
+}
+
+/**
+ * Lê os itens de um BIN do pool. Os bytes são consumidos em sequência por um acumulador,
+ * sem recalcular a posição de cada item.
+ *
+ * \param pool Pool compacto.
+ * \param b BIN a ser lido.
+ * \param out Recebe os itens do BIN, na ordem em que foram colocados.
+ * \return A quantidade de itens do BIN.
+ */
+unsigned short int packed_unpack (const packed_pool *pool, unsigned short int b, unsigned short int *out)
+{
+   unsigned short int count = pool->start[b + 1] - pool->start[b];
+   unsigned long int bit = (unsigned long int) pool->start[b] * pool->width;
+   unsigned long int byte = bit >> 3;
+   unsigned long int acc = pool->bytes[byte] >> (bit & 7);
+   unsigned int bits = 8 - (bit & 7);
+   unsigned int mask = (1u << pool->width) - 1;
+   unsigned short int i;
+
+   for (i = 0; i < count; i++)
+   {
+      while (bits < pool->width)
+      {
+         acc |= (unsigned long int) pool->bytes[++byte] << bits;
+         bits += 8;
+      }
+
+      out[i] = acc & mask;
+      acc >>= pool->width;
+      bits -= pool->width;
+   }
+
+   return count;
+}
+
+/**
+ * Executa o empacotamento com armazenamento compacto (opção <tt>-m</tt>). O motor do FFD
+ * escolhe o BIN de cada número e, em seguida, os itens são espalhados por BIN direto no
+ * pool de \em width bits por item. O array de espaço restante do motor é reaproveitado
+ * como o início de cada BIN e o de BIN por número é liberado antes da impressão, então o
+ * pico de memória é o do motor mais o pool, abaixo do de fill_bins_engine, que ainda
+ * aloca os itens de cada BIN. A compactação vale para o resultado guardado; durante o
+ * empacotamento o motor usa os seus arrays de 16 bits como nos outros modos. A saída é a
+ * mesma do modo padrão, seguida da memória usada.
+ *
+ * \param values Ponteiro para o array de números, ainda fora de ordem.
+ * \return Zero após finalizado, 1 se algum número não cabe no BIN.
+ * \see packed_pool
+ * \see run_engine
+ */
+int run_compact (unsigned short int *values)
+{
+   unsigned short int n = NUMBERS_QUANTITY;
+   unsigned short int *left;
+   unsigned short int *bin_of;
+   unsigned short int *out;
+   unsigned short int largest;
+   unsigned long int size;
+   unsigned long int pool_bytes;
+   unsigned long int list_bytes;
+   packed_pool pool;
+   int engine = ENGINE;
+   int used;
+   int j;
+   unsigned short int i;
+
+   sort_numbers_array(values);
+   print_numbers(values);
+
+   if (n > 0 && values[0] > BIN_SIZE)
+   {
+      printf("O número %d não cabe em um BIN de tamanho %d.\n", values[0], BIN_SIZE);
+      return 1;
+   }
+
+   left = malloc(sizeof(unsigned short int)*(n + 1));
+   bin_of = malloc(sizeof(unsigned short int)*(n + 1));
+
+   if (left == NULL || bin_of == NULL)
+      exit(1);
+
+   if (engine == ENGINE_AUTO)
+      engine = select_engine(values, n, BIN_SIZE);
+
+   used = n > 0 ? run_engine(engine, values, n, BIN_SIZE, left, bin_of) : 0;
+
+   pool.width = packed_width(BIN_SIZE);
+   pool.count = used;
+   size = ((unsigned long int) n * pool.width + 7) / 8;
+   pool.bytes = calloc(size + 2, 1);
+
+   if (pool.bytes == NULL)
+      exit(1);
+
+   /**
+    * O espaço restante é recalculado na leitura, então \em left passa a contar os itens
+    * de cada BIN e, pela soma acumulada, a guardar onde cada um começa no pool.
+    */
+   memset(left, 0, sizeof(unsigned short int)*(used + 1));
+
+   for (i = 0; i < n; i++)
+      left[bin_of[i]]++;
+
+   for (j = 0, i = 0; j <= used; j++)
+   {
+      unsigned short int c = j < used ? left[j] : 0;
+      left[j] = i;
+      i += c;
+   }
+
+   /** Cada início serve de cursor; ao final, left[j] é o início do BIN j + 1. */
+   for (i = 0; i < n; i++)
+      packed_put(pool.bytes, (unsigned long int) left[bin_of[i]]++ * pool.width, pool.width, values[i]);
+
+   for (j = used; j > 0; j--)
+      left[j] = left[j - 1];
+
+   left[0] = 0;
+   free(bin_of);
+
+   pool.start = left;
+
+   /** O buffer de leitura precisa comportar apenas o maior BIN. */
+   for (j = 0, largest = 0; j < used; j++)
+      if (pool.start[j + 1] - pool.start[j] > largest)
+         largest = pool.start[j + 1] - pool.start[j];
+
+   out = malloc(sizeof(unsigned short int)*(largest + 1));
+
+   if (out == NULL)
+      exit(1);
+
+   for (j = 0; j < used; j++)
+   {
+      unsigned short int count = packed_unpack(&pool, j, out);
+      unsigned int sum = 0;
+
+      for (i = 0; i < count; i++)
+         sum += out[i];
+
+      printf(" {%04d} Left: %4d | Count: %4d | Itens: ", j, BIN_SIZE - sum, count);
+
+      for (i = 0; i < count; i++)
+         printf(i == count - 1 ? "%4d" : "%4d, ", out[i]);
+
+      printf("\n");
+   }
+
+   pool_bytes = size + 2 + sizeof(unsigned short int)*(used + 1);
+   list_bytes = sizeof(unsigned short int)*n + sizeof(bin)*used;
+
+   printf("\n\nCompact: Bits: %d | Pool: %lu bytes | Lista de BINs: %lu bytes\n\n", pool.width, pool_bytes,
+          list_bytes);
+
+   free(out);
+   free(pool.bytes);
+   free(pool.start);
+
+   return 0;
+}
+
+/**
+ * Converte um tamanho decimal para inteiro na escala FIXED_SCALE, de forma exata. A parte
+ * inteira e até 9 casas decimais são lidas como um único inteiro \em m com \em d casas, e
+ * o resultado é m * FIXED_SCALE / 10^d, arredondado para cima ou para baixo, com divisão
+ * inteira. Casas além da nona só influem no arredondamento para cima. Um tamanho que
+ * passa de 65535 na escala encerra o programa, em vez de ser truncado.
+ *
+ * \param token Texto com o tamanho, como <tt>0.37</tt> ou <tt>2</tt>.
+ * \param end Recebe a posição do primeiro caractere não lido, ou NULL.
+ * \param up Diferente de zero para arredondar para cima.
+ * \param error Recebe a diferença entre o inteiro e o tamanho exato, em unidades da escala.
+ * \return O tamanho na escala.
+ */
+unsigned short int parse_fixed (const char *token, char **end, int up, double *error)
+{
+   unsigned long long int mantissa = 0;
+   unsigned long long int power = 1;
+   unsigned long long int fraction;
+   unsigned long long int floor_quotient;
+   unsigned long long int quotient;
+   unsigned long long int remainder;
+   const char *cursor = token;
+   char sticky = 0;
+   char too_large = 0;
+
+   /** Uma parte inteira acima de 65535 já passa do limite em qualquer escala. */
+   while (*cursor >= '0' && *cursor <= '9')
+   {
+      if (mantissa <= 65535)
+         mantissa = mantissa * 10 + (*cursor - '0');
+      else
+         too_large = 1;
+
+      cursor++;
+   }
+
+   if (mantissa > 65535)
+      too_large = 1;
+
+   if (*cursor == '.')
+   {
+      for (cursor++; *cursor >= '0' && *cursor <= '9'; cursor++)
+      {
+         if (power < 1000000000ULL)
+         {
+            mantissa = mantissa * 10 + (*cursor - '0');
+            power *= 10;
+         }
+         else if (*cursor != '0')
+            sticky = 1;
+      }
+   }
+
+   if (end != NULL)
+      *end = (char *) cursor;
+
+   /**
+    * Parte inteira e fração são multiplicadas pela escala separadamente: a parte inteira
+    * tem até 16 bits, a fração é menor que 10^9 e a escala cabe em 32 bits, então nenhum
+    * dos produtos estoura 64 bits.
+    */
+   fraction = (mantissa % power) * FIXED_SCALE;
+   floor_quotient = (mantissa / power) * FIXED_SCALE + fraction / power;
+   remainder = fraction % power;
+   quotient = floor_quotient;
+
+   if (up && (remainder != 0 || sticky))
+      quotient++;
+
+   if (too_large || quotient > 65535)
+   {
+      printf("Tamanho inválido: %.*s passa de 65535 na escala %u.\n", (int) (cursor - token), token, FIXED_SCALE);
+      exit(1);
+   }
+
+   *error = (double) (quotient - floor_quotient) - (double) remainder / power;
+
+   return quotient;
+}
+
+/**
+ * Lê o tamanho de um item. Sem a opção -x é um inteiro; com ela, um decimal convertido
+ * por parse_fixed para cima, cujo erro é acumulado em FIXED_ERROR.
+ *
+ * \param token Texto com o tamanho.
+ * \param end Recebe a posição do primeiro caractere não lido, ou NULL.
+ * \return O tamanho inteiro.
+ * \see parse_fixed
+ */
+unsigned short int parse_size (const char *token, char **end)
+{
+   unsigned short int size;
+   double error;
+
+   if (FIXED_SCALE == 0)
+      return strtol(token, end, 10);
+
+   size = parse_fixed(token, end, 1, &error);
+
+   FIXED_ERROR.items++;
+   FIXED_ERROR.total += error;
+   FIXED_ERROR.exact += size - error;
+
+   if (error > 0)
+      FIXED_ERROR.rounded++;
+
+   if (error > FIXED_ERROR.largest)
+      FIXED_ERROR.largest = error;
+
+   return size;
+}
+
+/**
+ * Imprime o erro de arredondamento dos itens lidos com a opção -x, no tamanho original. Se
+ * o arredondamento aumenta o limite inferior da quantidade de BINs, isto é, a soma dos
+ * itens dividida pela capacidade, avisa que a escala é pequena demais: nesse caso o
+ * arredondamento pode custar BINs que os tamanhos exatos não precisariam.
+ *
+ * \param bin_token Texto com o BIN_SIZE, para calcular o quanto ele foi arredondado.
+ * \return Zero após finalizado.
+ * \see FIXED_ERROR
+ */
+int print_rounding_error (const char *bin_token)
+{
+   double bin_error;
+   double capacity;
+   double exact_bound;
+   double rounded_bound;
+
+   parse_fixed(bin_token, NULL, 0, &bin_error);
+   capacity = BIN_SIZE - bin_error;
+
+   printf("\nFixed point: Escala: %u | BIN_SIZE: %d | Arredondados: %u de %u | Erro total: %.6f | Maior erro: %.6f"
+          " | Erro do BIN: %.6f\n", FIXED_SCALE, BIN_SIZE, FIXED_ERROR.rounded, FIXED_ERROR.items,
+          FIXED_ERROR.total / FIXED_SCALE, FIXED_ERROR.largest / FIXED_SCALE, fabs(bin_error) / FIXED_SCALE);
+
+   if (BIN_SIZE == 0)
+      return 0;
+
+   exact_bound = ceil(FIXED_ERROR.exact / capacity - 1e-9);
+   rounded_bound = ceil((FIXED_ERROR.exact + FIXED_ERROR.total) / BIN_SIZE - 1e-9);
+
+   if (rounded_bound > exact_bound)
+      printf("Atenção: o arredondamento aumenta o limite inferior de %.0f para %.0f BINs; use uma escala maior.\n",
+             exact_bound, rounded_bound);
+
+   return 0;
+}
+
+/**
+ * Interpreta o parâmetro da opção -H, no formato <tt>cap[,slots[,c]]</tt>.
+ *
+ * \param arg Parâmetro da opção.
+ * \return 0 caso seja válido, 1 caso contrário.
+ */
+int parse_racks (char *arg)
+{
+   unsigned int capacity;
+   unsigned int slots = 0;
+   char flag = 0;
+   int fields = sscanf(arg, "%u,%u,%c", &capacity, &slots, &flag);
+
+   if (fields < 1 || capacity == 0 || capacity > 65535 || (fields == 3 && flag != 'c'))
+   {
+      printf("Parâmetro da opção -H inválido: %s\n", arg);
+      return 1;
+   }
+
+   RACK_CAPACITY = capacity;
+   RACK_SLOTS = slots;
+   RACK_COOPTIMIZE = fields == 3;
+   return 0;
+}
+
+/**
+ * Tenta esvaziar o último rack. Primeiro, do menor para o maior, os itens de cada BIN do
+ * rack vão para o primeiro BIN de outro rack onde cabem, respeitando o espaço do BIN e o
+ * do rack; um BIN que fica vazio libera a sua posição no rack. Depois, os BINs que
+ * sobraram vão inteiros para o primeiro rack com espaço e posição livre. Todo movimento
+ * mantém a solução válida, então nada é desfeito se o rack não ficar vazio.
+ *
+ * \param bins Lista de BINs.
+ * \param rack_of Rack de cada BIN, -1 para BINs vazios.
+ * \param rack_left Espaço restante de cada rack.
+ * \param rack_bins Quantidade de BINs de cada rack.
+ * \param racks Quantidade de racks.
+ * \param moved Recebe a soma dos itens e BINs movidos.
+ * \return 1 se o último rack ficou vazio, 0 caso contrário.
+ */
+int rack_empty_last (bin_list *bins, int *rack_of, unsigned int *rack_left, unsigned int *rack_bins, unsigned int racks,
+                     unsigned long int *moved)
+{
+   int r = racks - 1;
+   int j;
+   int k;
+   unsigned int q;
+
+   for (j = 0; j < bins->count; j++)
+   {
+      bin *b = bins->itens + j;
+      int i;
+
+      if (rack_of[j] != r)
+         continue;
+
+      for (i = b->count - 1; i >= 0; i--)
+      {
+         unsigned short int num = b->itens[i];
+
+         for (k = 0; k < bins->count; k++)
+            if (rack_of[k] >= 0 && rack_of[k] != r && bins->itens[k].left >= num && rack_left[rack_of[k]] >= num)
+               break;
+
+         if (k == bins->count)
+            continue;
+
+         insert_number_bin(bins->itens + k, num);
+         rack_left[rack_of[k]] -= num;
+         memmove(b->itens + i, b->itens + i + 1, sizeof(unsigned short int)*(b->count - i - 1));
+         b->count--;
+         b->left += num;
+         rack_left[r] += num;
+         (*moved)++;
+      }
+
+      if (b->count == 0)
+      {
+         rack_of[j] = -1;
+         rack_bins[r]--;
+      }
+   }
+
+   for (j = 0; j < bins->count; j++)
+   {
+      unsigned int load = BIN_SIZE - bins->itens[j].left;
+
+      if (rack_of[j] != r)
+         continue;
+
+      for (q = 0; q < (unsigned int) r; q++)
+         if (rack_left[q] >= load && (RACK_SLOTS == 0 || rack_bins[q] < RACK_SLOTS))
+            break;
+
+      if (q == (unsigned int) r)
+         continue;
+
+      rack_of[j] = q;
+      rack_left[q] -= load;
+      rack_bins[q]++;
+      rack_left[r] += load;
+      rack_bins[r]--;
+      (*moved)++;
+   }
+
+   return rack_bins[r] == 0;
+}
+
+/**
+ * Grava um inteiro sem sinal de \em bytes bytes, do menos para o mais significativo.
+ *
+ * \param file Arquivo.
+ * \param value Valor.
+ * \param bytes Quantidade de bytes, até 4.
+ * \return 0 caso tenha gravado, 1 em caso de erro.
+ */
+int write_le (FILE *file, unsigned long int value, int bytes)
+{
+   unsigned char raw[4];
+   int k;
+
+   for (k = 0; k < bytes; k++)
+      raw[k] = value >> (8 * k);
+
+   return fwrite(raw, bytes, 1, file) == 1 ? 0 : 1;
+}
+
+/**
+ * Grava os racks em formato binário, com inteiros little-endian. O arquivo começa com
+ * RACKS_MAGIC, a versão (2), BIN_SIZE (2), a capacidade dos racks (2), o máximo de BINs
+ * por rack (4, 0 sem limite) e a quantidade de racks (4). Cada rack traz o espaço
+ * restante (2) e a quantidade de BINs (4), seguidos dos seus BINs; cada BIN traz o
+ * espaço restante (2), a quantidade de itens (2) e os itens (2 cada).
+ *
+ * \param path Caminho do arquivo.
+ * \param bins Lista de BINs.
+ * \param rack_of Rack de cada BIN, -1 para BINs vazios.
+ * \param rack_left Espaço restante de cada rack.
+ * \param rack_bins Quantidade de BINs de cada rack.
+ * \param order BINs agrupados por rack, na ordem dos racks.
+ * \param racks Quantidade de racks.
+ * \return 0 caso tenha gravado, 1 em caso de erro.
+ */
+int write_racks (const char *path, const bin_list *bins, const unsigned int *rack_left, const unsigned int *rack_bins,
+                 const unsigned short int *order, unsigned int racks)
+{
+   FILE *file = fopen(path, "wb");
+   unsigned int r;
+   unsigned int k = 0;
+   int error;
+
+   if (file == NULL)
+   {
+      printf("Não foi possível criar o arquivo de racks %s.\n", path);
+      return 1;
+   }
+
+   error = fwrite(RACKS_MAGIC, 4, 1, file) != 1;
+   error |= write_le(file, RACKS_VERSION, 2);
+   error |= write_le(file, BIN_SIZE, 2);
+   error |= write_le(file, RACK_CAPACITY, 2);
+   error |= write_le(file, RACK_SLOTS, 4);
+   error |= write_le(file, racks, 4);
+
+   for (r = 0; r < racks; r++)
+   {
+      unsigned int end = k + rack_bins[r];
+
+      error |= write_le(file, rack_left[r], 2);
+      error |= write_le(file, rack_bins[r], 4);
+
+      for (; k < end; k++)
+      {
+         const bin *b = bins->itens + order[k];
+         unsigned short int i;
+
+         error |= write_le(file, b->left, 2);
+         error |= write_le(file, b->count, 2);
+
+         for (i = 0; i < b->count; i++)
+            error |= write_le(file, b->itens[i], 2);
+      }
+   }
+
+   error |= fclose(file) != 0;
+
+   if (error)
+      printf("Erro ao gravar o arquivo de racks %s.\n", path);
+
+   return error ? 1 : 0;
+}
+
+/**
+ * Empacota os BINs em racks (opção <tt>-H</tt>). Cada BIN é um item do tamanho do que foi
+ * ocupado; os BINs são ordenados de forma decrescente por sort_indices_desc e colocados
+ * pelo "First Fit" com um fit_index sobre o espaço restante dos racks. Um rack que atinge
+ * o máximo de BINs fica com espaço zero no índice, então não recebe mais nenhum. Com a
+ * co-otimização, rack_empty_last é repetida enquanto houver mais racks que o limite
+ * inferior. Imprime os BINs agrupados por rack e, com <tt>-w</tt>, grava os racks.
+ *
+ * \param bins Lista de BINs já preenchida.
+ * \return Zero após finalizado, 1 se algum BIN não cabe em um rack ou se a gravação falhou.
+ * \see rack_empty_last
+ * \see write_racks
+ */
+int run_racks (bin_list *bins)
+{
+   unsigned short int n = bins->count;
+   unsigned short int *load = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned short int *order = malloc(sizeof(unsigned short int)*(n + 1));
+   int *rack_of = malloc(sizeof(int)*(n + 1));
+   unsigned int *rack_left = malloc(sizeof(unsigned int)*(n + 1));
+   unsigned int *rack_bins = calloc((size_t) n + 1, sizeof(unsigned int));
+   unsigned int *start = calloc((size_t) n + 2, sizeof(unsigned int));
+   unsigned long int moved = 0;
+   unsigned long int total = 0;
+   unsigned int racks = 0;
+   unsigned int used = 0;
+   unsigned int bound = 0;
+   unsigned int r;
+   unsigned short int k;
+   fit_index idx;
+   int status = 0;
+
+   if (load == NULL || order == NULL || rack_of == NULL || rack_left == NULL || rack_bins == NULL || start == NULL)
+      exit(1);
+
+   for (k = 0; k < n; k++)
+   {
+      /** BINs sem itens ficam fora dos racks. */
+      load[k] = bins->itens[k].count > 0 ? BIN_SIZE - bins->itens[k].left : 0;
+      rack_of[k] = -1;
+   }
+
+   if (n > 0)
+      sort_indices_desc(load, n, order);
+
+   fit_index_build(&idx, NULL, 0, RACK_CAPACITY);
+
+   for (k = 0; k < n && status == 0; k++)
+   {
+      unsigned short int j = order[k];
+      int rack;
+
+      if (bins->itens[j].count == 0)
+         continue;
+
+      if (load[j] > RACK_CAPACITY)
+      {
+         printf("O BIN %d, com %d ocupados, não cabe em um rack de capacidade %d.\n", j, load[j], RACK_CAPACITY);
+         status = 1;
+         break;
+      }
+
+      rack = fit_index_first(&idx, load[j] > 0 ? load[j] : 1);
+
+      if (rack < 0)
+      {
+         rack = racks++;
+         rack_left[rack] = RACK_CAPACITY;
+      }
+
+      rack_of[j] = rack;
+      rack_left[rack] -= load[j];
+      rack_bins[rack]++;
+      fit_index_set(&idx, rack, RACK_SLOTS > 0 && rack_bins[rack] >= RACK_SLOTS ? 0 : rack_left[rack]);
+   }
+
+   fit_index_free_arrays(&idx);
+
+   /** Co-otimização: esvazia o último rack enquanto estiver acima do limite inferior. */
+   while (status == 0 && RACK_COOPTIMIZE && racks > 1)
+   {
+      for (k = 0, used = 0, total = 0; k < n; k++)
+      {
+         if (rack_of[k] >= 0)
+         {
+            used++;
+            total += BIN_SIZE - bins->itens[k].left;
+         }
+      }
+
+      bound = (total + RACK_CAPACITY - 1) / RACK_CAPACITY;
+
+      if (RACK_SLOTS > 0 && (used + RACK_SLOTS - 1) / RACK_SLOTS > bound)
+         bound = (used + RACK_SLOTS - 1) / RACK_SLOTS;
+
+      if (racks <= bound || !rack_empty_last(bins, rack_of, rack_left, rack_bins, racks, &moved))
+         break;
+
+      racks--;
+   }
+
+   if (status != 0)
+   {
+      free(load);
+      free(order);
+      free(rack_of);
+      free(rack_left);
+      free(rack_bins);
+      free(start);
+      return status;
+   }
+
+   /** Agrupa os BINs por rack, mantendo a ordem da lista dentro de cada rack. */
+   for (k = 0, used = 0, total = 0; k < n; k++)
+   {
+      if (rack_of[k] >= 0)
+      {
+         start[rack_of[k] + 1]++;
+         used++;
+         total += BIN_SIZE - bins->itens[k].left;
+      }
+   }
+
+   for (r = 0; r < racks; r++)
+      start[r + 1] += start[r];
+
+   for (k = 0; k < n; k++)
+      if (rack_of[k] >= 0)
+         order[start[rack_of[k]]++] = k;
+
+   for (r = racks; r > 0; r--)
+      start[r] = start[r - 1];
+
+   start[0] = 0;
+
+   for (r = 0; r < racks; r++)
+   {
+      unsigned int i;
+
+      printf(" [R%03u] Left: %5u | Bins: %4u\n", r, rack_left[r], rack_bins[r]);
+
+      for (i = start[r]; i < start[r + 1]; i++)
+      {
+         printf("    {%04d} ", order[i]);
+         print_bin(bins->itens + order[i]);
+      }
+   }
+
+   bound = (total + RACK_CAPACITY - 1) / RACK_CAPACITY;
+
+   if (RACK_SLOTS > 0 && (used + RACK_SLOTS - 1) / RACK_SLOTS > bound)
+      bound = (used + RACK_SLOTS - 1) / RACK_SLOTS;
+
+   printf("\n\nRacks: %u | Limite inferior: %u | BINs: %u | Movidos: %lu\n\n", racks, bound, used, moved);
+
+   if (RACK_OUTPUT != NULL)
+      status = write_racks(RACK_OUTPUT, bins, rack_left, rack_bins, order, racks);
+
+   free(load);
+   free(order);
+   free(rack_of);
+   free(rack_left);
+   free(rack_bins);
+   free(start);
+
+   return status;
+}
+#endif
+
+/**
+ * Recalcula os nós internos de uma árvore de máximos a partir das folhas. A folha
+ * \em leaves + j guarda o valor da posição j, e o nó k o maior valor entre 2k e 2k + 1.
+ * É a árvore usada pelo fit_index, pelo class_index e por bp_pack.
+ *
+ * \param tree Árvore, com 2 * \em leaves posições.
+ * \param leaves Quantidade de folhas, potência de dois.
+ * \return Zero após finalizado.
+ */
+static int max_tree_build (int *tree, size_t leaves)
+{
+   size_t k;
+
+   for (k = leaves - 1; k > 0; k--)
+      tree[k] = tree[2*k] > tree[2*k+1] ? tree[2*k] : tree[2*k+1];
+
+   return 0;
+}
+
+/**
+ * Primeira folha, da esquerda para a direita, com valor maior ou igual a \em s.
+ *
+ * \param tree Árvore de máximos.
+ * \param leaves Quantidade de folhas.
+ * \param s Valor mínimo.
+ * \return A posição da folha, ou \em leaves se nenhuma comporta \em s.
+ */
+static size_t max_tree_first (const int *tree, size_t leaves, int s)
+{
+   size_t node = 1;
+
+   if (tree[1] < s)
+      return leaves;
+
+   while (node < leaves)
+      node = tree[2*node] >= s ? 2*node : 2*node + 1;
+
+   return node - leaves;
+}
+
+/**
+ * Atribui um valor à folha \em j e atualiza os seus ancestrais.
+ *
+ * \param tree Árvore de máximos.
+ * \param leaves Quantidade de folhas.
+ * \param j Posição da folha.
+ * \param value Novo valor.
+ * \return Zero após finalizado.
+ */
+static int max_tree_set (int *tree, size_t leaves, size_t j, int value)
+{
+   size_t node = leaves + j;
+
+   tree[node] = value;
+
+   for (node /= 2; node > 0; node /= 2)
+      tree[node] = tree[2*node] > tree[2*node+1] ? tree[2*node] : tree[2*node+1];
+
+   return 0;
+}
+
+/**
+ * Alocação padrão da interface de biblioteca, usada quando nenhum bp_allocator é informado.
+ *
+ * \param size Bytes a serem alocados.
+ * \param alignment Alinhamento, sempre atendido pelo malloc para os tipos usados.
+ * \param context Não usado.
+ * \return A memória alocada, ou NULL.
+ */
+static void* bp_default_allocate (size_t size, size_t alignment, void *context)
+{
+   (void) alignment;
+   (void) context;
+   return malloc(size);
+}
+
+/**
+ * Liberação padrão da interface de biblioteca.
+ *
+ * \param pointer Memória a ser liberada.
+ * \param size Não usado.
+ * \param alignment Não usado.
+ * \param context Não usado.
+ */
+static void bp_default_deallocate (void *pointer, size_t size, size_t alignment, void *context)
+{
+   (void) size;
+   (void) alignment;
+   (void) context;
+   free(pointer);
+}
+
+/**
+ * Lê o item \em i de um array de inteiros de \em width bytes, com ou sem sinal.
+ *
+ * \param items Itens.
+ * \param i Posição do item.
+ * \param width Tamanho de cada item em bytes.
+ * \param is_signed Diferente de zero se os itens têm sinal.
+ * \param size Recebe o tamanho do item.
+ * \return Zero após finalizado, 1 se o item é negativo.
+ */
+static int bp_read_item (const void *items, size_t i, size_t width, int is_signed, unsigned long long int *size)
+{
+   long long int value;
+
+   switch (width)
+   {
+      case 1:
+         value = is_signed ? ((const int8_t *) items)[i] : (long long int) ((const uint8_t *) items)[i];
+         break;
+      case 2:
+         value = is_signed ? ((const int16_t *) items)[i] : (long long int) ((const uint16_t *) items)[i];
+         break;
+      case 4:
+         value = is_signed ? ((const int32_t *) items)[i] : (long long int) ((const uint32_t *) items)[i];
+         break;
+      default:
+         if (!is_signed)
+         {
+            *size = ((const uint64_t *) items)[i];
+            return 0;
+         }
+
+         value = ((const int64_t *) items)[i];
+         break;
+   }
+
+   *size = value;
+   return value < 0;
+}
+
+/**
+ * Empacota itens por "First Fit Decreasing" para a interface de biblioteca. Os itens são
+ * lidos no array do chamador, ordenados por contagem e colocados com a árvore de máximos
+ * de max_tree_first, a mesma do fit_index. Não passa por run_engine nem pelo fit_index
+ * porque eles usam as variáveis globais, o malloc e índices de 16 bits, enquanto aqui os
+ * itens podem passar de 65535 e toda memória, temporária ou do resultado, vem do
+ * \em allocator. Pelo mesmo motivo a ordenação por contagem é própria, com contadores
+ * size_t, em vez de sort_indices_desc. O resultado tem apenas dois arrays, sem
+ * alocações por BIN.
+ *
+ * \param items Itens, inteiros de \em width bytes, lidos sem cópia.
+ * \param count Quantidade de itens.
+ * \param width Tamanho de cada item em bytes: 1, 2, 4 ou 8.
+ * \param is_signed Diferente de zero se os itens são inteiros com sinal.
+ * \param capacity Capacidade dos BINs.
+ * \param allocator Alocador, ou NULL para malloc e free.
+ * \param result Recebe o resultado.
+ * \return BP_OK, ou um dos códigos de erro.
+ * \see bp_result_free
+ */
+int bp_pack (const void *items, size_t count, size_t width, int is_signed, uint16_t capacity,
+             const bp_allocator *allocator, bp_result *result)
+{
+   static const bp_allocator standard = { bp_default_allocate, bp_default_deallocate, NULL };
+   const bp_allocator *a = allocator != NULL ? allocator : &standard;
+   size_t *start = NULL;
+   uint32_t *order = NULL;
+   int *tree = NULL;
+   size_t leaves = 1;
+   size_t i;
+   unsigned long long int size;
+   int code = BP_OK;
+   int s;
+
+   memset(result, 0, sizeof(bp_result));
+   result->allocator = *a;
+   result->items = count;
+
+   if ((width != 1 && width != 2 && width != 4 && width != 8) || count > UINT32_MAX)
+      return BP_ERROR_INVALID_ITEM;
+
+   if (count == 0)
+      return BP_OK;
+
+   while (leaves < count)
+      leaves *= 2;
+
+   start = a->allocate(sizeof(size_t)*((size_t) capacity + 2), _Alignof(size_t), a->context);
+   order = a->allocate(sizeof(uint32_t)*count, _Alignof(uint32_t), a->context);
+   tree = a->allocate(sizeof(int)*2*leaves, _Alignof(int), a->context);
+   result->assignment = a->allocate(sizeof(uint32_t)*count, _Alignof(uint32_t), a->context);
+   result->residual = a->allocate(sizeof(uint16_t)*count, _Alignof(uint16_t), a->context);
+   result->residual_capacity = count;
+
+   if (start == NULL || order == NULL || tree == NULL || result->assignment == NULL || result->residual == NULL)
+   {
+      code = BP_ERROR_NO_MEMORY;
+      goto done;
+   }
+
+   /** Ordenação por contagem, dos maiores para os menores, que também valida os itens. */
+   memset(start, 0, sizeof(size_t)*((size_t) capacity + 2));
+
+   for (i = 0; i < count; i++)
+   {
+      if (bp_read_item(items, i, width, is_signed, &size) != 0)
+      {
+         code = BP_ERROR_INVALID_ITEM;
+         result->failed_item = i;
+         goto done;
+      }
+
+      if (size > capacity)
+      {
+         code = BP_ERROR_ITEM_TOO_LARGE;
+         result->failed_item = i;
+         goto done;
+      }
+
+      start[capacity - size + 1]++;
+   }
+
+   for (s = 0; s <= capacity; s++)
+      start[s + 1] += start[s];
+
+   for (i = 0; i < count; i++)
+   {
+      bp_read_item(items, i, width, is_signed, &size);
+      order[start[capacity - size]++] = i;
+   }
+
+   for (i = 0; i < leaves; i++)
+      tree[leaves + i] = -1;
+
+   max_tree_build(tree, leaves);
+
+   /** First Fit: o primeiro BIN com espaço vem da árvore de máximos, ou abre-se um novo. */
+   for (i = 0; i < count; i++)
+   {
+      size_t bin;
+
+      bp_read_item(items, order[i], width, is_signed, &size);
+      bin = max_tree_first(tree, leaves, (int) size);
+
+      if (bin == leaves)
+      {
+         bin = result->bins++;
+         result->residual[bin] = capacity;
+      }
+
+      result->residual[bin] -= size;
+      result->assignment[order[i]] = bin;
+      max_tree_set(tree, leaves, bin, result->residual[bin]);
+   }
+
+done:
+   if (start != NULL)
+      a->deallocate(start, sizeof(size_t)*((size_t) capacity + 2), _Alignof(size_t), a->context);
+   if (order != NULL)
+      a->deallocate(order, sizeof(uint32_t)*count, _Alignof(uint32_t), a->context);
+   if (tree != NULL)
+      a->deallocate(tree, sizeof(int)*2*leaves, _Alignof(int), a->context);
+
+   if (code != BP_OK)
+   {
+      size_t failed = result->failed_item;
+
+      bp_result_free(result);
+      result->failed_item = failed;
+   }
+
+   return code;
+}
+
+/**
+ * Libera os arrays do resultado da interface de biblioteca pelo alocador com que foram
+ * alocados, deixando o resultado zerado.
+ *
+ * \param result Resultado a ser liberado.
+ */
+void bp_result_free (bp_result *result)
+{
+   if (result->assignment != NULL)
+      result->allocator.deallocate(result->assignment, sizeof(uint32_t)*result->items, _Alignof(uint32_t),
+                                   result->allocator.context);
+   if (result->residual != NULL)
+      result->allocator.deallocate(result->residual, sizeof(uint16_t)*result->residual_capacity, _Alignof(uint16_t),
+                                   result->allocator.context);
+
+   memset(result, 0, sizeof(bp_result));
+}
@@ -0,0 +1,88 @@
+/**
+ * \file bin-packing.h
+ * \brief Interface de biblioteca do empacotamento.
+ *
+ * Permite usar o "First Fit Decreasing" sem passar pela linha de comando: os itens são
+ * lidos diretamente do array do chamador, como inteiros de 1, 2, 4 ou 8 bytes, sem cópia,
+ * e todas as alocações internas passam pelo bp_allocator informado. O resultado guarda o
+ * BIN de cada item e o espaço restante de cada BIN em dois arrays, sem alocações por BIN.
+ *
+ * Para usar como biblioteca, compile bin-packing.c com <tt>-DBIN_PACKING_NO_MAIN</tt>:
+ * <tt>gcc -O2 -c -DBIN_PACKING_NO_MAIN bin-packing.c</tt>. Em C++, veja bin-packing.hpp.
+ *
+ *  \author Rocha, Joel (joelxr@gmail.com)
+ *  \author Santos, Luciente dos (lucienesantosmc@gmail.com)
+ */
+#ifndef BIN_PACKING_H
+#define BIN_PACKING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Empacotamento concluído */
+#define BP_OK 0
+/** Algum item é maior que a capacidade dos BINs */
+#define BP_ERROR_ITEM_TOO_LARGE 1
+/** Algum item é negativo, ou a largura dos itens não é 1, 2, 4 ou 8 bytes, ou há itens demais */
+#define BP_ERROR_INVALID_ITEM 2
+/** O alocador não conseguiu alocar memória */
+#define BP_ERROR_NO_MEMORY 3
+
+/**
+ * Alocador usado em todas as alocações do empacotamento, inclusive as do resultado.
+ * \em allocate deve retornar NULL quando não consegue alocar.
+ */
+typedef struct bp_allocator
+{
+   void *(*allocate) (size_t size, size_t alignment, void *context); /** Aloca \em size bytes alinhados */
+   void (*deallocate) (void *pointer, size_t size, size_t alignment, void *context); /** Libera o que foi alocado */
+   void *context; /** Repassado para \em allocate e \em deallocate */
+} bp_allocator;
+
+/**
+ * Resultado do empacotamento. Deve ser liberado com bp_result_free, que usa o mesmo
+ * alocador das alocações.
+ */
+typedef struct bp_result
+{
+   uint32_t *assignment; /** BIN de cada item, na ordem da entrada */
+   uint16_t *residual; /** Espaço restante de cada BIN */
+   size_t items; /** Quantidade de itens */
+   size_t bins; /** Quantidade de BINs */
+   size_t residual_capacity; /** Posições alocadas em \em residual */
+   size_t failed_item; /** Em caso de erro, o item que o causou */
+   bp_allocator allocator; /** Alocador usado */
+} bp_result;
+
+/**
+ * Empacota os itens por "First Fit Decreasing".
+ *
+ * \param items Itens, inteiros de \em width bytes, lidos sem cópia.
+ * \param count Quantidade de itens.
+ * \param width Tamanho de cada item em bytes: 1, 2, 4 ou 8.
+ * \param is_signed Diferente de zero se os itens são inteiros com sinal.
+ * \param capacity Capacidade dos BINs.
+ * \param allocator Alocador, ou NULL para malloc e free.
+ * \param result Recebe o resultado; em caso de erro fica sem arrays, com \em failed_item.
+ * \return BP_OK, ou um dos códigos de erro.
+ */
+int bp_pack (const void *items, size_t count, size_t width, int is_signed, uint16_t capacity,
+             const bp_allocator *allocator, bp_result *result);
+
+/**
+ * Libera os arrays do resultado pelo alocador com que foram alocados. Pode ser chamada
+ * com um resultado zerado ou já liberado.
+ *
+ * \param result Resultado a ser liberado.
+ */
+void bp_result_free (bp_result *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * \file bin-packing.hpp
+ * \brief Interface C++ do empacotamento, sobre bin-packing.h.
+ *
+ * Os itens são recebidos como <tt>std::span<const T></tt>, para qualquer inteiro T de 1,
+ * 2, 4 ou 8 bytes, e lidos sem cópia. Todas as alocações passam pelo
+ * <tt>std::pmr::memory_resource</tt> informado, que deve viver mais que o resultado. O
+ * resultado só pode ser movido, e libera os seus arrays no mesmo recurso.
+ *
+ * Exemplo:
+ * \code
+ *    std::pmr::monotonic_buffer_resource arena;
+ *    std::vector<int> items = { 70, 60, 50, 40 };
+ *    bin_packing::result r = bin_packing::pack(items, 100, &arena);
+ *    for (std::uint32_t bin : r.assignment()) ...
+ * \endcode
+ *
+ * Requer C++20; o programa deve ser ligado a bin-packing.c compilado com
+ * <tt>-DBIN_PACKING_NO_MAIN</tt>.
+ */
+#ifndef BIN_PACKING_HPP
+#define BIN_PACKING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "bin-packing.h"
+
+namespace bin_packing
+{
+
+namespace detail
+{
+
+/** Aloca pelo memory_resource; exceções não podem atravessar o código C. */
+inline void *allocate (std::size_t size, std::size_t alignment, void *context) noexcept
+{
+   try
+   {
+      return static_cast<std::pmr::memory_resource *>(context)->allocate(size, alignment);
+   }
+   catch (...)
+   {
+      return nullptr;
+   }
+}
+
+/** Libera pelo memory_resource. */
+inline void deallocate (void *pointer, std::size_t size, std::size_t alignment, void *context) noexcept
+{
+   static_cast<std::pmr::memory_resource *>(context)->deallocate(pointer, size, alignment);
+}
+
+}
+
+class result;
+
+template <typename T>
+result pack (std::span<const T> items, std::uint16_t capacity,
+             std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+/**
+ * Resultado do empacotamento: o BIN de cada item e o espaço restante de cada BIN. Só
+ * pode ser movido; os arrays pertencem ao memory_resource usado em pack.
+ */
+class result
+{
+public:
+   result () noexcept : raw_() {}
+
+   result (const result &) = delete;
+   result &operator= (const result &) = delete;
+
+   result (result &&other) noexcept : raw_(other.raw_)
+   {
+      other.raw_ = bp_result();
+   }
+
+   result &operator= (result &&other) noexcept
+   {
+      if (this != &other)
+      {
+         bp_result_free(&raw_);
+         raw_ = other.raw_;
+         other.raw_ = bp_result();
+      }
+
+      return *this;
+   }
+
+   ~result ()
+   {
+      bp_result_free(&raw_);
+   }
+
+   /** BIN de cada item, na ordem da entrada. */
+   std::span<const std::uint32_t> assignment () const noexcept
+   {
+      return { raw_.assignment, raw_.items };
+   }
+
+   /** Espaço restante de cada BIN. */
+   std::span<const std::uint16_t> residual () const noexcept
+   {
+      return { raw_.residual, raw_.bins };
+   }
+
+   /** Quantidade de BINs. */
+   std::size_t bins () const noexcept
+   {
+      return raw_.bins;
+   }
+
+private:
+   template <typename T>
+   friend result pack (std::span<const T> items, std::uint16_t capacity, std::pmr::memory_resource *resource);
+
+   bp_result raw_;
+};
+
+/**
+ * Empacota os itens por "First Fit Decreasing".
+ *
+ * \param items Itens, lidos sem cópia.
+ * \param capacity Capacidade dos BINs.
+ * \param resource Recurso de todas as alocações, inclusive as do resultado.
+ * \return O resultado.
+ * \throws std::invalid_argument se algum item é negativo ou maior que a capacidade.
+ * \throws std::bad_alloc se o recurso não conseguiu alocar.
+ */
+template <typename T>
+result pack (std::span<const T> items, std::uint16_t capacity, std::pmr::memory_resource *resource)
+{
+   static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "os itens devem ser inteiros");
+   static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+                 "os itens devem ter 1, 2, 4 ou 8 bytes");
+
+   const bp_allocator allocator = { &detail::allocate, &detail::deallocate, resource };
+   result packed;
+   int code = bp_pack(items.data(), items.size(), sizeof(T), std::is_signed_v<T>, capacity, &allocator,
+                      &packed.raw_);
+
+   switch (code)
+   {
+      case BP_OK:
+         return packed;
+      case BP_ERROR_NO_MEMORY:
+         throw std::bad_alloc();
+      case BP_ERROR_ITEM_TOO_LARGE:
+         throw std::invalid_argument("o item " + std::to_string(packed.raw_.failed_item) + " não cabe no BIN");
+      default:
+         throw std::invalid_argument("o item " + std::to_string(packed.raw_.failed_item) + " é inválido");
+   }
+}
+
+/**
+ * Empacota os itens de qualquer container contíguo de inteiros, como std::vector ou
+ * std::array, sem cópia.
+ */
+template <std::ranges::contiguous_range R>
+result pack (const R &items, std::uint16_t capacity,
+             std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+{
+   return pack(std::span<const std::ranges::range_value_t<R>>(std::ranges::data(items), std::ranges::size(items)),
+               capacity, resource);
+}
+
+}
+
+#endif
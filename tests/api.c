@@ -0,0 +1,193 @@
+/**
+ * \file api.c
+ * \brief Testes da interface de biblioteca em C (bin-packing.h).
+ *
+ * Compara bp_pack com um "First Fit Decreasing" direto, confere os códigos de erro e que
+ * toda memória passa pelo alocador informado e é devolvida. Compilado e executado por
+ * run-tests.sh, ligado a bin-packing.c compilado com <tt>-DBIN_PACKING_NO_MAIN</tt>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bin-packing.h"
+
+/** Alocador que conta as alocações e falha a partir da alocação \em fail_at, se positiva */
+typedef struct counting
+{
+   size_t live; /** Bytes alocados e ainda não liberados */
+   unsigned int calls; /** Quantidade de alocações */
+   unsigned int fail_at; /** Alocação que deve falhar, começando em 1, ou zero */
+} counting;
+
+static int FAILED = 0;
+
+#define CHECK(condition)                                                                  \
+   do                                                                                     \
+   {                                                                                      \
+      if (!(condition))                                                                   \
+      {                                                                                   \
+         printf("FALHOU: %s:%d: %s\n", __FILE__, __LINE__, #condition);                   \
+         FAILED++;                                                                        \
+      }                                                                                   \
+   } while (0)
+
+static void* counting_allocate (size_t size, size_t alignment, void *context)
+{
+   counting *c = context;
+
+   (void) alignment;
+
+   if (c->fail_at > 0 && ++c->calls >= c->fail_at)
+      return NULL;
+
+   c->live += size;
+   return malloc(size);
+}
+
+static void counting_deallocate (void *pointer, size_t size, size_t alignment, void *context)
+{
+   counting *c = context;
+
+   (void) alignment;
+
+   c->live -= size;
+   free(pointer);
+}
+
+/**
+ * "First Fit Decreasing" de referência, quadrático: ordena os índices de forma estável
+ * pelo tamanho decrescente e coloca cada item no primeiro BIN com espaço.
+ */
+static size_t reference_ffd (const unsigned short int *items, size_t n, unsigned short int capacity,
+                             unsigned int *assignment)
+{
+   size_t *order = malloc(sizeof(size_t)*(n + 1));
+   unsigned int *left = malloc(sizeof(unsigned int)*(n + 1));
+   size_t bins = 0;
+   size_t i;
+   size_t j;
+
+   for (i = 0; i < n; i++)
+      order[i] = i;
+
+   for (i = 1; i < n; i++)
+      for (j = i; j > 0 && items[order[j - 1]] < items[order[j]]; j--)
+      {
+         size_t aux = order[j];
+         order[j] = order[j - 1];
+         order[j - 1] = aux;
+      }
+
+   for (i = 0; i < n; i++)
+   {
+      unsigned short int size = items[order[i]];
+
+      for (j = 0; j < bins && left[j] < size; j++)
+         ;
+
+      if (j == bins)
+         left[bins++] = capacity;
+
+      left[j] -= size;
+      assignment[order[i]] = j;
+   }
+
+   free(order);
+   free(left);
+   return bins;
+}
+
+/**
+ * Empacota itens aleatórios e confere contra a referência: mesma quantidade de BINs,
+ * mesmo BIN para cada item e espaço restante coerente com os itens de cada BIN.
+ */
+static void test_random (unsigned int seed, size_t n, unsigned short int capacity)
+{
+   unsigned short int *items = malloc(sizeof(unsigned short int)*(n + 1));
+   unsigned int *expected = malloc(sizeof(unsigned int)*(n + 1));
+   unsigned long int *load;
+   counting c = { 0, 0, 0 };
+   bp_allocator allocator = { counting_allocate, counting_deallocate, &c };
+   bp_result result;
+   size_t bins;
+   size_t i;
+
+   srand(seed);
+
+   for (i = 0; i < n; i++)
+      items[i] = rand() % (capacity + 1);
+
+   bins = reference_ffd(items, n, capacity, expected);
+
+   CHECK(bp_pack(items, n, sizeof(unsigned short int), 0, capacity, &allocator, &result) == BP_OK);
+   CHECK(result.bins == bins);
+
+   load = calloc(bins + 1, sizeof(unsigned long int));
+
+   for (i = 0; i < n && result.bins == bins; i++)
+   {
+      CHECK(result.assignment[i] == expected[i]);
+      load[result.assignment[i]] += items[i];
+   }
+
+   for (i = 0; i < bins && result.bins == bins; i++)
+      CHECK(load[i] + result.residual[i] == capacity);
+
+   bp_result_free(&result);
+   CHECK(c.live == 0);
+
+   free(load);
+   free(items);
+   free(expected);
+}
+
+int main ()
+{
+   const signed char negative[] = { 10, -1, 3 };
+   const uint64_t large[] = { 10, 200 };
+   const int32_t ints[] = { 70, 60, 50, 40, 30, 20, 10, 5 };
+   counting c = { 0, 0, 0 };
+   bp_allocator allocator = { counting_allocate, counting_deallocate, &c };
+   bp_result result;
+   unsigned int fail;
+
+   test_random(1, 10, 10);
+   test_random(2, 1000, 100);
+   test_random(3, 5000, 65535);
+   test_random(4, 3000, 1);
+
+   /** Itens com sinal, de 4 bytes, com o alocador padrão. */
+   CHECK(bp_pack(ints, 8, sizeof(int32_t), 1, 100, NULL, &result) == BP_OK);
+   CHECK(result.bins == 3 && result.assignment[0] == 0 && result.assignment[7] == 2);
+   bp_result_free(&result);
+   bp_result_free(&result);
+
+   CHECK(bp_pack(negative, 3, 1, 1, 100, &allocator, &result) == BP_ERROR_INVALID_ITEM);
+   CHECK(result.failed_item == 1 && result.assignment == NULL);
+
+   CHECK(bp_pack(large, 2, 8, 0, 100, &allocator, &result) == BP_ERROR_ITEM_TOO_LARGE);
+   CHECK(result.failed_item == 1 && result.assignment == NULL);
+
+   CHECK(bp_pack(ints, 8, 3, 0, 100, &allocator, &result) == BP_ERROR_INVALID_ITEM);
+
+   CHECK(bp_pack(ints, 0, sizeof(int32_t), 1, 100, &allocator, &result) == BP_OK);
+   CHECK(result.bins == 0);
+   bp_result_free(&result);
+   CHECK(c.live == 0);
+
+   /** Cada uma das alocações falhando: o erro é informado e nada fica alocado. */
+   for (fail = 1; fail <= 5; fail++)
+   {
+      c.calls = 0;
+      c.fail_at = fail;
+      CHECK(bp_pack(ints, 8, sizeof(int32_t), 1, 100, &allocator, &result) == BP_ERROR_NO_MEMORY);
+      CHECK(result.assignment == NULL && result.residual == NULL);
+      CHECK(c.live == 0);
+   }
+
+   if (FAILED > 0)
+      return 1;
+
+   printf("api.c: ok\n");
+   return 0;
+}
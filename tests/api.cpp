@@ -0,0 +1,151 @@
+/**
+ * \file api.cpp
+ * \brief Testes da interface de biblioteca em C++ (bin-packing.hpp).
+ *
+ * Confere std::span e containers contíguos como entrada, o resultado que só pode ser
+ * movido, as exceções de cada código de erro e que toda memória passa pelo
+ * std::pmr::memory_resource informado e é devolvida. Compilado e executado por
+ * run-tests.sh, com <tt>-std=c++20</tt>.
+ */
+#include <array>
+#include <cstdio>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "bin-packing.hpp"
+
+namespace
+{
+
+int failed = 0;
+
+#define CHECK(condition)                                                                  \
+   do                                                                                     \
+   {                                                                                      \
+      if (!(condition))                                                                   \
+      {                                                                                   \
+         std::printf("FALHOU: %s:%d: %s\n", __FILE__, __LINE__, #condition);              \
+         failed++;                                                                        \
+      }                                                                                   \
+   } while (0)
+
+/** Recurso que conta os bytes ainda alocados e pode recusar todas as alocações. */
+class counting : public std::pmr::memory_resource
+{
+public:
+   std::size_t live = 0;
+   bool refuse = false;
+
+private:
+   void *do_allocate (std::size_t size, std::size_t alignment) override
+   {
+      if (refuse)
+         throw std::bad_alloc();
+
+      live += size;
+      return std::pmr::new_delete_resource()->allocate(size, alignment);
+   }
+
+   void do_deallocate (void *pointer, std::size_t size, std::size_t alignment) override
+   {
+      live -= size;
+      std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+   }
+
+   bool do_is_equal (const std::pmr::memory_resource &other) const noexcept override
+   {
+      return this == &other;
+   }
+};
+
+}
+
+int main ()
+{
+   static_assert(!std::is_copy_constructible_v<bin_packing::result>);
+   static_assert(std::is_nothrow_move_constructible_v<bin_packing::result>);
+
+   counting resource;
+
+   {
+      const std::vector<int> items = { 70, 60, 50, 40, 30, 20, 10, 5 };
+      bin_packing::result packed = bin_packing::pack(items, 100, &resource);
+
+      CHECK(packed.bins() == 3);
+      CHECK(packed.assignment().size() == items.size());
+      CHECK(packed.residual()[0] == 0 && packed.residual()[1] == 0 && packed.residual()[2] == 15);
+
+      bin_packing::result moved = std::move(packed);
+      CHECK(packed.bins() == 0 && moved.bins() == 3);
+
+      bin_packing::result other;
+      other = std::move(moved);
+      CHECK(other.bins() == 3 && moved.bins() == 0);
+   }
+
+   CHECK(resource.live == 0);
+
+   try
+   {
+      const std::array<short, 3> negative = { 10, -1, 3 };
+      bin_packing::pack(negative, 100, &resource);
+      CHECK(!"item negativo aceito");
+   }
+   catch (const std::invalid_argument &)
+   {
+   }
+
+   try
+   {
+      const std::vector<std::uint64_t> large = { 10, 200 };
+      bin_packing::pack(std::span<const std::uint64_t>(large), 100, &resource);
+      CHECK(!"item maior que o BIN aceito");
+   }
+   catch (const std::invalid_argument &)
+   {
+   }
+
+   try
+   {
+      const std::vector<std::uint8_t> items = { 1, 2, 3 };
+      resource.refuse = true;
+      bin_packing::pack(items, 10, &resource);
+      CHECK(!"alocação recusada ignorada");
+   }
+   catch (const std::bad_alloc &)
+   {
+   }
+
+   resource.refuse = false;
+   CHECK(resource.live == 0);
+
+   /** Muitos itens, mais que os 65535 da linha de comando, com um recurso monotônico. */
+   {
+      std::pmr::monotonic_buffer_resource arena;
+      std::mt19937 generator(1);
+      std::vector<std::uint16_t> many(200000);
+
+      for (std::uint16_t &item : many)
+         item = generator() % 1000 + 1;
+
+      bin_packing::result packed = bin_packing::pack(many, 1000, &arena);
+      std::vector<long> load(packed.bins());
+
+      for (std::size_t i = 0; i < many.size(); i++)
+         load[packed.assignment()[i]] += many[i];
+
+      for (std::size_t b = 0; b < packed.bins(); b++)
+         CHECK(load[b] + packed.residual()[b] == 1000);
+   }
+
+   CHECK(bin_packing::pack(std::vector<unsigned char>(), 10).bins() == 0);
+
+   if (failed > 0)
+      return 1;
+
+   std::printf("api.cpp: ok\n");
+   return 0;
+}
@@ -0,0 +1,809 @@
+#!/bin/sh
+#
+# Testes de regressão do bin-packing. Compila src/bin-packing.c com $CC (gcc por padrão)
+# e confere, na saída de cada modo, que nenhum BIN passa da capacidade e que todos os
+# itens da entrada aparecem exatamente uma vez.
+#
+# Também compila bin-packing.c como biblioteca e executa os testes da interface em C
+# (api.c) e, se $CXX (g++ por padrão) existir, em C++ (api.cpp).
+#
+# Uso: sh tests/run-tests.sh
+#      CFLAGS="-g -fsanitize=address,undefined" sh tests/run-tests.sh
+#
+
+set -u
+
+CC=${CC:-gcc}
+CXX=${CXX:-g++}
+CFLAGS=${CFLAGS:--O2}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+WORK=$(mktemp -d)
+BIN="$WORK/bin-packing"
+FAILED=0
+PASSED=0
+
+trap 'rm -rf "$WORK"' EXIT
+
+fail ()
+{
+   echo "FALHOU: $*"
+   FAILED=$((FAILED + 1))
+}
+
+pass ()
+{
+   PASSED=$((PASSED + 1))
+}
+
+#
+# Confere os BINs impressos em $WORK/out: a soma dos itens mais o espaço restante de
+# cada BIN é a capacidade, e os itens são os mesmos da entrada. Sem a lista de itens,
+# usa os números impressos pelo próprio programa; com "*", não confere os itens. Com
+# "subset", basta que os itens dos BINs façam parte da entrada (modos que podem deixar
+# itens de fora).
+#
+# check_bins capacidade "itens" [subset]
+#
+check_bins ()
+{
+   awk -v cap="$1" -v items="$2" -v subset="${3:-}" '
+      BEGIN { n = split(items, v, " "); for (i = 1; i <= n; i++) { split(v[i], f, ":"); want[f[1] + 0]++ } }
+      /^Numbers:/ { numbers = (n == 0) ; next }
+      /^Total:/ { numbers = 0 }
+      numbers { for (i = 1; i <= NF; i++) want[$i + 0]++ }
+      /\{[0-9]+\} .*Left:/ {
+         line = $0; sub(/.*Left: */, "", line); left = line + 0
+         line = $0; sub(/.*Itens: */, "", line); k = line == "" ? 0 : split(line, it, ", *")
+         sum = 0
+         for (i = 1; i <= k; i++) { s = it[i] + 0; sum += s; got[s]++ }
+         if (sum + left != cap || left < 0) { print "BIN inválido: " $0; bad = 1 }
+      }
+      END {
+         if (items == "*")
+            exit bad
+         for (s in got)
+            if (got[s] > want[s] + 0) { print "item " s " sobrando: " got[s] " de " want[s] + 0; bad = 1 }
+         if (subset == "")
+            for (s in want)
+               if (got[s] + 0 != want[s]) { print "item " s " faltando: " got[s] + 0 " de " want[s]; bad = 1 }
+         exit bad
+      }' "$WORK/out"
+}
+
+#
+# Confere que a última execução imprimiu uma linha com o padrão informado.
+#
+# check_output padrão descrição
+#
+check_output ()
+{
+   if grep -q -- "$1" "$WORK/out"; then
+      pass
+   else
+      fail "$2: a saída não contém \"$1\""
+   fi
+}
+
+#
+# Executa o programa com os argumentos informados, guardando a saída em $WORK/out, e
+# confere o código de saída.
+#
+# run codigo_esperado argumentos...
+#
+run ()
+{
+   expected=$1
+   shift
+   "$BIN" "$@" > "$WORK/out" 2>&1 < /dev/null
+   status=$?
+
+   if [ "$status" -ne "$expected" ]; then
+      fail "bin-packing $* terminou com $status, esperado $expected"
+      return 1
+   fi
+
+   return 0
+}
+
+#
+# Empacota e confere os BINs.
+#
+# check_mode capacidade "itens" argumentos...
+#
+check_mode ()
+{
+   cap=$1
+   items=$2
+   shift 2
+
+   if run 0 "$@" && check_bins "$cap" "$items"; then
+      pass
+   else
+      fail "bin-packing $*"
+   fi
+}
+
+"$CC" $CFLAGS -Wall -Wextra "$ROOT/src/bin-packing.c" -o "$BIN" -lm -lpthread || exit 1
+
+#
+# Varredura de capacidades (-S): para cada capacidade, a quantidade de BINs é a mesma do
+# empacotamento comum com essa capacidade, e capacidades fora de 1..65535 são recusadas.
+#
+# check_sweep lista itens...
+#
+check_sweep ()
+{
+   list=$1
+   shift
+
+   run 0 -S "$list" -j 3 0 1 0 0 "$@" || return
+   awk '/^ *[0-9]+ +[0-9-]+ +[0-9-]+$/ { print $1, $2 }' "$WORK/out" > "$WORK/sweep"
+
+   if [ ! -s "$WORK/sweep" ]; then
+      fail "-S $list não imprimiu a tabela"
+      return
+   fi
+
+   while read -r capacity bins; do
+      # Capacidade menor que o maior item: inviável.
+      [ "$bins" = "-" ] && continue
+
+      if run 0 0 "$capacity" 0 0 "$@" && [ "$(grep -c '{[0-9]*} Left:' "$WORK/out")" -eq "$bins" ]; then
+         pass
+      else
+         fail "-S $list: $bins BINs com capacidade $capacity"
+      fi
+   done < "$WORK/sweep"
+}
+
+check_sweep 90:130:10 60 50 40 70 30 20 90 10
+check_sweep 40,100,65535 60 50 40 70 30 20 90 10
+check_sweep 7:11:2 5 5 4 4 3 3 3 2 2 1
+run 1 -S 90,70000 0 100 0 0 10 && pass
+run 1 -S 0:10:1 0 100 0 0 10 && pass
+run 1 -S 100,x 0 100 0 0 10 && pass
+
+#
+# BINs aposentados (-r): cada BIN é impresso quando deixa de aceitar o menor item, em
+# outra ordem, mas os BINs são os mesmos do modo padrão.
+#
+for args in "0 100 0 0 60 50 40 70 30 20 90 10 5" "3000 100 1 100" "2000 1000 300 700" "500 10 0 10"; do
+   run 0 $args && grep '{[0-9]*} Left:' "$WORK/out" | sort > "$WORK/list"
+
+   if run 0 -r $args && check_bins "$(echo $args | cut -d' ' -f2)" "" &&
+      grep '{[0-9]*} Left:' "$WORK/out" | sort | cmp -s - "$WORK/list"; then
+      pass
+   else
+      fail "-r $args difere do modo padrão"
+   fi
+done
+
+#
+# Versão especializada (-DBIN_SIZE_FIXED=N): com o BIN_SIZE igual a N e com outro
+# BIN_SIZE, os BINs são os mesmos da versão genérica. N até 255 usa um byte por BIN.
+#
+for fixed in 100 1000; do
+   "$CC" $CFLAGS -Wall -Wextra -DBIN_SIZE_FIXED=$fixed "$ROOT/src/bin-packing.c" -o "$WORK/fixed" -lm -lpthread || exit 1
+
+   for args in "3000 $fixed 1 $fixed" "500 $fixed 0 3" "2000 700 1 700" "0 $fixed 0 0 $fixed 1 $fixed 0"; do
+      run 0 $args && grep '{[0-9]*} Left:' "$WORK/out" > "$WORK/list"
+      generic=$BIN
+      BIN="$WORK/fixed"
+
+      if run 0 $args && check_bins "$(echo $args | cut -d' ' -f2)" "" &&
+         grep '{[0-9]*} Left:' "$WORK/out" | cmp -s - "$WORK/list"; then
+         pass
+      else
+         fail "-DBIN_SIZE_FIXED=$fixed $args difere da versão genérica"
+      fi
+
+      BIN=$generic
+   done
+done
+
+#
+# Modo em lote (-b): cada instância tem os mesmos BINs do modo padrão, inclusive depois
+# de instâncias maiores e menores que reaproveitam a área de trabalho, e linhas com
+# valores fora de 0..65535 ou que não são números são informadas com o número da linha.
+#
+printf '100 60 50 40 70 30 20 90 10\n10 5 5 4 4 3 3 3 2 2\n\n1000 %s\n7 1 2 3\n' \
+   "$(awk 'BEGIN { for (i = 1; i <= 3000; i++) printf "%d ", (i * 7919) % 1000 + 1 }')" > "$WORK/batch"
+"$BIN" -b < "$WORK/batch" > "$WORK/batch.out" 2>&1
+instance=0
+
+while read -r capacity items; do
+   [ -z "$capacity" ] && continue
+   instance=$((instance + 1))
+   run 0 0 "$capacity" 0 0 $items && grep '{[0-9]*} Left:' "$WORK/out" > "$WORK/list"
+   awk -v id="$(printf 'Instance %04d:' $instance)" '
+      index($0, "Instance ") == 1 { inside = (index($0, id) == 1); next }
+      inside && /\{[0-9]+\} Left:/' "$WORK/batch.out" > "$WORK/batch.bins"
+
+   if [ -s "$WORK/list" ] && cmp -s "$WORK/list" "$WORK/batch.bins"; then
+      pass
+   else
+      fail "-b: instância $instance difere do modo padrão"
+   fi
+done < "$WORK/batch"
+
+printf '10 70000 3\n10 5 x\n70000 1\n10 -1\n10 5 5\n' | "$BIN" -b > "$WORK/out" 2>&1
+check_output "Instance 0001: valor inválido na linha 1: 70000" "-b com item acima de 65535"
+check_output "Instance 0002: valor inválido na linha 2: x" "-b com item que não é número"
+check_output "Instance 0003: valor inválido na linha 3: 70000" "-b com BIN_SIZE acima de 65535"
+check_output "Instance 0004: valor inválido na linha 4: -1" "-b com item negativo"
+check_output "Instance 0005: 2 itens, BIN_SIZE 10, 1 BINs" "-b continua depois de linhas inválidas"
+
+#
+# Itens fracionáveis (-f): cada BIN fecha com as partes somando BIN_SIZE menos o Left,
+# as partes de cada item somam o seu tamanho, os tamanhos são os itens informados e a
+# quantidade de BINs é ceil(soma / BIN_SIZE). Tamanhos da entrada padrão acima de
+# 65535 são rejeitados.
+#
+# check_split capacidade "itens"
+#
+check_split ()
+{
+   result=$(awk -v cap="$1" -v items="$2" '
+      / Fragments: / {
+         line = $0
+         sub(/.*Fragments: /, "", line)
+         left = line
+         sub(/.*Left: /, "", left)
+         sub(/ \| Left:.*/, "", line)
+         n = split(line, parts, ", ")
+         used = 0
+
+         for (k = 1; k <= n; k++)
+         {
+            split(parts[k], kv, "=")
+            id = substr(kv[1], 2)
+
+            if (split(kv[2], frac, "/") == 2)
+            {
+               piece = frac[1]
+               size[id] = frac[2]
+            }
+            else
+            {
+               piece = kv[2]
+               size[id] = kv[2]
+            }
+
+            placed[id] += piece
+            used += piece
+         }
+
+         if (used + left != cap)
+            bad = bad " BIN com " used " + " left
+         bins++
+      }
+      /^Bins: / { reported = $2 }
+      END {
+         total = 0
+         n = split(items, expected, " ")
+
+         for (k = 1; k <= n; k++)
+         {
+            want[expected[k]]++
+            total += expected[k]
+         }
+
+         for (id in size)
+         {
+            if (placed[id] != size[id])
+               bad = bad " item " id " com " placed[id] "/" size[id]
+            want[size[id]]--
+         }
+
+         for (s in want)
+            if (want[s] != 0)
+               bad = bad " tamanho " s
+
+         lower = int((total + cap - 1) / cap)
+
+         if (total > 0 && bins != lower)
+            bad = bad " " bins " BINs para " lower
+         if (bins != reported)
+            bad = bad " Bins: " reported
+
+         print bad == "" ? "ok" : bad
+      }' "$WORK/out")
+
+   [ "$result" = "ok" ] && pass || fail "-f com BIN_SIZE $1 e itens $2:$result"
+}
+
+run 0 -f 0 10 0 0 7 7 7 3 0 5 && check_split 10 "7 7 7 3 0 5"
+run 0 -f 0 100 0 0 99 98 97 50 50 3 2 1 && check_split 100 "99 98 97 50 50 3 2 1"
+items=$(awk 'BEGIN { for (i = 1; i <= 500; i++) printf "%d ", (i * 7919) % 997 + 1 }')
+echo "$items" | "$BIN" -f 0 1000 1 1 - > "$WORK/out" 2>&1 && check_split 1000 "$items"
+echo "70000 5" | "$BIN" -f 0 10 1 1 - > "$WORK/out" 2>&1
+
+if [ $? -eq 1 ]; then
+   check_output "passa de 65535" "-f com tamanho acima de 65535 na entrada"
+else
+   fail "-f aceitou tamanho acima de 65535 na entrada"
+fi
+
+#
+# Múltiplas partidas (-M): os BINs são válidos, nunca mais que os do FFD, e o resultado
+# depende apenas da semente, não da quantidade de threads.
+#
+for args in "50 -s 5 0 50 0 0 2 15 2 25 24 5 28 20 22 7" "1000 -s 3 300 1000 1 700" "100 -s 9 500 100 20 60"; do
+   cap=${args%% *}
+   args=${args#* }
+   check_mode "$cap" "" -M 200 -j 1 $args && cp "$WORK/out" "$WORK/single"
+   run 0 -M 200 -j 4 $args
+
+   if cmp -s "$WORK/out" "$WORK/single"; then
+      pass
+   else
+      fail "-M com $args depende da quantidade de threads"
+   fi
+
+   awk '/^Multi-start:/ { exit !($(NF - 3) <= $NF) }' "$WORK/out" && pass || fail "-M com $args pior que o FFD"
+done
+
+run 1 -M 10 0 10 0 0 5 20 3 && pass
+
+#
+# Consultas (-q): respostas conferidas à mão, os BINs continuam válidos depois das
+# inserções e, com -r, nenhum BIN é aposentado, então 'i' nunca usa um BIN liberado.
+#
+printf 'f\nc 5\nr 0 10\nw 5\ni 3\ni 10\ni 11\ni 1\nx\n' > "$WORK/queries"
+
+for retire in "" -r; do
+   "$BIN" -q $retire 0 10 0 0 9 8 7 5 3 2 < "$WORK/queries" > "$WORK/out" 2>&1
+   answers=$(awk 'NF == 1 && !/:/ { printf " %s", $1 }' "$WORK/out")
+
+   if [ "$answers" = " 5 1 6 3 3 4 -1 0 ?" ] && check_bins 10 "9 8 7 5 3 2"; then
+      pass
+   else
+      fail "-q $retire respondeu:$answers"
+   fi
+
+   cp "$WORK/out" "$WORK/queries$retire.out"
+done
+
+cmp -s "$WORK/queries.out" "$WORK/queries-r.out" && pass || fail "-q com -r aposentou BINs"
+
+#
+# Nivelamento (-l): os itens são conservados, a quantidade de BINs não muda e a
+# diferença entre o maior e o menor espaço restante nunca aumenta.
+#
+spread ()
+{
+   awk '/\{[0-9]+\} .*Left:/ {
+           line = $0; sub(/.*Left: */, "", line); left = line + 0; bins++
+           if (bins == 1 || left > most) most = left
+           if (bins == 1 || left < least) least = left
+        }
+        END { print bins, most - least }' "$WORK/out"
+}
+
+for args in "100 -s 2 40 100 10 70" "1000 -s 7 300 1000 1 600" "10 0 10 0 0 9 8 7 5 3 2 1 1"; do
+   cap=${args%% *}
+   args=${args#* }
+   run 0 $args && before=$(spread)
+   check_mode "$cap" "" -l 100 $args
+   after=$(spread)
+
+   if [ "${before% *}" -eq "${after% *}" ] && [ "${after#* }" -le "${before#* }" ]; then
+      pass
+   else
+      fail "-l com $args: BINs e diferença $before viraram $after"
+   fi
+done
+
+#
+# Empacotamento concorrente (-c): com qualquer quantidade de threads os itens são
+# conservados, nenhum BIN passa da capacidade, e um item maior que o BIN é um erro.
+#
+for threads in 1 2 8; do
+   check_mode 1000 "" -c -j $threads -s 4 2000 1000 1 700
+   check_output "Inconsistent bins: 0 " "-c -j $threads sem BINs inconsistentes"
+done
+
+check_mode 10 "5 5 3 2 7 1 0 10" -c -j 3 0 10 0 0 5 5 3 2 7 1 0 10
+run 1 -c 0 10 1 1 5 20 3 && pass
+
+#
+# Captura (-T) e reprodução (-R) de trace: a saída libera espaço que volta a ser usado,
+# itens maiores que o BIN e saídas desconhecidas são rejeitados, e valores que não
+# cabem nos 16 bits do formato impedem a gravação do trace.
+#
+printf 'c 10\na 1 6\na 2 5\na 3 4\nd 1\na 4 6 10\nd 9\na 5 11\n' | "$BIN" -T "$WORK/trace" > "$WORK/out" 2>&1
+check_output "BIN_SIZE 10, 7 events" "-T grava os eventos"
+run 0 -R "$WORK/trace"
+check_output "7 events, 2 rejected" "-R rejeita item grande e saída desconhecida"
+check_output "Bins opened: 2 | Bins in use: 2 (peak 2) | Live itens: 3" "-R reaproveita o espaço liberado"
+
+for events in 'c 10\na 1 70000\n' 'c 70000\na 1 5\n'; do
+   printf "$events" | "$BIN" -T "$WORK/large" > "$WORK/out" 2>&1
+
+   if [ $? -eq 1 ] && [ ! -e "$WORK/large" ]; then
+      check_output "passa de 65535" "-T com valor acima de 65535"
+   else
+      fail "-T aceitou valor acima de 65535"
+   fi
+done
+
+#
+# Semi-online (-o): com qualquer janela os itens são conservados; com a janela do
+# tamanho da entrada os BINs têm o espaço restante e a quantidade de itens do FFD
+# (os itens de cada BIN ficam na ordem de chegada); um item maior que o BIN é um erro
+# quando os itens são argumentos e é apenas rejeitado quando vêm da entrada padrão.
+#
+for window in 1 3 50; do
+   check_mode 1000 "" -o $window -s 3 300 1000 1 700
+done
+
+run 0 -s 3 300 1000 1 700 && grep '{[0-9]*} Left:' "$WORK/out" | sed 's/ | Itens:.*//' > "$WORK/ffd"
+check_mode 1000 "" -o 300 -s 3 300 1000 1 700
+grep '{[0-9]*} Left:' "$WORK/out" | sed 's/ | Itens:.*//' | cmp -s - "$WORK/ffd" && pass || fail "-o com janela completa difere do FFD"
+
+run 1 -o 2 0 10 1 1 5 20 3 && pass
+echo "5 5 3 2 7 1 20" | "$BIN" -o 3 0 10 1 1 - > "$WORK/out" 2>&1
+check_output "Itens: 6 | Flushes: 2 | Bins: 3 | Lower bound: 3 | Rejected: 1" "-o lendo da entrada padrão"
+
+#
+# Prazo (-D): com um prazo de 1 ms, os modos que melhoram uma solução param cedo e ainda
+# entregam BINs válidos, nunca piores que o ponto de partida.
+#
+check_mode 1000 "" -D 1 -M 1000000 -s 3 3000 1000 1 700
+check_output "Deadline reached: [0-9]* of 1000000 starts run" "-D interrompe -M"
+awk '/^Multi-start:/ { exit !($(NF - 3) <= $NF) }' "$WORK/out" && pass || fail "-D com -M pior que o FFD"
+
+run 0 -s 3 3000 1000 1 700 && bins=$(grep -c '{[0-9]*} Left:' "$WORK/out")
+check_mode 1000 "" -D 1 -l 100000000 -s 3 3000 1000 1 700
+[ "$(grep -c '{[0-9]*} Left:' "$WORK/out")" -eq "$bins" ] && pass || fail "-D com -l mudou a quantidade de BINs"
+
+check_mode 1000 "" -D 1 -a 0.05 2000 1000 150 600
+check_mode 1000 "" -D 1 -X 60 1000 200 500
+check_output "Exact: Bins: [0-9]* | FFD: 23 |" "-D com -X entrega a melhor solução conhecida"
+
+#
+# Classes de BIN ('@') e grupos de afinidade ('+'): os itens são conservados, cada item
+# restrito fica em um BIN de uma classe permitida, os itens de um grupo ficam juntos,
+# um item maior que o BIN é um erro e os modos que não tratam '+' e '@' os recusam.
+#
+check_mode 50 "30 25 20 15 12 7 4 9 3 2 1" 0 50 0 0 30@1 25@0,2 20 15@2 12@1 7 4+9 3+2+1@2
+
+if awk -v allowed="30:1 25:0,2 15:2 12:1 3:2 2:2 1:2" -v groups="4,9 3,2,1" '
+      BEGIN {
+         n = split(allowed, a, " ")
+         for (i = 1; i <= n; i++) { split(a[i], f, ":"); classes[f[1]] = "," f[2] "," }
+      }
+      /\{[0-9]+\} <classe [0-9]+>/ {
+         line = $0; sub(/.*<classe /, "", line); class = line + 0
+         line = $0; sub(/.*Itens: */, "", line); k = split(line, it, ", *")
+         for (i = 1; i <= k; i++)
+         {
+            s = it[i] + 0; bin[s] = NR
+            if (s in classes && index(classes[s], "," class ",") == 0) { print "item " s " na classe " class; bad = 1 }
+         }
+      }
+      END {
+         n = split(groups, g, " ")
+         for (i = 1; i <= n; i++)
+         {
+            k = split(g[i], members, ",")
+            for (j = 2; j <= k; j++)
+               if (bin[members[j]] != bin[members[1]]) { print "grupo " g[i] " separado"; bad = 1 }
+         }
+         exit bad
+      }' "$WORK/out"; then
+   pass
+else
+   fail "'@' ou '+' fora das classes ou dos grupos"
+fi
+
+run 1 0 10 1 1 5 20@0 3 && pass
+run 1 0 10 1 1 5 12+3 3 && pass
+
+for mode in "-S 10,20" "-f" "-c" "-o 2" "-M 5" "-X" "-p" "-m" "-a 0.2" "-l 5" "-H 20" "-q"; do
+   run 1 $mode 0 10 1 1 5 2+3 3@1 && check_output "não podem ser usados" "'+' e '@' com $mode"
+done
+
+#
+# Ordenação por radix (sort_records_desc): os números saem em ordem decrescente, sem
+# perder nenhum, inclusive no limite de 65535 números, e com -p a ordenação é estável,
+# ou seja, números iguais mantêm a ordem das suas posições na entrada.
+#
+check_mode 65535 "" 65535 65535 0 65535
+awk '/^Numbers:/ { numbers = 1; next }
+     /^Total:/ { numbers = 0 }
+     numbers { for (i = 1; i <= NF; i++) { if (seen && $i > last) bad = 1; last = $i; seen = 1 } }
+     END { exit bad }' "$WORK/out" && pass || fail "Numbers fora de ordem decrescente"
+
+run 0 -p 0 10 0 0 5 3 5 7 3
+check_output "Itens:    5#0,    5#2" "-p mantém a ordem dos iguais"
+check_output "Assignment: 1 0 1 0 2" "-p com as posições da entrada"
+
+items=$(awk 'BEGIN { for (i = 0; i < 3000; i++) printf "%d ", (i * 7919) % 13 * 50 + 50 }')
+run 0 -p 0 1000 0 0 $items
+
+if awk -v items="$items" '
+      BEGIN { n = split(items, v, " ") }
+      /\{[0-9]+\} .*Itens:/ {
+         line = $0; sub(/.*Itens: */, "", line); k = split(line, it, ", *")
+         for (i = 1; i <= k; i++)
+         {
+            split(it[i], f, "#"); size = f[1] + 0; position = f[2] + 0
+            if (v[position + 1] != size || position in placed) bad = 1
+            if (size == previous_size && position < previous_position) bad = 1
+            placed[position] = 1; count++; previous_size = size; previous_position = position
+         }
+      }
+      END { exit bad || count != n }' "$WORK/out"; then
+   pass
+else
+   fail "-p com posições trocadas ou fora de ordem"
+fi
+
+# APTAS (-a): a entrada com apenas itens grandes e iguais não pode ficar sem BIN.
+check_mode 100 "25 25" -a 0.2 0 100 0 0 25 25
+check_output "1 classes, 1 patterns" "padrão maximal limitado pela quantidade de itens"
+check_mode 100 "60 50 40 35 30 25 20 15 10 5" -a 0.3 0 100 0 0 60 50 40 35 30 25 20 15 10 5
+check_mode 1000 "" -a 0.2 -s 7 400 1000 1 1000
+check_mode 100 "" -a 0.1 300 100 20 60
+check_mode 1000 "" -a 0.15 -s 3 400 1000 100 600
+run 1 -a 0.2 0 10 1 1 5 20 3 && pass
+
+#
+# Busca exata (-X): instâncias pequenas em que o FFD usa um BIN a mais que o ótimo, e
+# outras em que o ótimo fica acima do limite inferior, conferidas por força bruta.
+#
+# check_exact ótimo capacidade itens...
+#
+check_exact ()
+{
+   optimum=$1
+   cap=$2
+   shift 2
+
+   check_mode "$cap" "$*" -X 0 "$cap" 0 0 "$@"
+   check_output "Exact: Bins: $optimum |.*| optimal" "-X com ótimo $optimum"
+}
+
+check_exact 3 50 2 15 2 25 24 5 28 20 22 7
+check_exact 3 20 8 3 7 5 18 6 3 8
+check_exact 2 50 42 4 35 5 10 2 2
+check_exact 4 100 64 22 38 40 100 26 44 31 25
+check_exact 4 100 9 11 96 12 76 17 18 54 38 35 9 18
+check_exact 5 20 13 1 3 6 6 7 10 7 20 16 3 8
+check_exact 9 50 9 8 20 20 42 37 14 39 46 43 21 19 47
+check_exact 7 100 33 45 99 20 14 75 13 52 20 22 70 11 81 40
+check_exact 11 100 77 49 28 98 78 97 96 33 99 40 47 89 81
+
+# A busca paralela (-j) precisa chegar ao mesmo ótimo.
+check_mode 20 "13 1 3 6 6 7 10 7 20 16 3 8" -j 4 -X 0 20 0 0 13 1 3 6 6 7 10 7 20 16 3 8
+check_output "Exact: Bins: 5 |.*| optimal" "-X -j 4 com ótimo 5"
+run 1 -X 0 10 1 1 5 20 3 && pass
+
+#
+# Modo estocástico (-g): cada BIN tem média e variância iguais às somas dos seus itens e
+# probabilidade de transbordar até o limite, e os itens media:variancia são os da entrada.
+# Com itens gerados, confere apenas a quantidade.
+#
+# check_stochastic probabilidade quantidade "itens" argumentos...
+#
+check_stochastic ()
+{
+   limit=$1
+   quantity=$2
+   items=$3
+   shift 3
+
+   if run 0 -g "$limit" "$@" && awk -v limit="$limit" -v quantity="$quantity" -v items="$items" '
+      BEGIN { n = split(items, v, " "); for (i = 1; i <= n; i++) want[v[i]]++ }
+      /\{[0-9]+\} Mean:/ {
+         line = $0; sub(/.*Mean: */, "", line); mean = line + 0
+         line = $0; sub(/.*Var: */, "", line); var = line + 0
+         line = $0; sub(/.*P\(overflow\): */, "", line); p = line + 0
+         line = $0; sub(/.*Count: */, "", line); count = line + 0
+         line = $0; sub(/.*Itens: */, "", line); k = split(line, it, ", *")
+         sm = 0; sv = 0
+         for (i = 1; i <= k; i++) { split(it[i], f, ":"); sm += f[1]; sv += f[2]; got[it[i]]++ }
+         total += k
+         if (k != count || sm != mean || sv - var > 0.05 || var - sv > 0.05 || p > limit + 1e-6) {
+            print "BIN inválido: " $0; bad = 1
+         }
+      }
+      END {
+         if (total != quantity) { print total " itens nos BINs, esperado " quantity; bad = 1 }
+         for (s in want)
+            if (got[s] + 0 != want[s]) { print "item " s ": " got[s] + 0 " de " want[s]; bad = 1 }
+         exit bad
+      }' "$WORK/out"; then
+      pass
+   else
+      fail "bin-packing -g $limit $*"
+   fi
+}
+
+check_stochastic 0.05 5 "30:4 20:9 50:25 10:1 40:16" 0 100 0 0 30:4 20:9 50:25 10:1 40:16
+check_stochastic 0.01 8 "30:4 20:9 50:25 10:1 40:16 5:0 95:0 45:100" 0 100 0 0 30:4 20:9 50:25 10:1 40:16 5:0 95:0 45:100
+check_stochastic 0.1 200 "" 200 100 1 50
+check_stochastic 0.001 500 "" 500 1000 1 300
+run 1 -g 0.05 0 100 0 0 10:1 99:400 && check_output "não cabe sozinho" "-g com item que não cabe sozinho"
+
+for variance in nan inf -inf NAN 1e400 -1; do
+   run 1 -g 0.05 0 100 0 0 10:1 30:$variance && check_output "Item estocástico inválido" "-g com variância $variance"
+done
+
+#
+# Mochila múltipla (-K N): os BINs aceitos não passam da capacidade e os itens colocados
+# fazem parte da entrada, são exatamente N BINs e a quantidade de itens colocados é a do
+# resumo. Instâncias pequenas conferem também o valor ótimo.
+#
+# check_knapsack BINs capacidade "itens" argumentos...
+#
+check_knapsack ()
+{
+   nbins=$1
+   cap=$2
+   items=$3
+   shift 3
+
+   if run 0 -K "$nbins" "$@" && check_bins "$cap" "$items" subset && awk -v nbins="$nbins" '
+      /\{[0-9]+\} Value:/ { bins++; line = $0; sub(/.*Count: */, "", line); placed += line + 0 }
+      /^Knapsack:/ { line = $0; sub(/.*Itens: */, "", line); summary = line + 0 }
+      END {
+         if (bins != nbins || placed != summary) { print bins " BINs e " placed " itens, resumo com " summary; exit 1 }
+      }' "$WORK/out"; then
+      pass
+   else
+      fail "bin-packing -K $nbins $*"
+   fi
+}
+
+check_knapsack 2 10 "5 4 6 3 2" 0 10 0 0 5:10 4:7 6:12 3:3 2:5
+check_output "Itens: 5 de 5 | Value: 37 " "-K 2 coloca todos os itens"
+check_knapsack 1 10 "5 4 6 3 2" 0 10 0 0 5:10 4:7 6:12 3:3 2:5
+check_output "Value: 19 " "-K 1 com ótimo 19"
+check_knapsack 2 100 "120 50" 0 100 0 0 120:5 50:3
+check_knapsack 3 100 "*" 400 100 1 60
+check_knapsack 8 1000 "*" 2000 1000 1 400
+
+#
+# Racks (-H): além dos BINs, cada rack tem o espaço restante igual à capacidade menos a
+# carga dos seus BINs, não passa da quantidade de posições e o resumo tem a quantidade
+# de racks e de BINs impressos.
+#
+# check_racks capacidade_rack posições capacidade "itens" argumentos...
+#
+check_racks ()
+{
+   rack_cap=$1
+   slots=$2
+   cap=$3
+   items=$4
+   shift 4
+
+   if run 0 "$@" && check_bins "$cap" "$items" && awk -v rack_cap="$rack_cap" -v slots="$slots" -v cap="$cap" '
+      function close_rack () {
+         if (racks > 0 && (rack_cap - load != rack_left || rack_left < 0 || count != rack_bins || (slots > 0 && count > slots))) {
+            print "rack inválido: " header; bad = 1
+         }
+      }
+      /\[R[0-9]+\] Left:/ {
+         close_rack()
+         header = $0; racks++; load = 0; count = 0
+         line = $0; sub(/.*Left: */, "", line); rack_left = line + 0
+         line = $0; sub(/.*Bins: */, "", line); rack_bins = line + 0
+      }
+      /\{[0-9]+\} Left:/ { line = $0; sub(/.*Left: */, "", line); load += cap - line; count++; bins++ }
+      /^Racks:/ {
+         line = $0; sub(/^Racks: */, "", line); summary_racks = line + 0
+         line = $0; sub(/.*BINs: */, "", line); summary_bins = line + 0
+      }
+      END {
+         close_rack()
+         if (racks != summary_racks || bins != summary_bins) { print "resumo não confere"; bad = 1 }
+         exit bad
+      }' "$WORK/out"; then
+      pass
+   else
+      fail "bin-packing $*"
+   fi
+}
+
+check_racks 300 0 100 "60 50 40 70 30 20 90 10" -H 300 0 100 0 0 60 50 40 70 30 20 90 10
+check_racks 300 2 100 "60 50 40 70 30 20 90 10" -H 300,2 0 100 0 0 60 50 40 70 30 20 90 10
+check_racks 250 3 100 "60 50 40 70 30 20 90 10 55 45" -H 250,3,c 0 100 0 0 60 50 40 70 30 20 90 10 55 45
+check_racks 1000 4 100 "" -H 1000,4,c 500 100 1 100
+check_racks 5000 0 1000 "" -H 5000 800 1000 100 900
+
+if run 0 -H 1000,4 -w "$WORK/racks.bin" 500 100 1 100 && [ -s "$WORK/racks.bin" ]; then
+   pass
+else
+   fail "-H -w não gravou o arquivo de racks"
+fi
+
+# Grupos de afinidade: os itens de um grupo ficam juntos, e um grupo maior que o BIN é erro.
+check_mode 100 "30 20 50 10 10 10 70" 0 100 0 0 30+20 50 10+10+10 70
+check_output "Itens:   30,   20,   50" "grupo 30+20 no mesmo BIN"
+if run 1 0 100 0 0 60+50 10; then pass; fi
+
+# Tamanhos fracionários (-x): arredondados na escala, e acima de 65535 na escala é erro.
+check_mode 150 "37 50 25" -x 100 0 1.5 0 0 0.37 0.5 0.25
+check_mode 1000 "124 1000 2" -x 1000 0 1 0 0 0.1234 0.9999 0.002
+if run 1 -x 100 0 700 0 0 1; then pass; fi
+if run 1 -x 100 0 10 0 0 1 655.36; then pass; fi
+if run 1 -x 1 0 99999999999999999999999 0 0 1; then pass; fi
+
+#
+# Motores do FFD (-E): todos chegam exatamente aos mesmos BINs do motor linear.
+#
+for args in "3000 100 1 100" "20000 1000 1 700" "5000 60000 20000 60000" "2000 50 0 5"; do
+   run 0 -E linear $args && grep '{[0-9]*} Left:' "$WORK/out" > "$WORK/linear"
+
+   for engine in block tree histogram bucket auto; do
+      if run 0 -E "$engine" $args && check_bins "$(echo $args | cut -d' ' -f2)" "" &&
+         grep '{[0-9]*} Left:' "$WORK/out" | cmp -s - "$WORK/linear"; then
+         pass
+      else
+         fail "-E $engine $args difere do motor linear"
+      fi
+   done
+done
+
+#
+# Armazenamento compacto (-m): os BINs lidos do pool são os mesmos do modo padrão, para
+# larguras de 1 a 16 bits.
+#
+for args in "3000 100 1 100" "20000 1000 1 700" "500 1 0 1" "30000 65535 1 65535" "40 127 0 127" "5 10 0 0 0 0 0 0 0"; do
+   run 0 $args && grep '{[0-9]*} Left:' "$WORK/out" > "$WORK/list"
+
+   if run 0 -m $args && grep '{[0-9]*} Left:' "$WORK/out" | cmp -s - "$WORK/list"; then
+      pass
+   else
+      fail "-m $args difere do modo padrão"
+   fi
+done
+
+# A calibração (-C) não precisa dos argumentos e grava o custo de todos os motores.
+BIN_PACKING_CONFIG="$WORK/engines.conf"
+export BIN_PACKING_CONFIG
+
+if run 0 -C &&
+   [ "$(grep -c '^[a-z]* [0-9.e+-]*$' "$WORK/engines.conf")" -eq 5 ] && grep -q '^bucket ' "$WORK/engines.conf"; then
+   pass
+else
+   fail "-C não gravou o custo dos cinco motores"
+fi
+
+unset BIN_PACKING_CONFIG
+
+#
+# Interface de biblioteca: com -DBIN_PACKING_NO_MAIN o objeto exporta apenas as funções
+# de bin-packing.h, e os testes em C e C++ são ligados a ele.
+#
+"$CC" $CFLAGS -Wall -Wextra -DBIN_PACKING_NO_MAIN -c "$ROOT/src/bin-packing.c" -o "$WORK/bin-packing.o" || exit 1
+
+exported=$(nm -g --defined-only "$WORK/bin-packing.o" 2>/dev/null | awk '{ print $3 }' | grep -v '^bp_pack$\|^bp_result_free$')
+
+if [ -z "$exported" ]; then
+   pass
+else
+   fail "a biblioteca exporta símbolos internos: $(echo $exported)"
+fi
+
+if "$CC" $CFLAGS -Wall -Wextra -I"$ROOT/src" "$ROOT/tests/api.c" "$WORK/bin-packing.o" -o "$WORK/api" -lm -lpthread &&
+   "$WORK/api"; then
+   pass
+else
+   fail "tests/api.c"
+fi
+
+if command -v "$CXX" > /dev/null 2>&1; then
+   if "$CXX" -std=c++20 $CFLAGS -Wall -Wextra -I"$ROOT/src" "$ROOT/tests/api.cpp" "$WORK/bin-packing.o" \
+         -o "$WORK/api-cpp" -lm -lpthread && "$WORK/api-cpp"; then
+      pass
+   else
+      fail "tests/api.cpp"
+   fi
+fi
+
+echo "$PASSED testes passaram, $FAILED falharam."
+[ "$FAILED" -eq 0 ]